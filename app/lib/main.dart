@@ -5,6 +5,11 @@ import 'package:flutter_blue_plus/flutter_blue_plus.dart';
 import 'package:permission_handler/permission_handler.dart';
 import 'dart:async';
 import 'dart:io' show Platform;
+import 'dart:typed_data';
+import 'session_download.dart';
+import 'telemetry.dart';
+import 'test_result.dart';
+import 'waveform.dart';
 
 void main() async {
   // Ensure Flutter is initialized
@@ -140,6 +145,16 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
   BluetoothCharacteristic? testCharacteristic;
   BluetoothCharacteristic? numberCharacteristic;
   BluetoothCharacteristic? testResultCharacteristic;
+  BluetoothCharacteristic? telemetryCharacteristic;
+  int? lastTelemetrySeq;
+  int missedTelemetryPackets = 0;
+  BluetoothCharacteristic? waveformCharacteristic;
+  bool streamingWaveform = false;
+  final WaveformReceiver waveform = WaveformReceiver();
+  BluetoothCharacteristic? transferCharacteristic;
+  // kept across connections so an interrupted download resumes
+  final SessionDownload download = SessionDownload();
+  List<StoredSession> storedSessions = [];
   bool ledState = false;
   int receivedNumber = 0;
 
@@ -163,6 +178,9 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
   final String characteristicUuid = "19B10001-E8F2-537E-4F6C-D104768A1214";
   final String numberCharacteristicUuid = "19B10002-E8F2-537E-4F6C-D104768A1214";
   final String resultCharacteristicUuid = "19B10003-E8F2-537E-4F6C-D104768A1214";
+  final String telemetryCharacteristicUuid = "19B10004-E8F2-537E-4F6C-D104768A1214";
+  final String waveformCharacteristicUuid = "19B10005-E8F2-537E-4F6C-D104768A1214";
+  final String transferCharacteristicUuid = "19B10006-E8F2-537E-4F6C-D104768A1214";
 
   @override
   void initState() {
@@ -233,14 +251,23 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
     );
   }
 
-  void showScorePopup(BuildContext context, int score) {
+  void showScorePopup(BuildContext context, TestResult result) {
     showDialog(
       context: context,
       builder: (context) => AlertDialog(
         title: Text("BPM"),
-        content: Text(
-          "$score",
-          style: TextStyle(fontSize: 24, fontWeight: FontWeight.bold),
+        content: Column(
+          mainAxisSize: MainAxisSize.min,
+          children: [
+            Text(
+              result.meanBpm.toStringAsFixed(0),
+              style: TextStyle(fontSize: 24, fontWeight: FontWeight.bold),
+            ),
+            Text('${result.compressions} compressions in ${result.durationS} s'),
+            Text('Middle 80%: ${result.p10Bpm.toStringAsFixed(0)}-${result.p90Bpm.toStringAsFixed(0)} BPM'),
+            Text('In target range ${result.inBandPct}% of the time'),
+            Text('Accuracy ${result.accuracyPct}% | Consistency ${result.consistencyPct}%'),
+          ],
         ),
         actions: [
           TextButton(
@@ -251,6 +278,85 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
       ),
     );
   }
+  void addRecentNumber(double bpm) {
+    if (recentNumbers.length >= 5) {
+      recentNumbers.removeAt(0);
+    }
+    recentNumbers.add(bpm);
+  }
+
+  void onTelemetry(List<int> value) {
+    final packet = decodeTelemetry(value);
+    if (packet == null) return;
+    if (lastTelemetrySeq != null) {
+      final gap = (packet.seq - lastTelemetrySeq! - 1) & 0xFFFF;
+      if (gap != 0) {
+        missedTelemetryPackets += gap;
+        print('Telemetry: missed $gap packet(s)');
+      }
+    }
+    setState(() {
+      lastTelemetrySeq = packet.seq;
+      for (final record in packet.records) {
+        if (record.bpm > 0) {
+          addRecentNumber(record.bpm);
+        }
+      }
+    });
+  }
+
+  // the device streams every load-cell sample while we are subscribed
+  Future<void> setWaveformStreaming(bool on) async {
+    final characteristic = waveformCharacteristic;
+    if (characteristic == null) return;
+    try {
+      await characteristic.setNotifyValue(on);
+      setState(() {
+        streamingWaveform = on;
+        if (on) waveform.reset();
+      });
+    } catch (e) {
+      print('Error switching waveform stream: $e');
+    }
+  }
+
+  // pull every session stored on the device; resumes a download cut short
+  Future<void> downloadSessions() async {
+    final characteristic = transferCharacteristic;
+    if (characteristic == null) return;
+    try {
+      final mtu = connectedDevice?.mtuNow ?? 23;
+      await characteristic.write(download.start(mtu));
+      setState(() {});
+    } catch (e) {
+      print('Error starting download: $e');
+    }
+  }
+
+  void onTransfer(List<int> value) {
+    final reply = download.add(value);
+    final characteristic = transferCharacteristic;
+    if (reply != null && characteristic != null) {
+      characteristic.write(reply, withoutResponse: true).catchError((e) {
+        print('Error acknowledging download: $e');
+      });
+    }
+    if (download.done || download.error != null) {
+      setState(() {
+        storedSessions = download.sessions();
+      });
+      final message = download.error != null
+          ? 'Download failed (error ${download.error})'
+          : '${storedSessions.length} sessions downloaded';
+      ScaffoldMessenger.of(context).showSnackBar(SnackBar(content: Text(message)));
+      if (download.done) {
+        print('Download: ${download.total} bytes, ${download.naks} gaps');
+      }
+    } else if (value.isNotEmpty && value[0] == bulkData) {
+      setState(() {});
+    }
+  }
+
   void monitorConnectionState(BluetoothDevice device) {
     device.connectionState.listen((BluetoothConnectionState state) {
       setState((){
@@ -411,22 +517,56 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
               if (characteristic.properties.notify) {
                 await characteristic.setNotifyValue(true);
                 characteristic.lastValueStream.listen((value) {
-                  if (value.isNotEmpty) {
-                    int received = value[0] |
-                        (value[1] << 8) |
-                        (value[2] << 16) |
-                        (value[3] << 24);
+                  if (value.length >= 4) {
+                    int received = ByteData.sublistView(Uint8List.fromList(value)).getInt32(0, Endian.little);
                     print('Received number: $received');
                     setState(() {
                       receivedNumber = received;
-                      if (recentNumbers.length >= 5) {
-                        recentNumbers.removeAt(0);
+                      // with telemetry the graph is fed per compression instead
+                      if (telemetryCharacteristic == null) {
+                        addRecentNumber(received.toDouble());
                       }
-                      recentNumbers.add(received.toDouble());
                     });
                   }
                 });
               }
+            } if (characteristic.uuid.toString().toLowerCase() == telemetryCharacteristicUuid.toLowerCase()) {
+              print('Found telemetry characteristic: $telemetryCharacteristicUuid');
+              if (characteristic.properties.notify) {
+                // bigger MTU = more compression records per notification
+                int mtu = device.mtuNow;
+                if (Platform.isAndroid) {
+                  mtu = await device.requestMtu(247);
+                }
+                await characteristic.write(encodeMtu(mtu));
+                await characteristic.setNotifyValue(true);
+                setState(() {
+                  telemetryCharacteristic = characteristic;
+                  lastTelemetrySeq = null;
+                });
+                characteristic.lastValueStream.listen(onTelemetry);
+              }
+            } if (characteristic.uuid.toString().toLowerCase() == waveformCharacteristicUuid.toLowerCase()) {
+              print('Found waveform characteristic: $waveformCharacteristicUuid');
+              // subscribed only while the force curve is switched on
+              characteristic.lastValueStream.listen((value) {
+                if (streamingWaveform && waveform.add(value)) {
+                  setState(() {});
+                }
+              });
+              setState(() {
+                waveformCharacteristic = characteristic;
+                streamingWaveform = false;
+              });
+            } if (characteristic.uuid.toString().toLowerCase() == transferCharacteristicUuid.toLowerCase()) {
+              print('Found transfer characteristic: $transferCharacteristicUuid');
+              if (characteristic.properties.notify) {
+                await characteristic.setNotifyValue(true);
+                characteristic.lastValueStream.listen(onTransfer);
+                setState(() {
+                  transferCharacteristic = characteristic;
+                });
+              }
             } if (characteristic.uuid.toString().toLowerCase() == resultCharacteristicUuid.toLowerCase()){
               setState(() {
                 testResultCharacteristic = characteristic;
@@ -435,8 +575,9 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
               if (characteristic.properties.notify){
                 await characteristic.setNotifyValue(true);
                 characteristic.lastValueStream.listen((value) {
-                  if (value.isNotEmpty) {
-                    showScorePopup(context, value[0]);
+                  final result = decodeTestResult(value);
+                  if (result != null && result.compressions > 0) {
+                    showScorePopup(context, result);
                   }
                 });
               }
@@ -458,6 +599,11 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
           setState(() {
             connectedDevice = null;
             testCharacteristic = null;
+            telemetryCharacteristic = null;
+            waveformCharacteristic = null;
+            streamingWaveform = false;
+            transferCharacteristic = null;
+            download.running = false;
             ledState = false;
           });
           print('Device disconnected: ${device.platformName}');
@@ -777,7 +923,65 @@ class _InputGraphWidgetState extends State<InputGraphWidget> with SingleTickerPr
               ),
             ),
           ),
-          SizedBox(height: 80),
+          SizedBox(height: 10),
+
+          // Force curve streaming
+          SwitchListTile(
+            title: Text('Force curve'),
+            subtitle: streamingWaveform
+                ? Text('${waveform.frames} frames, ${waveform.lostFrames} lost')
+                : null,
+            value: streamingWaveform,
+            onChanged: waveformCharacteristic == null ? null : setWaveformStreaming,
+          ),
+          if (streamingWaveform)
+            SizedBox(
+              height: 120,
+              child: LineChart(
+                LineChartData(
+                  minY: 0,
+                  lineBarsData: [
+                    LineChartBarData(
+                      spots: [
+                        for (int i = 0; i < waveform.samples.length; i++)
+                          FlSpot(i.toDouble(), waveform.samples[i] / 1000.0),
+                      ],
+                      isCurved: false,
+                      dotData: FlDotData(show: false),
+                      color: Colors.redAccent,
+                      barWidth: 1.5,
+                    ),
+                  ],
+                  titlesData: FlTitlesData(
+                    bottomTitles: AxisTitles(sideTitles: SideTitles(showTitles: false)),
+                    topTitles: AxisTitles(sideTitles: SideTitles(showTitles: false)),
+                    rightTitles: AxisTitles(sideTitles: SideTitles(showTitles: false)),
+                    leftTitles: AxisTitles(
+                      axisNameWidget: Text('kg', style: TextStyle(fontWeight: FontWeight.bold)),
+                      sideTitles: SideTitles(showTitles: true, reservedSize: 40),
+                    ),
+                  ),
+                  borderData: FlBorderData(show: true),
+                  gridData: FlGridData(show: false),
+                ),
+              ),
+            ),
+          SizedBox(height: 10),
+
+          // Sessions stored on the device
+          ListTile(
+            title: Text('Stored sessions'),
+            subtitle: download.running
+                ? LinearProgressIndicator(value: download.progress)
+                : Text(storedSessions.isEmpty
+                    ? 'Not downloaded'
+                    : '${storedSessions.length} sessions, last ${storedSessions.last.avgBpm.toStringAsFixed(1)} BPM'),
+            trailing: ElevatedButton(
+              onPressed: transferCharacteristic == null || download.running ? null : downloadSessions,
+              child: Text(download.received > 0 && !download.done ? 'Resume' : 'Download'),
+            ),
+          ),
+          SizedBox(height: 10),
 
           // Bluetooth Scan Button
           ElevatedButton(
@@ -0,0 +1,191 @@
+import 'dart:typed_data';
+
+// Bulk download of the device's session log (19B10006), see bulk_transfer.h.
+// Commands we write, little-endian:
+//   START 0x01 | u16 mtu | u8 window | u32 logId | u32 offset
+//   ACK   0x02 | u32 offset        NAK 0x04 | u32 offset        STOP 0x03
+// Notifications we get:
+//   INFO 0x10 | u32 logId | u32 offset | u32 total | u8 window
+//   DATA 0x11 | u32 offset | bytes     DONE 0x12 | u32 total     ERROR 0x13 | u8 reason
+// The reassembled stream is the log's records as u8 type | u8 len | payload.
+
+const int bulkCmdStart = 0x01;
+const int bulkCmdAck = 0x02;
+const int bulkCmdStop = 0x03;
+const int bulkCmdNak = 0x04;
+const int bulkInfo = 0x10;
+const int bulkData = 0x11;
+const int bulkDone = 0x12;
+const int bulkError = 0x13;
+const int bulkDataHeader = 5;
+
+// session log record types
+const int logSessionStart = 1;
+const int logCompressions = 2;
+const int logSessionEnd = 3;
+const int logEndAborted = 1;
+
+List<int> _u32(int v) => [v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF];
+
+class StoredCompression {
+  final int pressTimeMs;      // device millis()
+  final double peakGrams;
+  final double residualGrams;
+  final int dutyPct;
+  final int flags;            // same bits as CompressionRecord.flags
+
+  StoredCompression(this.pressTimeMs, this.peakGrams, this.residualGrams, this.dutyPct, this.flags);
+}
+
+class StoredSession {
+  final int number;
+  final int startMs;
+  final List<StoredCompression> compressions = [];
+  // from the end record; ended stays false if the device reset mid-session
+  bool ended = false;
+  bool aborted = false;
+  int durationMs = 0;
+  double avgBpm = 0;
+  double accuracy = 0;
+  double consistency = 0;
+
+  StoredSession(this.number, this.startMs);
+}
+
+// Reassembles the download and hands back the commands to write. Keep one
+// instance across connections: start() resumes where the last download
+// stopped, so after a complete one it fetches only what was recorded since.
+class SessionDownload {
+  int logId = 0;
+  int total = 0;
+  int received = 0;
+  int window = 1;
+  int chunk = 20;
+  bool running = false;
+  bool done = false;
+  int? error;
+  int naks = 0;
+  final BytesBuilder _data = BytesBuilder();
+  int _acked = 0;
+  bool _gap = false;
+
+  double get progress => total == 0 ? (done ? 1.0 : 0.0) : received / total;
+
+  List<int> start(int mtu, {int windowChunks = 16}) {
+    chunk = mtu - 3 - bulkDataHeader;
+    running = true;
+    done = false;
+    error = null;
+    return [bulkCmdStart, mtu & 0xFF, (mtu >> 8) & 0xFF, windowChunks, ..._u32(logId), ..._u32(received)];
+  }
+
+  List<int> stop() {
+    running = false;
+    return [bulkCmdStop];
+  }
+
+  // Returns the command to write back, if any (write without response)
+  List<int>? add(List<int> value) {
+    if (value.isEmpty || !running) return null;
+    final bytes = Uint8List.fromList(value);
+    final data = ByteData.sublistView(bytes);
+    switch (bytes[0]) {
+      case bulkInfo:
+        if (bytes.length < 14) return null;
+        final offset = data.getUint32(5, Endian.little);
+        // the device starts over when the log moved on since our last try
+        if (offset != received) {
+          final kept = _data.takeBytes();
+          if (offset <= kept.length) _data.add(kept.sublist(0, offset));
+          received = offset;
+        }
+        logId = data.getUint32(1, Endian.little);
+        total = data.getUint32(9, Endian.little);
+        window = bytes[13];
+        _acked = received;
+        _gap = false;
+        return null;
+      case bulkData:
+        if (bytes.length < bulkDataHeader) return null;
+        if (data.getUint32(1, Endian.little) != received) {
+          // go-back-N: ask once per gap, the rest comes again anyway
+          if (_gap) return null;
+          _gap = true;
+          naks++;
+          return [bulkCmdNak, ..._u32(received)];
+        }
+        _gap = false;
+        _data.add(bytes.sublist(bulkDataHeader));
+        received += bytes.length - bulkDataHeader;
+        if (received == total || received - _acked >= window * chunk ~/ 2) {
+          _acked = received;
+          return [bulkCmdAck, ..._u32(received)];
+        }
+        return null;
+      case bulkDone:
+        running = false;
+        done = true;
+        return null;
+      case bulkError:
+        running = false;
+        error = bytes.length > 1 ? bytes[1] : 0;
+        return null;
+    }
+    return null;
+  }
+
+  // Decodes the records received so far; a session cut off by the end of the data is left open
+  List<StoredSession> sessions() {
+    final stream = _data.toBytes();
+    final sessions = <StoredSession>[];
+    StoredSession? current;
+    int lastPress = 0;
+    int lastPeak = 0;
+    int at = 0;
+    while (at + 2 <= stream.length) {
+      final type = stream[at];
+      final len = stream[at + 1];
+      if (at + 2 + len > stream.length) break;
+      final fields = _varints(stream.sublist(at + 2, at + 2 + len));
+      at += 2 + len;
+      if (type == logSessionStart && fields.length >= 2) {
+        current = StoredSession(fields[0], fields[1]);
+        sessions.add(current);
+        lastPress = fields[1];
+        lastPeak = 0;
+      } else if (type == logCompressions && current != null) {
+        for (int i = 0; i + 5 <= fields.length; i += 5) {
+          lastPress += fields[i];
+          lastPeak += (fields[i + 1] >> 1) ^ -(fields[i + 1] & 1);
+          current.compressions.add(StoredCompression(
+              lastPress, lastPeak * 10.0, fields[i + 2] * 100.0, fields[i + 3], fields[i + 4]));
+        }
+      } else if (type == logSessionEnd && current != null && fields.length >= 7 && fields[0] == current.number) {
+        current.ended = true;
+        current.durationMs = fields[1];
+        current.avgBpm = fields[3] / 10.0;
+        current.accuracy = fields[4] / 100.0;
+        current.consistency = fields[5] / 100.0;
+        current.aborted = (fields[6] & logEndAborted) != 0;
+        current = null;
+      }
+    }
+    return sessions;
+  }
+
+  static List<int> _varints(List<int> bytes) {
+    final values = <int>[];
+    int value = 0;
+    int shift = 0;
+    for (final b in bytes) {
+      value |= (b & 0x7F) << shift;
+      shift += 7;
+      if ((b & 0x80) == 0) {
+        values.add(value);
+        value = 0;
+        shift = 0;
+      }
+    }
+    return values;
+  }
+}
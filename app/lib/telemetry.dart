@@ -0,0 +1,75 @@
+import 'dart:typed_data';
+
+// Decoder for the batched compression telemetry characteristic (19B10004).
+// Layout, little-endian:
+//   header  u16 seq | u8 version | u8 count | u32 base_ms
+//   record  u16 dt_ms | u16 peak_10g | u8 peak_4ms | u8 press_4ms | u8 release_4ms
+//           u16 bpm_x10 | u8 residual_100g | u8 duty_pct | u8 flags
+
+const int telemetryVersion = 2;
+const int telemetryHeaderSize = 8;
+const int telemetryRecordSize = 12;
+
+// CompressionRecord.flags
+const int flagDepthLow = 1 << 0;
+const int flagDepthHigh = 1 << 1;
+const int flagIncompleteRecoil = 1 << 2;
+const int flagFinal = 1 << 3;   // last press before a pause: releaseMs and dutyPct unknown
+
+class CompressionRecord {
+  final int pressTimeMs;      // device millis() when the press started
+  final double peakGrams;     // depth proxy
+  final int timeToPeakMs;     // onset to peak
+  final int pressMs;          // onset to unloaded
+  final int releaseMs;        // unloaded to the next onset
+  final double bpm;           // 0 when there was no previous press
+  final double residualGrams; // lowest force before the next press (recoil)
+  final int dutyPct;
+  final int flags;
+
+  CompressionRecord(this.pressTimeMs, this.peakGrams, this.timeToPeakMs, this.pressMs, this.releaseMs, this.bpm,
+      this.residualGrams, this.dutyPct, this.flags);
+
+  bool get depthOk => (flags & (flagDepthLow | flagDepthHigh)) == 0;
+  bool get recoilOk => (flags & flagIncompleteRecoil) == 0;
+}
+
+class TelemetryPacket {
+  final int seq;
+  final List<CompressionRecord> records;
+
+  TelemetryPacket(this.seq, this.records);
+}
+
+// Returns null for a packet that is too short or from an unknown version
+TelemetryPacket? decodeTelemetry(List<int> value) {
+  if (value.length < telemetryHeaderSize) return null;
+  final data = ByteData.sublistView(Uint8List.fromList(value));
+  final seq = data.getUint16(0, Endian.little);
+  final version = data.getUint8(2);
+  final count = data.getUint8(3);
+  if (version != telemetryVersion) return null;
+  if (value.length < telemetryHeaderSize + count * telemetryRecordSize) return null;
+
+  int press = data.getUint32(4, Endian.little);
+  final records = <CompressionRecord>[];
+  for (int i = 0; i < count; i++) {
+    final at = telemetryHeaderSize + i * telemetryRecordSize;
+    press += data.getUint16(at, Endian.little);
+    records.add(CompressionRecord(
+      press,
+      data.getUint16(at + 2, Endian.little) * 10.0,
+      data.getUint8(at + 4) * 4,
+      data.getUint8(at + 5) * 4,
+      data.getUint8(at + 6) * 4,
+      data.getUint16(at + 7, Endian.little) / 10.0,
+      data.getUint8(at + 9) * 100.0,
+      data.getUint8(at + 10),
+      data.getUint8(at + 11),
+    ));
+  }
+  return TelemetryPacket(seq, records);
+}
+
+// The MTU the app negotiated, written to the characteristic so the device can size its batches
+List<int> encodeMtu(int mtu) => [mtu & 0xFF, (mtu >> 8) & 0xFF];
@@ -0,0 +1,53 @@
+import 'dart:typed_data';
+
+// Decoder for the test result characteristic (19B10003), one record per test.
+// Layout, little-endian (20 bytes):
+//   u8 version | u16 compressions | u16 duration_s | u16 mean_bpm_x10 |
+//   u16 sd_bpm_x10 | u16 p10_bpm_x10 | u16 p50_bpm_x10 | u16 p90_bpm_x10 |
+//   u8 in_band_pct | u8 accuracy_pct | u8 consistency_pct | u8 pauses | u8 flags
+
+const int testResultVersion = 1;
+const int testResultSize = 20;
+
+// TestResult.flags
+const int flagClipped = 1 << 0;   // an interval fell outside the device's histogram
+
+class TestResult {
+  final int compressions;
+  final int durationS;
+  final double meanBpm;
+  final double sdBpm;
+  final double p10Bpm;      // 10 % of the intervals were slower
+  final double p50Bpm;
+  final double p90Bpm;
+  final int inBandPct;      // share of the test within 90-116 BPM
+  final int accuracyPct;
+  final int consistencyPct;
+  final int pauses;         // gaps over 2 s
+  final int flags;
+
+  TestResult(this.compressions, this.durationS, this.meanBpm, this.sdBpm, this.p10Bpm, this.p50Bpm, this.p90Bpm,
+      this.inBandPct, this.accuracyPct, this.consistencyPct, this.pauses, this.flags);
+}
+
+// Returns null for a short record or an unknown version
+TestResult? decodeTestResult(List<int> value) {
+  if (value.length < testResultSize) return null;
+  final data = ByteData.sublistView(Uint8List.fromList(value));
+  if (data.getUint8(0) != testResultVersion) return null;
+  double x10(int at) => data.getUint16(at, Endian.little) / 10.0;
+  return TestResult(
+    data.getUint16(1, Endian.little),
+    data.getUint16(3, Endian.little),
+    x10(5),
+    x10(7),
+    x10(9),
+    x10(11),
+    x10(13),
+    data.getUint8(15),
+    data.getUint8(16),
+    data.getUint8(17),
+    data.getUint8(18),
+    data.getUint8(19),
+  );
+}
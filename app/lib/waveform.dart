@@ -0,0 +1,90 @@
+import 'dart:typed_data';
+
+// Decoder for the force waveform characteristic (19B10005).
+// Frame, little-endian: u16 seq | u8 version | u8 count | u32 t0_ms |
+// u16 period_x10 | varints
+// Samples are grams; the first is a zig-zag varint of the value, the rest
+// zig-zag varint deltas from the previous sample.
+
+const int waveformVersion = 2;
+const int waveformHeaderSize = 10;
+
+class WaveformFrame {
+  final int seq;
+  final int t0Ms;
+  final double periodMs;
+  final List<int> grams;
+
+  WaveformFrame(this.seq, this.t0Ms, this.periodMs, this.grams);
+}
+
+int _zigzagDecode(int v) => (v >> 1) ^ -(v & 1);
+
+// Returns null for a malformed frame or one from an unknown version
+WaveformFrame? decodeWaveform(List<int> value) {
+  if (value.length < waveformHeaderSize) return null;
+  final bytes = Uint8List.fromList(value);
+  final data = ByteData.sublistView(bytes);
+  final seq = data.getUint16(0, Endian.little);
+  if (data.getUint8(2) != waveformVersion) return null;
+  final count = data.getUint8(3);
+  final t0 = data.getUint32(4, Endian.little);
+  final period = data.getUint16(8, Endian.little) / 10.0;
+
+  final grams = <int>[];
+  int at = waveformHeaderSize;
+  int sample = 0;
+  for (int i = 0; i < count; i++) {
+    int coded = 0;
+    int shift = 0;
+    while (true) {
+      if (at >= bytes.length || shift > 28) return null;
+      final b = bytes[at++];
+      coded |= (b & 0x7F) << shift;
+      shift += 7;
+      if ((b & 0x80) == 0) break;
+    }
+    final v = _zigzagDecode(coded);
+    sample = i == 0 ? v : sample + v;
+    grams.add(sample);
+  }
+  if (at != bytes.length) return null;
+  return WaveformFrame(seq, t0, period, grams);
+}
+
+// Keeps the last [capacity] samples and counts frames lost in between
+class WaveformReceiver {
+  final int capacity;
+  final List<int> samples = [];
+  int? _expectedSeq;
+  int lostFrames = 0;
+  int frames = 0;
+
+  WaveformReceiver({this.capacity = 400});
+
+  bool add(List<int> value) {
+    final frame = decodeWaveform(value);
+    if (frame == null) return false;
+    if (_expectedSeq != null) {
+      final gap = (frame.seq - _expectedSeq!) & 0xFFFF;
+      if (gap != 0) {
+        lostFrames += gap;
+        print('Waveform: lost $gap frame(s) before seq ${frame.seq}');
+      }
+    }
+    _expectedSeq = (frame.seq + 1) & 0xFFFF;
+    frames++;
+    samples.addAll(frame.grams);
+    if (samples.length > capacity) {
+      samples.removeRange(0, samples.length - capacity);
+    }
+    return true;
+  }
+
+  void reset() {
+    samples.clear();
+    _expectedSeq = null;
+    lostFrames = 0;
+    frames = 0;
+  }
+}
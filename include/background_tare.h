@@ -0,0 +1,47 @@
+#ifndef BACKGROUND_TARE_H
+#define BACKGROUND_TARE_H
+
+#include <stdint.h>
+
+// Checks the zero restored from flash against the first seconds after boot,
+// while the samples already count. Raw readings are averaged over WINDOW_MS.
+// If they stayed within STILL_GRAMS of each other and their mean is within
+// MAX_DRIFT_GRAMS of the restored zero, the cell was unloaded and the mean
+// becomes the new offset. If they moved, someone was already pressing. If the
+// mean is far off, something is resting on the cell. In both cases the
+// restored offset stands. A correction this small stays under the detector's
+// press threshold, and its idle baseline absorbs the step.
+class BackgroundTare {
+public:
+    enum Result : uint8_t { RUNNING, ACCEPTED, MOVING, LOADED };
+
+    static constexpr unsigned long WINDOW_MS = 2000;
+    static constexpr float STILL_GRAMS = 150.0f;
+    static constexpr float MAX_DRIFT_GRAMS = 500.0f;
+
+    // offset and gain as restored (raw counts, grams per count)
+    void begin(int32_t offset, float gain, unsigned long now);
+    // One raw conversion; returns RUNNING until the window is over, then the verdict once
+    Result add(int32_t raw, unsigned long timestamp);
+    bool running() const { return running_; }
+    void cancel() { running_ = false; }
+
+    // Mean of the window, valid once add() returned ACCEPTED
+    int32_t offset() const { return offset_; }
+    // mean - restored offset, in grams
+    float driftGrams() const { return drift_grams_; }
+
+private:
+    bool running_ = false;
+    int32_t restored_ = 0;
+    float gain_ = 1.0f;
+    unsigned long start_ = 0;
+    int64_t sum_ = 0;
+    uint32_t count_ = 0;
+    int32_t min_ = 0;
+    int32_t max_ = 0;
+    int32_t offset_ = 0;
+    float drift_grams_ = 0.0f;
+};
+
+#endif
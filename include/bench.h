@@ -0,0 +1,24 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+// Benchmark firmware (PULSECOACH_BENCH): called at the end of setup(), prints
+// one line per case to out and returns so the normal loop() keeps running.
+// Results are checked by the unit tests in test/, not here. By source:
+//   bpm_helper.h             BPM stats and the vector helpers, swept window sizes
+//   compression_history.h    history push and stats per capacity
+//   loop.cpp                 setStackedText() and a full display()
+//   feedback_display.cpp     dirty-page redraw, changed and unchanged
+//   hx711_driver.cpp         readout per backend, against the bogde library
+//   hx711_driver.h           raw to q15 force, float divide against fixed point
+//   waveform_codec.cpp       bytes per sample and encode time, synthetic and live trace
+//   compression_detector.cpp update time per sample, synthetic and live trace
+//   dsp_kernels.cpp          q15 block FIR and slope per sample: scalar, dual-MAC, float
+//   bulk_transfer.cpp        session log download per MTU and window over a loopback
+//                            link, and whether the app side got the log intact
+//   main.cpp                 whole loop() passes, in cycles and in us
+void runBenchmarks(Print &out, Adafruit_SSD1306 &display);
+
+#endif
@@ -4,6 +4,8 @@
 #include <vector>
 #include <cmath>
 #include <Arduino.h>
+#include "compression_history.h"
+#include "debug_log.h"
 
 // Constants
 const int TARGET_BPM = 103;
@@ -12,68 +14,139 @@ const int MAX_BPM = 116;
 const int SAMPLE_SIZE = 10;
 const float MAX_STD_DEV = 15.0;
 const float MIN_CONSISTENCY = 0.5;
+// intervals used for live feedback
+const int BPM_WINDOW = 5;
 
-// Helper function to calculate standard deviation of BPMs
-float calculateBPMStandardDeviation(const std::vector<unsigned long>& times, int last_n = 5) {
-    int size = times.size();
-    if (size < 2) return 0.0;
+// Compression timestamps with incrementally maintained BPM statistics
+typedef CompressionHistory<SAMPLE_SIZE, BPM_WINDOW> CompressionTimes;
+
+// Everything the feedback path needs, from one pass over the timestamps
+struct BpmStats {
+    float weighted_mean;          // newest interval weighs most
+    float std_dev;                // population std-dev of the instantaneous BPMs
+    float consistency;            // 1.0 = perfect consistency
+    bool consistent;              // consistency >= MIN_CONSISTENCY
+    unsigned long min_interval;   // ms
+    unsigned long max_interval;   // ms
+    int count;                    // intervals that went into the stats
+};
+
+// Fused single-pass kernel over the last last_n intervals of times[0..size).
+// No allocation, one single-precision reciprocal per interval (the BPM itself)
+// and no other per-element division: the variance uses sums shifted by the
+// first BPM so it stays accurate without Welford's per-step divide.
+inline BpmStats computeBpmStats(const unsigned long* times, int size, int last_n = BPM_WINDOW) {
+    BpmStats stats = {0.0f, 0.0f, 0.0f, false, 0, 0, 0};
+    if (size < 2) return stats;
+
+    float shift = 0.0f;
+    float sum = 0.0f;           // sum(bpm - shift)
+    float sum_sq = 0.0f;        // sum((bpm - shift)^2)
+    float weighted_sum = 0.0f;  // sum(k * bpm), k = 1..count
+    int count = 0;
 
-    std::vector<float> bpms;
     for (int i = std::max(1, size - last_n); i < size; i++) {
-        float interval = times[i] - times[i - 1];
-        if (interval > 0) {
-            bpms.push_back(60000.0 / interval);
+        unsigned long interval = times[i] - times[i - 1];
+        if (interval == 0) continue;
+
+        float bpm = 60000.0f / interval;
+        if (count == 0) {
+            shift = bpm;
+            stats.min_interval = interval;
+            stats.max_interval = interval;
         }
+        count++;
+
+        float d = bpm - shift;
+        sum += d;
+        sum_sq += d * d;
+        weighted_sum += count * bpm;
+        if (interval < stats.min_interval) stats.min_interval = interval;
+        if (interval > stats.max_interval) stats.max_interval = interval;
     }
 
-    float mean = 0.0;
-    for (float bpm : bpms) mean += bpm;
-    mean /= bpms.size();
+    if (count == 0) return stats;
+
+    float inv_count = 1.0f / count;
+    float mean_d = sum * inv_count;
+    float variance = sum_sq * inv_count - mean_d * mean_d;
+
+    stats.count = count;
+    stats.weighted_mean = weighted_sum / (count * (count + 1) * 0.5f);
+    stats.std_dev = variance > 0.0f ? sqrt(variance) : 0.0f;
+    stats.consistency = 1.0f - stats.std_dev / MAX_STD_DEV;
+    stats.consistent = stats.consistency >= MIN_CONSISTENCY;
+    return stats;
+}
 
-    float variance = 0.0;
-    for (float bpm : bpms) variance += (bpm - mean) * (bpm - mean);
-    variance /= bpms.size();
+inline BpmStats computeBpmStats(const std::vector<unsigned long>& times, int last_n = BPM_WINDOW) {
+    return computeBpmStats(times.data(), times.size(), last_n);
+}
 
-    return sqrt(variance);
+// Helper function to calculate standard deviation of BPMs
+inline float calculateBPMStandardDeviation(const std::vector<unsigned long>& times, int last_n = 5) {
+    return computeBpmStats(times, last_n).std_dev;
 }
 
 // Helper function to calculate weighted average BPM
-float calculateWeightedAverageBPM(const std::vector<unsigned long>& times, int last_n = 5) {
-    int size = times.size();
-    if (size < 2) return 0.0;
+inline float calculateWeightedAverageBPM(const std::vector<unsigned long>& times, int last_n = 5) {
+    return computeBpmStats(times, last_n).weighted_mean;
+}
 
-    std::vector<float> bpms;
-    for (int i = std::max(1, size - last_n); i < size; i++) {
-        float interval = times[i] - times[i - 1];
-        if (interval > 0) {
-            bpms.push_back(60000.0 / interval);
-        }
-    }
+// Helper function to check compression consistency
+inline bool isConsistentCompression(const std::vector<unsigned long>& times) {
+    if (times.size() < 2) return false;
 
-    float total_weight = 0.0;
-    float weighted_sum = 0.0;
-    for (size_t i = 0; i < bpms.size(); i++) {
-        float weight = static_cast<float>(i + 1) / bpms.size();
-        weighted_sum += bpms[i] * weight;
-        total_weight += weight;
-    }
+    BpmStats stats = computeBpmStats(times);
+    LOG_DEBUG("Consistency: %f", stats.consistency);
 
-    return weighted_sum / total_weight;
+    // Check if both the average and consistency are within acceptable ranges
+    return stats.consistent;
 }
 
-// Helper function to check compression consistency
-bool isConsistentCompression(const std::vector<unsigned long>& times) {
+// O(1) overloads for the ring-buffer history. last_n == BPM_WINDOW reads the
+// live window, anything larger reads every stored interval.
+template <size_t N, size_t R>
+float calculateBPMStandardDeviation(const CompressionHistory<N, R>& times, int last_n = BPM_WINDOW) {
+    if (times.size() < 2) return 0.0;
+    return last_n <= (int)R ? times.recent().standardDeviation() : times.full().standardDeviation();
+}
+
+template <size_t N, size_t R>
+float calculateWeightedAverageBPM(const CompressionHistory<N, R>& times, int last_n = BPM_WINDOW) {
+    if (times.size() < 2) return 0.0;
+    return last_n <= (int)R ? times.recent().weightedMean() : times.full().weightedMean();
+}
+
+// Same struct from the history's running windows; only the min/max interval
+// scan touches the stored timestamps (at most N - 1 of them)
+template <size_t N, size_t R>
+BpmStats computeBpmStats(const CompressionHistory<N, R>& times, int last_n = BPM_WINDOW) {
+    BpmStats stats = {0.0f, 0.0f, 0.0f, false, 0, 0, 0};
+    if (times.size() < 2) return stats;
+
+    bool recent = last_n <= (int)R;
+    stats.count = recent ? times.recent().size() : times.full().size();
+    if (stats.count == 0) return stats;
+
+    stats.weighted_mean = recent ? times.recent().weightedMean() : times.full().weightedMean();
+    stats.std_dev = recent ? times.recent().standardDeviation() : times.full().standardDeviation();
+    stats.consistency = 1.0f - stats.std_dev / MAX_STD_DEV;
+    stats.consistent = stats.consistency >= MIN_CONSISTENCY;
+    times.intervalRange(stats.count, stats.min_interval, stats.max_interval);
+    return stats;
+}
+
+template <size_t N, size_t R>
+bool isConsistentCompression(const CompressionHistory<N, R>& times) {
     if (times.size() < 2) return false;
-    
+
     float std_dev = calculateBPMStandardDeviation(times);
-    float avg_bpm = calculateWeightedAverageBPM(times);
-    
+
     // Calculate consistency ratio (1.0 = perfect consistency)
     float consistency = 1.0 - (std_dev / MAX_STD_DEV);
-    Serial.print("Consistency: ");
-    Serial.println(consistency);
-    
-    // Check if both the average and consistency are within acceptable ranges
+    LOG_DEBUG("Consistency: %f", consistency);
+
     return (consistency >= MIN_CONSISTENCY);
 }
 
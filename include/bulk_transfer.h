@@ -0,0 +1,109 @@
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "session_log.h"
+
+// Bulk download of the session log over one characteristic. The app writes
+// commands (with or without response) and the device answers with notifications.
+// The stream is every committed record as u8 type | u8 len | payload, oldest
+// first. The CRC and commit bytes are left out because the link has its own CRC.
+// All fields are little-endian:
+//
+//   central -> device
+//     START  0x01 | u16 mtu | u8 window (chunks) | u32 log_id | u32 offset
+//     ACK    0x02 | u32 offset (every byte before it arrived)
+//     STOP   0x03
+//     NAK    0x04 | u32 offset (like ACK, but the chunk at offset went missing)
+//   device -> central
+//     INFO   0x10 | u32 log_id | u32 offset | u32 total | u8 window
+//     DATA   0x11 | u32 offset | bytes, filling the whole ATT payload
+//     DONE   0x12 | u32 total
+//     ERROR  0x13 | u8 reason
+//
+// Offsets count from the oldest record and stay valid while log_id (the
+// oldest block's sequence number) is unchanged. A START with the log_id and
+// offset of an interrupted download resumes there. Otherwise the transfer
+// starts from 0, and INFO says which. total is fixed at START, so sessions
+// recorded during a download go out with the next one.
+//
+// At most window chunks are unacknowledged at a time. ACKs are cumulative,
+// so the app can send one every few chunks and losing one costs nothing.
+// Sending goes back to the acked offset (go-back-N) on a NAK, which the app
+// sends when a chunk arrives past a gap, or when no ACK advances for
+// ACK_TIMEOUT_MS (a lost tail chunk).
+class BulkSender {
+public:
+    enum Command : uint8_t { CMD_START = 0x01, CMD_ACK = 0x02, CMD_STOP = 0x03, CMD_NAK = 0x04 };
+    enum Packet : uint8_t { PKT_INFO = 0x10, PKT_DATA = 0x11, PKT_DONE = 0x12, PKT_ERROR = 0x13 };
+    enum Error : uint8_t { ERR_BAD_COMMAND = 1, ERR_LOG_CHANGED = 2 };
+
+    static constexpr size_t DATA_HEADER = 5;
+    static constexpr uint16_t MIN_MTU = 23;
+    static constexpr uint16_t MAX_MTU = 247;
+    static constexpr size_t MAX_PACKET = MAX_MTU - 3;
+    static constexpr uint8_t MAX_WINDOW = 16;
+    static constexpr unsigned long ACK_TIMEOUT_MS = 500;
+
+    explicit BulkSender(SessionLog &log) : log_(log) {}
+
+    // A command the central wrote; START and STOP take effect right away
+    void onCommand(const uint8_t *data, size_t len, unsigned long now);
+    // Link gone: stop without a reply. The app resumes with START.
+    void stop();
+    bool active() const { return state_ != IDLE; }
+
+    // Builds the next packet into out (MAX_PACKET bytes) without consuming
+    // it. Returns 0 if nothing may go out now. Call sent() once it is queued.
+    size_t fill(uint8_t *out, unsigned long now);
+    void sent(unsigned long now);
+
+    uint32_t total() const { return total_; }
+    uint32_t acked() const { return acked_; }
+    size_t chunkSize() const { return chunk_; }
+    unsigned long retransmits() const { return retransmits_; }
+    unsigned long transfers() const { return transfers_; }
+    // the last completed download, from START to the final ACK
+    uint32_t lastBytes() const { return last_bytes_; }
+    unsigned long lastMs() const { return last_ms_; }
+
+private:
+    enum State : uint8_t { IDLE, SEND_INFO, SENDING, SEND_DONE, SEND_ERROR };
+
+    // Where the next stream byte comes from
+    struct Position {
+        SessionLog::Cursor cursor;
+        SessionLog::Record record;
+        uint8_t used;         // bytes of record already in the stream
+        bool has_record;
+        uint32_t offset;
+    };
+
+    void start(uint16_t mtu, uint8_t window, uint32_t log_id, uint32_t offset, unsigned long now);
+    void fail(uint8_t reason);
+    // Restarts pos at the oldest record and moves it to offset (or the end of the log)
+    void seek(Position &pos, uint32_t offset);
+    // Moves pos up to max stream bytes on, copying them to out unless it is null
+    size_t advance(Position &pos, uint8_t *out, size_t max);
+
+    SessionLog &log_;
+    State state_ = IDLE;
+    uint8_t error_ = 0;
+    uint32_t log_id_ = 0;
+    uint32_t start_offset_ = 0;
+    uint32_t total_ = 0;
+    uint32_t acked_ = 0;
+    size_t chunk_ = MIN_MTU - 3 - DATA_HEADER;
+    uint8_t window_ = 1;
+    Position pos_;
+    Position staged_;     // pos_ after the packet from fill()
+    unsigned long started_at_ = 0;
+    unsigned long last_progress_ = 0;
+    unsigned long retransmits_ = 0;
+    unsigned long transfers_ = 0;
+    uint32_t last_bytes_ = 0;
+    unsigned long last_ms_ = 0;
+};
+
+#endif
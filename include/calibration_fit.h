@@ -0,0 +1,60 @@
+#ifndef CALIBRATION_FIT_H
+#define CALIBRATION_FIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "calibration_store.h"
+
+// Multi-point load-cell calibration against known weights. For each weight
+// capture() averages SAMPLES raw conversions. A window whose readings have a
+// standard deviation over STILL_GRAMS is thrown away and taken again, up to
+// MAX_TRIES times, so a weight still swinging on the cell doesn't make it into
+// the fit.
+//
+// fit() solves least squares for grams = c0 + c1 * x + c2 * x^2 over the
+// captured points (x = raw - first point). With fewer than three distinct
+// weights it fits a straight line. The result is moved to the form the driver
+// uses, grams = gain * d + curve * d^2 with d = raw - offset, where offset is
+// the fitted zero crossing. A curve that would fold back (slope changing
+// sign) within twice the calibrated range is rejected.
+class CalibrationFit {
+public:
+    enum Capture : uint8_t { IDLE, CAPTURING, CAPTURED, UNSTEADY };
+
+    static constexpr size_t MAX_POINTS = 8;
+    static constexpr uint16_t SAMPLES = 80;      // 1 s at 80 SPS
+    static constexpr uint8_t MAX_TRIES = 5;
+    static constexpr float STILL_GRAMS = 50.0f;
+
+    void reset();
+
+    // Starts averaging for `grams` now on the cell; gain (grams per count, the
+    // calibration in use) only sets the stillness limit
+    bool capture(float grams, float gain);
+    // One raw conversion; CAPTURED/UNSTEADY once, when the point is decided
+    Capture add(int32_t raw);
+    bool capturing() const { return state_ == CAPTURING; }
+    size_t points() const { return points_; }
+
+    // false if the points can't determine a fit; rms_grams is the residual at the points
+    bool fit(LoadCellCalibration &out, float &rms_grams) const;
+
+private:
+    struct Point {
+        int32_t raw;
+        float grams;
+    };
+
+    Point point_[MAX_POINTS];
+    size_t points_ = 0;
+    Capture state_ = IDLE;
+    float grams_ = 0.0f;
+    float max_sd_counts_ = 0.0f;
+    int32_t first_ = 0;     // readings are summed relative to the window's first
+    int64_t sum_ = 0;
+    int64_t sum_sq_ = 0;
+    uint16_t count_ = 0;
+    uint8_t tries_ = 0;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "flash_store.h"
+
+// What the load cell needs to turn a raw conversion into grams, see
+// Hx711Driver::setCalibration
+struct LoadCellCalibration {
+    int32_t offset;     // raw counts with nothing on the cell
+    float gain;         // grams per count
+    float curve;        // grams per count^2, 0 for a straight line
+};
+
+// Keeps the newest calibration in one erase block, so boot can skip the tare.
+// Each save goes into the next free SLOT_SIZE slot and the block is only
+// erased once all of them are used:
+//
+//   u16 magic | u8 version | u8 len | payload[len] | u8 crc8(magic..payload) | u8 commit
+//   payload   i32 offset | f32 gain | f32 curve (little-endian)
+//
+// Version 1 slots (i32 offset | f32 counts per gram) still load.
+//
+// As in the session log, the commit byte is programmed last, so a slot torn
+// by a reset is skipped and the one before it stays in force. Saves are
+// blocking (one slot program, plus a block erase every SLOTS saves).
+class CalibrationStore {
+public:
+    static constexpr uint16_t MAGIC = 0x4C43;
+    static constexpr uint8_t VERSION = 2;
+    static constexpr size_t SLOT_SIZE = 32;
+    static constexpr size_t HEADER_SIZE = 4;
+    static constexpr size_t PAYLOAD_SIZE = 12;
+    static constexpr size_t V1_PAYLOAD_SIZE = 8;
+    static constexpr uint8_t COMMIT = 0xA5;
+
+    explicit CalibrationStore(FlashStore &flash) : flash_(flash) {}
+
+    // Newest committed calibration; false when there is none or the flash didn't open
+    bool load(LoadCellCalibration &out);
+    bool save(const LoadCellCalibration &calibration);
+
+private:
+    bool readSlot(uint32_t address, LoadCellCalibration &out);
+
+    FlashStore &flash_;
+    bool scanned_ = false;
+    uint32_t next_ = 0;     // first free slot
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef COMPRESSION_DETECTOR_H
+#define COMPRESSION_DETECTOR_H
+
+#include <stdint.h>
+#include "force_filter.h"
+
+// One completed compression, reported once the release has been seen
+struct CompressionEvent {
+    unsigned long press_time;    // ms, force first crossed the press threshold
+    unsigned long peak_time;     // ms, highest force seen during the press
+    unsigned long release_time;  // ms, release was detected
+    float peak_force;            // grams above the idle baseline
+};
+
+// Resumable compression state machine. Takes exactly one load-cell sample per
+// update() call, so the caller never has to spin while the user is pressing.
+//
+//   IDLE -> PRESSING -> PEAK -> RELEASING -> RECOILED -> IDLE
+//
+// Each sample is low-passed and measured against a baseline that only tracks
+// while the cell is idle, so drift since the boot tare doesn't move the
+// thresholds. Those scale with the recent compression amplitude:
+//   - press when the force rises PRESS_FRACTION of the amplitude above baseline
+//   - release once it falls back under RELEASE_FRACTION of this press's peak
+//   - re-arm below half the press threshold, or on a fresh rise of a full press
+//     threshold out of the valley when the trainee leans instead of recoiling
+// A press closer than REFRACTORY_MS to the previous one is ignored.
+//
+// A force that holds within PLATEAU_GRAMS for PLATEAU_MS is a new zero rather
+// than a press that never ends: something resting on the cell, a trainee
+// leaning, a tare step. The baseline jumps to it and the detector goes back to
+// IDLE. No compression lasts that long, so a real press is never cut short.
+class CompressionDetector {
+public:
+    enum State : uint8_t { IDLE, PRESSING, PEAK, RELEASING, RECOILED };
+
+    // fractions are in percent
+    static constexpr int32_t PRESS_FRACTION = 30;
+    static constexpr int32_t RELEASE_FRACTION = 70;
+    static constexpr int32_t MIN_PRESS_GRAMS = 2000;
+    static constexpr int32_t INITIAL_AMPLITUDE = 10000;
+    static constexpr unsigned long REFRACTORY_MS = 200;       // 300 BPM
+    static constexpr unsigned long BASELINE_SETTLE_MS = 250;  // after a release
+    static constexpr unsigned long AMPLITUDE_RESET_MS = 3000;
+    static constexpr int32_t PLATEAU_GRAMS = 500;
+    static constexpr unsigned long PLATEAU_MS = 2000;
+
+    // lowpass_shift 0 passes samples straight through, for input that is already filtered
+    explicit CompressionDetector(uint8_t lowpass_shift = 1);
+
+    // Feed one sample (grams, ms). Returns true on the sample that completes a compression.
+    bool update(float force, unsigned long now);
+
+    void reset();
+
+    State state() const { return state_; }
+    bool isIdle() const { return state_ == IDLE || state_ == RECOILED; }
+    const CompressionEvent &lastEvent() const { return event_; }
+
+    int32_t filtered() const { return lowpass_.value(); }
+    int32_t baseline() const { return baseline_.value(); }
+    int32_t amplitude() const { return amplitude_; }
+    int32_t pressThreshold() const { return press_threshold_; }
+
+private:
+    void startPress(int32_t force, unsigned long now);
+
+    FixedLowPass lowpass_;
+    BaselineTracker baseline_;
+    State state_;
+    int32_t amplitude_;
+    int32_t press_threshold_;
+    int32_t peak_;
+    int32_t valley_;
+    bool pressed_before_;
+    int32_t plateau_level_;
+    unsigned long plateau_since_;
+    CompressionEvent current_;
+    CompressionEvent event_;
+};
+
+#endif
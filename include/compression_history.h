@@ -0,0 +1,170 @@
+#ifndef COMPRESSION_HISTORY_H
+#define COMPRESSION_HISTORY_H
+
+#include <stddef.h>
+#include <math.h>
+
+// Running statistics over the last W instantaneous BPM values.
+// Mean/variance use Welford's update (with the matching removal step when the
+// oldest value slides out) and the weighted mean keeps the linear-weight sum
+// sum((i + 1) * bpm_i) incrementally, so every query is O(1).
+template <size_t W>
+class SlidingBpmWindow {
+public:
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+        sum_ = 0.0f;
+        weighted_sum_ = 0.0f;
+        mean_ = 0.0f;
+        m2_ = 0.0f;
+    }
+
+    void push(float bpm)
+    {
+        if (count_ == W) {
+            // drop the oldest value: every remaining weight goes down by one
+            float oldest = values_[head_];
+            weighted_sum_ -= sum_;
+            sum_ -= oldest;
+            count_--;
+            if (count_ == 0) {
+                mean_ = 0.0f;
+                m2_ = 0.0f;
+            } else {
+                float delta = oldest - mean_;
+                mean_ -= delta / count_;
+                m2_ -= delta * (oldest - mean_);
+            }
+        }
+
+        values_[head_] = bpm;
+        head_ = (head_ + 1) % W;
+        count_++;
+
+        sum_ += bpm;
+        weighted_sum_ += count_ * bpm;
+        float delta = bpm - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (bpm - mean_);
+
+        // reseed from the stored values once per lap so rounding from the
+        // add/remove pairs can't accumulate over a long session
+        if (head_ == 0) resync();
+    }
+
+    size_t size() const { return count_; }
+
+    float mean() const { return mean_; }
+
+    // population variance, matching calculateBPMStandardDeviation()
+    float variance() const { return (count_ > 0 && m2_ > 0.0f) ? m2_ / count_ : 0.0f; }
+
+    float standardDeviation() const { return sqrt(variance()); }
+
+    // newest value weighs count_, oldest weighs 1
+    float weightedMean() const
+    {
+        if (count_ == 0) return 0.0f;
+        return weighted_sum_ / (count_ * (count_ + 1) / 2.0f);
+    }
+
+private:
+    void resync()
+    {
+        size_t start = (head_ + W - count_) % W;
+        sum_ = 0.0f;
+        weighted_sum_ = 0.0f;
+        mean_ = 0.0f;
+        m2_ = 0.0f;
+        for (size_t i = 0; i < count_; i++) {
+            float bpm = values_[(start + i) % W];
+            sum_ += bpm;
+            weighted_sum_ += (i + 1) * bpm;
+            float delta = bpm - mean_;
+            mean_ += delta / (i + 1);
+            m2_ += delta * (bpm - mean_);
+        }
+    }
+
+    float values_[W];
+    size_t head_ = 0;
+    size_t count_ = 0;
+    float sum_ = 0.0f;
+    float weighted_sum_ = 0.0f;
+    float mean_ = 0.0f;
+    float m2_ = 0.0f;
+};
+
+// Fixed-capacity compression timestamp history. Keeps the last N press times
+// in a ring and, as each one arrives, folds the new interval into two BPM
+// windows: the last R intervals (live feedback) and every stored interval
+// (test scoring). No heap, and push/evict/statistics are all O(1).
+template <size_t N, size_t R>
+class CompressionHistory {
+    static_assert(N >= 2, "need at least two timestamps for an interval");
+    static_assert(R >= 1 && R <= N - 1, "recent window must fit in the history");
+
+public:
+    CompressionHistory() { clear(); }
+
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+        recent_.clear();
+        full_.clear();
+    }
+
+    // Oldest timestamp is evicted once the history is full
+    void push_back(unsigned long time)
+    {
+        if (count_ > 0) {
+            unsigned long interval = time - back();
+            // a repeated timestamp has no defined rate, same as the old vector scan
+            if (interval == 0) return;
+            float bpm = 60000.0 / interval;
+            recent_.push(bpm);
+            full_.push(bpm);
+        }
+
+        times_[head_] = time;
+        head_ = (head_ + 1) % N;
+        if (count_ < N) count_++;
+    }
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    // i = 0 is the oldest stored timestamp
+    unsigned long operator[](size_t i) const { return times_[(head_ + N - count_ + i) % N]; }
+    unsigned long back() const { return times_[(head_ + N - 1) % N]; }
+
+    // min/max of the newest `intervals` intervals (ms)
+    void intervalRange(size_t intervals, unsigned long &min_interval, unsigned long &max_interval) const
+    {
+        min_interval = 0;
+        max_interval = 0;
+        if (count_ < 2) return;
+        if (intervals > count_ - 1) intervals = count_ - 1;
+        for (size_t i = count_ - intervals; i < count_; i++) {
+            unsigned long interval = (*this)[i] - (*this)[i - 1];
+            if (i == count_ - intervals || interval < min_interval) min_interval = interval;
+            if (interval > max_interval) max_interval = interval;
+        }
+    }
+
+    const SlidingBpmWindow<R> &recent() const { return recent_; }
+    const SlidingBpmWindow<N - 1> &full() const { return full_; }
+
+private:
+    unsigned long times_[N];
+    size_t head_;
+    size_t count_;
+    SlidingBpmWindow<R> recent_;
+    SlidingBpmWindow<N - 1> full_;
+};
+
+#endif
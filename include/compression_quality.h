@@ -0,0 +1,106 @@
+#ifndef COMPRESSION_QUALITY_H
+#define COMPRESSION_QUALITY_H
+
+#include <stdint.h>
+#include "compression_detector.h"
+
+// Quality of one compression cycle, from the onset of this press to the onset
+// of the next. Forces are grams above the detector's idle baseline.
+struct CompressionQuality {
+    enum Flags : uint8_t {
+        DEPTH_LOW = 1 << 0,
+        DEPTH_HIGH = 1 << 1,
+        INCOMPLETE_RECOIL = 1 << 2,
+        FINAL = 1 << 3,             // no next press: release_ms and duty are unknown (0)
+    };
+
+    unsigned long onset_time;       // ms, force started rising into this press
+    unsigned long press_time;       // ms, detector press (threshold crossing)
+    float peak_grams;               // depth proxy
+    float residual_grams;           // lowest force between peak and the next onset
+    uint16_t time_to_peak_ms;       // onset to peak
+    uint16_t press_ms;              // onset to unloaded (or to the valley when leaning)
+    uint16_t release_ms;            // unloaded to next onset
+    uint16_t interval_ms;           // previous press to this one, 0 for the first
+    uint8_t duty_pct;               // press_ms of the whole cycle
+    uint8_t flags;
+};
+
+enum QualityHint : uint8_t { HINT_NONE, HINT_PUSH_HARDER, HINT_PUSH_SOFTER, HINT_FULL_RECOIL };
+
+// Single-pass, constant-memory analytics on the filtered force and its slope.
+// Follows the detector's state to find each press and dates its onset back to
+// the last sample under the unloaded level, the same level that ends the press
+// phase, so duty is measured symmetrically. When the trainee leaned through
+// the gap the onset is the last sample whose slope wasn't rising. It keeps
+// running extremes and crossing times while the cycle is in progress and
+// emits one CompressionQuality when the next press starts (or
+// FINAL_TIMEOUT_MS after the last one). Running averages (1/8 per
+// compression) of duty and depth/recoil success back the OLED hint, so one
+// odd compression doesn't flip the message.
+//
+// Forces are measured from the detector's baseline, so a weight on the cell or
+// drift isn't read as leaning. During a run of compressions that zero may climb
+// no faster than ZERO_DRIFT_MAX_G_PER_MIN: the detector's baseline also follows
+// a trainee who starts leaning, and that lean is what the recoil check is for.
+//
+// The depth band is a force proxy for 5-6 cm and depends on the manikin's
+// spring; RECOIL_MAX_GRAMS is the AHA's 2.5 kg leaning limit.
+class QualityAnalyzer {
+public:
+    static constexpr float DEPTH_MIN_GRAMS = 25000.0f;
+    static constexpr float DEPTH_MAX_GRAMS = 50000.0f;
+    static constexpr float RECOIL_MAX_GRAMS = 2500.0f;
+    // the press phase ends when the force falls under a tenth of the amplitude, at least this
+    static constexpr float UNLOADED_MIN_GRAMS = 300.0f;
+    static constexpr unsigned long FINAL_TIMEOUT_MS = 2000;
+    // far above a warm cell's drift; a 4 kg lean stays over the limit for 20 s
+    static constexpr float ZERO_DRIFT_MAX_G_PER_MIN = 4000.0f;
+    // running success below this (percent) turns the hint on
+    static constexpr int HINT_BELOW_PCT = 50;
+
+    QualityAnalyzer() { reset(); }
+    void reset();
+
+    // One filtered sample (absolute grams, as fed to the detector, and slope
+    // in any unit) after detector.update(). Returns true when last() holds a
+    // new cycle.
+    bool update(float filtered, float slope, unsigned long now, const CompressionDetector &detector);
+
+    const CompressionQuality &last() const { return last_; }
+    unsigned long count() const { return count_; }
+
+    // running percentages; duty is 0 until a full cycle has been seen
+    int dutyPct() const { return duty_x16_ / 16; }
+    int depthOkPct() const { return depth_ok_x16_ / 16; }
+    int recoilOkPct() const { return recoil_ok_x16_ / 16; }
+    QualityHint hint() const;
+
+private:
+    void finish(unsigned long next_onset, bool final);
+    void start(float force, unsigned long now, const CompressionDetector &detector);
+
+    uint8_t prev_state_;
+    float zero_;
+    unsigned long zero_time_;
+    bool in_cycle_;
+    bool released_;                 // detector has seen the release
+    bool unloaded_;                 // force back under unloaded_level_ after the peak
+    float unloaded_level_;
+    unsigned long last_low_;        // last sample under the unloaded level
+    unsigned long last_flat_;       // last sample whose slope wasn't rising
+    unsigned long previous_press_;
+    float valley_;
+    unsigned long valley_time_;
+    unsigned long peak_time_;
+    unsigned long unloaded_time_;
+    CompressionQuality current_;
+    CompressionQuality last_;
+    unsigned long count_;
+    bool duty_seeded_;
+    int duty_x16_;
+    int depth_ok_x16_;
+    int recoil_ok_x16_;
+};
+
+#endif
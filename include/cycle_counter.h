@@ -0,0 +1,44 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Free-running timestamp for benchmarks. On the RA4M1 this is the Cortex-M4
+// DWT cycle counter (48 MHz core clock, wraps after ~89 s); on the host build
+// it is steady_clock nanoseconds. Differences of two reads are always valid
+// as long as the measured span is shorter than the wrap period.
+
+#if defined(ARDUINO_ARCH_RENESAS)
+
+#define CYCLE_COUNTER_UNIT "cycles"
+
+inline void cycleCounterBegin()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+inline uint32_t cycleCount()
+{
+    return DWT->CYCCNT;
+}
+
+#else
+
+#include <chrono>
+
+#define CYCLE_COUNTER_UNIT "ns"
+
+inline void cycleCounterBegin() {}
+
+inline uint32_t cycleCount()
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <Arduino.h>
+
+// Tokenized diagnostics. A call site such as
+//
+//   LOG_INFO("Download: %lu bytes in %lu ms", bytes, ms);
+//
+// compiles to a 16-bit id (FNV-1a of level and format, folded) plus its
+// arguments. The format string never reaches the firmware image.
+// tools/log_tokens.py finds every call site in the sources and writes the
+// id -> format dictionary as a build artifact. It also turns a capture back
+// into text. Sites below PULSECOACH_LOG_LEVEL compile to nothing, arguments
+// included.
+//
+// Records are queued in a RAM ring, so logging never waits for the UART.
+// logDrain() moves them out only as fast as the TX buffer takes them, from
+// idle time in loop(). When the ring is full a record is dropped and counted.
+// The R4 core's UART doesn't report its free TX space (availableForWrite() is
+// always 0), so with no room reported a pass writes LOG_BLIND_DRAIN bytes
+// anyway. At worst that waits for those few to go out.
+// On the wire, in between any plain text:
+//
+//   0x00 | u8 len | u16 id | varint dt_ms (since the previous record sent) | args
+//
+// with %d/%i as zigzag varints, %u/%x as varints, %f as a float32 and %s as
+// u8 len + up to LOG_MAX_STRING bytes. The argument types are checked
+// against the conversions at compile time. Not for use from interrupts.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef PULSECOACH_LOG_LEVEL
+#define PULSECOACH_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+constexpr size_t LOG_RING_SIZE = 256;
+constexpr size_t LOG_MAX_RECORD = 64;
+constexpr size_t LOG_MAX_STRING = 24;
+constexpr size_t LOG_BLIND_DRAIN = 4;
+constexpr uint8_t LOG_MARKER = 0x00;
+
+// argument kinds, two bits each in a signature
+constexpr uint8_t LOG_ARG_STRING = 0;
+constexpr uint8_t LOG_ARG_INT = 1;
+constexpr uint8_t LOG_ARG_UINT = 2;
+constexpr uint8_t LOG_ARG_FLOAT = 3;
+
+constexpr uint32_t logFnv1a(const char *s, uint32_t h)
+{
+    return *s ? logFnv1a(s + 1, (h ^ static_cast<uint8_t>(*s)) * 16777619UL) : h;
+}
+
+constexpr uint16_t logFold(uint32_t h)
+{
+    return static_cast<uint16_t>((h >> 16) ^ (h & 0xFFFF));
+}
+
+constexpr uint16_t logId(uint8_t level, const char *fmt)
+{
+    return logFold(logFnv1a(fmt, (2166136261UL ^ level) * 16777619UL));
+}
+
+constexpr bool logIsModifier(char c)
+{
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' || c == 'l' || c == 'h' || c == 'z' ||
+           (c >= '0' && c <= '9');
+}
+
+// Kind of the % spec that s (just past the '%') starts; LOG_SPEC_LITERAL for
+// "%%", LOG_SPEC_BAD for anything printf-like formatting can't carry here
+constexpr uint8_t LOG_SPEC_LITERAL = 4;
+constexpr uint8_t LOG_SPEC_BAD = 5;
+
+constexpr uint8_t logSpecKind(const char *s)
+{
+    return logIsModifier(*s) ? logSpecKind(s + 1)
+         : *s == '%' ? LOG_SPEC_LITERAL
+         : *s == 'd' || *s == 'i' ? LOG_ARG_INT
+         : *s == 'u' || *s == 'x' || *s == 'X' ? LOG_ARG_UINT
+         : *s == 'f' || *s == 'e' || *s == 'g' ? LOG_ARG_FLOAT
+         : *s == 's' ? LOG_ARG_STRING
+         : LOG_SPEC_BAD;
+}
+
+constexpr const char *logSpecEnd(const char *s)
+{
+    return logIsModifier(*s) ? logSpecEnd(s + 1) : *s ? s + 1 : s;
+}
+
+// Count in bits 0-3, then two bits of LOG_ARG_* per argument. A bad spec
+// gives a count of 15, which no call site matches.
+constexpr uint32_t logSignature(const char *fmt, uint32_t sig = 0)
+{
+    return *fmt == 0 ? sig
+         : *fmt != '%' ? logSignature(fmt + 1, sig)
+         : logSpecKind(fmt + 1) == LOG_SPEC_BAD ? 0xF
+         : logSpecKind(fmt + 1) == LOG_SPEC_LITERAL ? logSignature(logSpecEnd(fmt + 1), sig)
+         : logSignature(logSpecEnd(fmt + 1),
+                        (sig + 1) | (static_cast<uint32_t>(logSpecKind(fmt + 1)) << (4 + 2 * (sig & 0xF))));
+}
+
+template <typename T>
+constexpr uint8_t logKindOf()
+{
+    return std::is_floating_point<T>::value ? LOG_ARG_FLOAT
+         : std::is_integral<T>::value && std::is_signed<T>::value ? LOG_ARG_INT
+         : std::is_integral<T>::value ? LOG_ARG_UINT
+         : LOG_ARG_STRING;
+}
+
+template <uint32_t SIG, unsigned I>
+constexpr bool logArgsMatch()
+{
+    return true;
+}
+
+template <uint32_t SIG, unsigned I, typename T, typename... Rest>
+constexpr bool logArgsMatch()
+{
+    return ((SIG >> (4 + 2 * I)) & 3) == logKindOf<typename std::decay<T>::type>() && logArgsMatch<SIG, I + 1, Rest...>();
+}
+
+// Builds one record; the template keeps the per-argument code at the call site small
+class LogRecord {
+public:
+    explicit LogRecord(uint16_t id);
+    void add(int32_t v);
+    void add(uint32_t v);
+    void add(float v);
+    void add(const char *s);
+    void add(const String &s) { add(s.c_str()); }
+    // any other integer goes through the 32-bit paths
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type add(T v) { add(static_cast<int32_t>(v)); }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type add(T v) { add(static_cast<uint32_t>(v)); }
+    void add(double v) { add(static_cast<float>(v)); }
+    void commit();
+
+private:
+    // marker, len, id and the longest dt varint; commit() fills in the ones it uses
+    static constexpr size_t ARGS_AT = 9;
+
+    bool send();
+
+    uint8_t buf_[LOG_MAX_RECORD];
+    size_t len_;
+    uint16_t id_;
+    unsigned long ms_;
+};
+
+template <uint32_t SIG, typename... A>
+inline void logWrite(uint16_t id, const A &...args)
+{
+    static_assert((SIG & 0xF) == sizeof...(A), "log format and argument count differ (or a bad % spec)");
+    static_assert(logArgsMatch<SIG, 0, A...>(), "log argument type doesn't match its % conversion");
+    LogRecord record(id);
+    int expand[] = {0, (record.add(args), 0)...};
+    (void)expand;
+    record.commit();
+}
+
+// Sends queued records while out's TX buffer has room, or LOG_BLIND_DRAIN
+// bytes when out reports none
+void logDrain(Print &out);
+size_t logPending();
+unsigned long logDropped();
+
+#define LOG_AT(level, fmt, ...)                                          \
+    do {                                                                 \
+        if ((level) >= PULSECOACH_LOG_LEVEL) {                           \
+            constexpr uint16_t log_id = logId((level), fmt);             \
+            logWrite<logSignature(fmt)>(log_id, ##__VA_ARGS__);          \
+        }                                                                \
+    } while (0)
+
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Block kernels for the load-cell path in q15. On a core with the DSP
+// extension (__ARM_FEATURE_DSP, the RA4M1's Cortex-M4) the inner loops use the
+// dual 16-bit instructions: __SMLALD multiplies two tap pairs per cycle into a
+// 64-bit accumulator and __SHSUB16 forms two halved differences at once. The
+// scalar versions are bit-exact equivalents and are what the host build runs.
+// The dual-MAC kernels build there too, on portable versions of the two
+// instructions, so test/test_dsp_kernels can hold them to the scalar ones.
+
+// out[i] = sat16(round(sum_k reversed[k] * x[i + k] / 2^15)) for i < n, so x
+// holds taps - 1 samples of history (oldest first) followed by the n new
+// inputs, and `reversed` is the coefficients back to front; taps must be even.
+void firQ15Scalar(const int16_t *reversed, int taps, const int16_t *x, int16_t *out, size_t n);
+// d[n] = (y[n] - y[n - 2]) >> 1, with y[-2], y[-1] in prev[0], prev[1]
+void slopeQ15Scalar(const int16_t *prev, const int16_t *y, int16_t *d, size_t n);
+
+void firQ15Simd(const int16_t *reversed, int taps, const int16_t *x, int16_t *out, size_t n);
+void slopeQ15Simd(const int16_t *prev, const int16_t *y, int16_t *d, size_t n);
+
+// Force as the kernels see it: 2 g per LSB, so q15 spans +/-65 kg
+constexpr int32_t FORCE_Q15_GRAMS = 2;
+
+inline int16_t gramsToQ15(float grams)
+{
+    float lsb = grams / FORCE_Q15_GRAMS;
+    if (lsb > 32767.0f) return 32767;
+    if (lsb < -32768.0f) return -32768;
+    return static_cast<int16_t>(lsb < 0 ? lsb - 0.5f : lsb + 0.5f);
+}
+
+// Same for grams with frac_bits fractional bits (Hx711Driver::toGramsFixed), in integers only
+inline int16_t gramsFixedToQ15(int32_t grams, int frac_bits)
+{
+    const int32_t lsb_fixed = FORCE_Q15_GRAMS << frac_bits;
+    int32_t lsb = (grams < 0 ? grams - lsb_fixed / 2 : grams + lsb_fixed / 2) / lsb_fixed;
+    if (lsb > 32767) return 32767;
+    if (lsb < -32768) return -32768;
+    return static_cast<int16_t>(lsb);
+}
+
+// Low-pass and slope for up to BLOCK samples per call, with the FIR and
+// derivative history carried between calls. 8-tap Hamming-windowed sinc at
+// 10 Hz for 80 SPS: -1 dB at 5 Hz, -17 dB at 20 Hz, 3.5 samples of delay.
+class LoadCellBlockFilter {
+public:
+    static constexpr size_t BLOCK = 16;
+    static constexpr int TAPS = 8;
+
+    void reset();
+
+    // slope may be null; n <= BLOCK
+    void process(const int16_t *in, int16_t *out, int16_t *slope, size_t n);
+
+    // symmetric, so also in the reversed order the kernels take
+    static const int16_t LOWPASS[TAPS];
+
+private:
+    // TAPS - 1 history followed by the current block, contiguous for the kernel
+    int16_t window_[TAPS - 1 + BLOCK] = {};
+    int16_t prev_[2] = {};
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FEEDBACK_DISPLAY_H
+#define FEEDBACK_DISPLAY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+#include "compression_quality.h"
+
+enum PaceState : uint8_t { PACE_NONE, PACE_GOOD, PACE_TOO_FAST, PACE_TOO_SLOW };
+
+// MIN_BPM..MAX_BPM band with hysteresis: once inside, the readout only leaves
+// the band when the rate is hysteresis BPM past an edge, and it only comes
+// back in once it is hysteresis BPM inside, so it can't flicker at the edges.
+PaceState classifyPace(float bpm, PaceState previous, float hysteresis = 2.0f);
+
+// I2C time spent pushing pixels, against the loop time the caller reports
+struct DisplayStats {
+    unsigned long i2c_us;
+    unsigned long bytes;
+    unsigned long pages;
+    unsigned long redraws;
+};
+
+// Change-driven text renderer on top of the Adafruit framebuffer. Keeps the
+// last two lines it drew and a shadow of what the panel holds; a redraw only
+// happens when the text changes, and a flush only sends the SSD1306 pages
+// (and within them the column span) that differ from the shadow.
+class FeedbackDisplay {
+public:
+    FeedbackDisplay(Adafruit_SSD1306 &display, TwoWire &wire, uint8_t i2c_address);
+
+    // Show two centred lines; no-op when they are already on screen
+    bool showStacked(const char *line1, const char *line2);
+    bool showPace(PaceState state);
+    bool showHint(QualityHint hint);
+
+    // Forget what the panel holds, so the next flush sends every page
+    void invalidate();
+
+    const DisplayStats &stats() const { return stats_; }
+
+private:
+    void flush();
+    void command(const uint8_t *cmds, size_t len);
+
+    static constexpr int WIDTH = 128;
+    static constexpr int PAGES = 64 / 8;
+
+    Adafruit_SSD1306 &display_;
+    TwoWire &wire_;
+    uint8_t address_;
+    const char *line1_;
+    const char *line2_;
+    bool shadow_valid_;
+    uint8_t shadow_[WIDTH * PAGES];
+    DisplayStats stats_;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Erase-before-write storage the session log sits on. Addresses are offsets
+// from the start of the store. Programming is only allowed on erased bytes and
+// erases work on whole blocks; what an erased byte reads as is up to the part,
+// so callers ask isBlank() instead of comparing against 0xFF. Operations may
+// run in the background: start the next one only once busy() is false.
+class FlashStore {
+public:
+    virtual ~FlashStore() {}
+
+    virtual bool begin() = 0;
+    virtual size_t size() const = 0;
+    virtual size_t blockSize() const = 0;
+
+    virtual bool read(uint32_t address, uint8_t *out, size_t len) = 0;
+    virtual bool program(uint32_t address, const uint8_t *data, size_t len) = 0;
+    virtual bool eraseBlock(uint32_t address) = 0;
+    virtual bool isBlank(uint32_t address, size_t len) = 0;
+    virtual bool busy() = 0;
+};
+
+// A run of whole blocks of another store, so that several users can share one
+// part. Addresses are offsets from the start of the region.
+class FlashRegion : public FlashStore {
+public:
+    FlashRegion(FlashStore &base, uint32_t start, size_t size) : base_(base), start_(start), size_(size) {}
+
+    bool begin() override { return base_.begin(); }
+    size_t size() const override { return size_; }
+    size_t blockSize() const override { return base_.blockSize(); }
+
+    bool read(uint32_t address, uint8_t *out, size_t len) override;
+    bool program(uint32_t address, const uint8_t *data, size_t len) override;
+    bool eraseBlock(uint32_t address) override;
+    bool isBlank(uint32_t address, size_t len) override;
+    bool busy() override { return base_.busy(); }
+
+private:
+    FlashStore &base_;
+    uint32_t start_;
+    size_t size_;
+};
+
+// CRC-8/SMBUS (x^8 + x^2 + x + 1) for records kept in flash; pass the previous
+// result as crc to continue over another span
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc = 0);
+
+// RAM-backed store with the same rules, for the host build and for exercising
+// the log format on Linux. Programming a byte that is not erased fails, and
+// powerCutAfter(n) stops storing anything after n more programmed bytes, the
+// way a brown-out would leave a half-written record behind.
+class RamFlashStore : public FlashStore {
+public:
+    static constexpr uint8_t ERASED = 0xFF;
+
+    RamFlashStore(uint8_t *memory, size_t size, size_t block_size);
+
+    bool begin() override { return true; }
+    size_t size() const override { return size_; }
+    size_t blockSize() const override { return block_size_; }
+
+    bool read(uint32_t address, uint8_t *out, size_t len) override;
+    bool program(uint32_t address, const uint8_t *data, size_t len) override;
+    bool eraseBlock(uint32_t address) override;
+    bool isBlank(uint32_t address, size_t len) override;
+    bool busy() override { return false; }
+
+    // -1 = never
+    void powerCutAfter(long bytes) { cut_after_ = bytes; }
+    uint8_t *memory() { return memory_; }
+
+private:
+    uint8_t *memory_;
+    size_t size_;
+    size_t block_size_;
+    long cut_after_ = -1;
+};
+
+#if defined(ARDUINO_ARCH_RENESAS)
+
+// The RA4M1's 8 KB data flash (1 KB erase blocks, 1-byte program unit)
+// through the FSP low-power flash driver. Reads are memory-mapped; program
+// and erase run without BGO, so each call returns once the operation is done
+// (tens of us per byte, ~10 ms per block erase) and busy() is always false.
+class DataFlashStore : public FlashStore {
+public:
+    static constexpr uint32_t START = 0x40100000UL;
+    static constexpr size_t SIZE = 8 * 1024;
+    static constexpr size_t BLOCK = 1024;
+
+    bool begin() override;
+    size_t size() const override { return SIZE; }
+    size_t blockSize() const override { return BLOCK; }
+
+    bool read(uint32_t address, uint8_t *out, size_t len) override;
+    bool program(uint32_t address, const uint8_t *data, size_t len) override;
+    bool eraseBlock(uint32_t address) override;
+    bool isBlank(uint32_t address, size_t len) override;
+    bool busy() override { return false; }
+
+private:
+    bool open_ = false;
+};
+
+#endif
+
+#endif
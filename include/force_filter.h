@@ -0,0 +1,79 @@
+#ifndef FORCE_FILTER_H
+#define FORCE_FILTER_H
+
+#include <stdint.h>
+
+// Streaming conditioning for the load-cell force, one sample per call and O(1).
+// Both stages keep their state in Q8 fixed point (1/256 g), so a slow filter
+// does not lose the sub-gram steps a float would round away near 30 kg.
+
+constexpr int FORCE_FRAC_BITS = 8;
+// just under +/-4.2 t: the Q8 value stays below 2^30 in magnitude, so the
+// difference of two of them stays inside int32
+constexpr int32_t FORCE_LIMIT_GRAMS = (1L << 22) - 1;
+
+inline int32_t clampForce(int32_t grams)
+{
+    if (grams > FORCE_LIMIT_GRAMS) return FORCE_LIMIT_GRAMS;
+    if (grams < -FORCE_LIMIT_GRAMS) return -FORCE_LIMIT_GRAMS;
+    return grams;
+}
+
+// Single-pole IIR low-pass, y += (x - y) / 2^shift. shift 1 at 80 SPS puts the
+// -3 dB point near 9 Hz, well above the 2 Hz compression fundamental, for one
+// sample of delay.
+class FixedLowPass {
+public:
+    explicit FixedLowPass(uint8_t shift = 1) : shift_(shift) {}
+
+    void reset() { primed_ = false; }
+
+    int32_t update(int32_t grams)
+    {
+        int32_t x = clampForce(grams) * (1L << FORCE_FRAC_BITS);
+        if (!primed_) {
+            acc_ = x;
+            primed_ = true;
+        }
+        acc_ += (x - acc_) >> shift_;
+        return acc_ >> FORCE_FRAC_BITS;
+    }
+
+    int32_t value() const { return acc_ >> FORCE_FRAC_BITS; }
+
+private:
+    uint8_t shift_;
+    bool primed_ = false;
+    int32_t acc_ = 0;
+};
+
+// Zero-force level the detector measures against. It follows the signal with a
+// long time constant (2^shift samples, 1.6 s at shift 7) but only while the
+// caller says the cell is idle, so a compression never drags it upwards.
+class BaselineTracker {
+public:
+    explicit BaselineTracker(uint8_t shift = 7) : shift_(shift) {}
+
+    void reset() { primed_ = false; }
+
+    // The first idle sample seeds the level so a cell that drifted since tare starts right
+    void update(int32_t grams, bool idle)
+    {
+        if (!idle) return;
+        int32_t x = clampForce(grams) * (1L << FORCE_FRAC_BITS);
+        if (!primed_) {
+            acc_ = x;
+            primed_ = true;
+        }
+        acc_ += (x - acc_) >> shift_;
+    }
+
+    int32_t value() const { return acc_ >> FORCE_FRAC_BITS; }
+
+private:
+    uint8_t shift_;
+    bool primed_ = false;
+    int32_t acc_ = 0;
+};
+
+#endif
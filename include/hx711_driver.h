@@ -0,0 +1,89 @@
+#ifndef HX711_DRIVER_H
+#define HX711_DRIVER_H
+
+#include <stdint.h>
+
+// One conversion with the time DOUT was seen low
+struct Hx711Reading {
+    int32_t raw;                // signed 24-bit result
+    unsigned long timestamp;    // micros()
+};
+
+// HX711 driver that never waits: tryRead() returns false straight away when no
+// conversion is pending, and a read clocks the 24 data bits plus the gain
+// pulses out either through direct port-register writes (BITBANG) or through
+// the SPI peripheral with MOSI wired to PD_SCK and MISO to DOUT (SPI_MOSI).
+// With SPI each MOSI '1' bit is one PD_SCK pulse and DOUT is sampled during
+// the following '0' bit, so the whole frame is seven bytes clocked in hardware.
+//
+// The output rate is set by the HX711's RATE pin: low = 10 SPS, high = 80 SPS.
+// Pass its Arduino pin to begin() if it is wired, otherwise the board's strap
+// decides.
+class Hx711Driver {
+public:
+    // value = PD_SCK pulses after the data bits
+    enum Gain : uint8_t { CHANNEL_A_128 = 1, CHANNEL_B_32 = 2, CHANNEL_A_64 = 3 };
+    enum Backend : uint8_t { BITBANG, SPI_MOSI };
+
+    bool begin(int dout, int sck, Gain gain = CHANNEL_A_128, Backend backend = BITBANG, int rate_pin = -1);
+
+    // Selects channel/gain for the conversion after the next read
+    void setGain(Gain gain) { gain_ = gain; }
+    Gain gain() const { return gain_; }
+    void setFastRate(bool fast);
+
+    bool isReady() const;
+    bool tryRead(Hx711Reading &reading);
+
+    void powerDown();
+    void powerUp();
+
+    // Blocking average of `times` conversions into the offset; for setup only
+    bool tare(int times = 10, unsigned long timeout_ms = 1000);
+    void setOffset(int32_t offset) { offset_ = offset; }
+    int32_t offset() const { return offset_; }
+
+    // grams = grams_per_count * d + curve * d^2 with d = raw - offset. Both terms are
+    // turned into fixed-point multipliers here, so a conversion is two
+    // multiplies and shifts with no divide. Returns false (and keeps the old
+    // ones) if a coefficient is out of their range.
+    bool setCalibration(float grams_per_count, float curve = 0.0f);
+    float gramsPerCount() const { return grams_per_count_; }
+    float curve() const { return curve_; }
+    // grams with GRAMS_FRAC_BITS fractional bits
+    int32_t toGramsFixed(int32_t raw) const;
+    float toGrams(int32_t raw) const { return toGramsFixed(raw) * (1.0f / (1 << GRAMS_FRAC_BITS)); }
+
+    static constexpr int GRAMS_FRAC_BITS = 8;
+    static constexpr int GAIN_FRAC_BITS = 30;      // up to 2 g/count
+    static constexpr int CURVE_FRAC_BITS = 56;     // applied to d^2 / 2^16
+
+    int doutPin() const { return dout_; }
+    int sckPin() const { return sck_; }
+    int ratePin() const { return rate_pin_; }
+    Backend backend() const { return backend_; }
+
+private:
+    uint32_t shiftInBitBang();
+    uint32_t shiftInSpi();
+
+    int dout_ = -1;
+    int sck_ = -1;
+    int rate_pin_ = -1;
+    Gain gain_ = CHANNEL_A_128;
+    Backend backend_ = BITBANG;
+    int32_t offset_ = 0;
+    float grams_per_count_ = 1.0f;
+    float curve_ = 0.0f;
+    int32_t gain_q_ = 1L << GAIN_FRAC_BITS;
+    int32_t curve_q_ = 0;
+
+    // port registers for BITBANG (unused on the host, where the pin shim is used)
+    volatile uint16_t *sck_set_ = nullptr;
+    volatile uint16_t *sck_clear_ = nullptr;
+    volatile const uint16_t *dout_in_ = nullptr;
+    uint16_t sck_mask_ = 0;
+    uint16_t dout_mask_ = 0;
+};
+
+#endif
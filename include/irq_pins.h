@@ -0,0 +1,14 @@
+#ifndef IRQ_PINS_H
+#define IRQ_PINS_H
+
+// Digital pins attachInterrupt() works on. The UNO R4 core passes any pin
+// through digitalPinToInterrupt() and quietly attaches nothing to one without
+// an ICU channel (D4 and D7 among them), so this is the list Arduino documents
+// for the board rather than whatever the core accepts. The host sim refuses
+// the other pins the same way.
+inline bool pinHasIrq(int pin)
+{
+    return pin == 2 || pin == 3;
+}
+
+#endif
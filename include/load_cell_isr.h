@@ -0,0 +1,32 @@
+#ifndef LOAD_CELL_ISR_H
+#define LOAD_CELL_ISR_H
+
+#include <stdint.h>
+#include "hx711_driver.h"
+
+// One HX711 conversion as read from the DRDY interrupt
+struct LoadCellSample {
+    unsigned long timestamp;  // millis() when DOUT went low
+    int32_t raw;              // signed 24-bit conversion result at the driver's gain
+    unsigned long micros;     // acquisition time from the driver, for jitter checks
+};
+
+// Attach the DOUT falling-edge interrupt; samples are clocked out in the ISR
+// through the driver. Call after the blocking tare so the two readers never overlap.
+// Returns false when DOUT is on a pin without an interrupt: loadCellPoll()
+// then reads each conversion into the same ring.
+bool loadCellIsrBegin(Hx711Driver &driver);
+
+void loadCellIsrEnd();
+
+// Reads a waiting conversion when DOUT has no interrupt, otherwise does
+// nothing. Call at least once per conversion period (12.5 ms at 80 SPS).
+void loadCellPoll();
+
+// Take the oldest queued sample, false when nothing has arrived since the last call
+bool loadCellPop(LoadCellSample &sample);
+
+// Samples dropped because loop() did not drain the ring in time
+uint32_t loadCellOverruns();
+
+#endif
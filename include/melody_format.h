@@ -0,0 +1,141 @@
+#ifndef MELODY_FORMAT_H
+#define MELODY_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Packed melody: two bytes per note, compiled from a readable song string at
+// build time and kept in flash.
+//
+// Song syntax: whitespace separated NOTE/DIVIDER tokens, e.g. "E5/4 B4/8 R/8 GS5/4.".
+// NOTE is a letter, an optional sharp ('S' or '#') and an octave from B0 to DS8,
+// or R for a rest. DIVIDER is 1, 2, 4, ... 64 (4 = quarter note) and a trailing
+// '.' makes the note dotted. '|' can separate bars and is ignored.
+
+struct PackedNote {
+    uint8_t note;   // 0 = rest, otherwise index into NOTE_FREQUENCIES
+    uint8_t code;   // bits 0-2: log2(divider), bit 3: dotted
+};
+
+constexpr uint8_t NOTE_REST = 0;
+constexpr uint8_t DURATION_DOTTED = 0x08;
+constexpr uint8_t DURATION_SHIFT_MASK = 0x07;
+
+// equal temperament, B0 (index 1) to DS8 (index 89), rounded like the NOTE_ macros
+constexpr uint16_t NOTE_FREQUENCIES[] = {
+    0,
+    31,
+    33, 35, 37, 39, 41, 44, 46, 49, 52, 55, 58, 62,
+    65, 69, 73, 78, 82, 87, 93, 98, 104, 110, 117, 123,
+    131, 139, 147, 156, 165, 175, 185, 196, 208, 220, 233, 247,
+    262, 277, 294, 311, 330, 349, 370, 392, 415, 440, 466, 494,
+    523, 554, 587, 622, 659, 698, 740, 784, 831, 880, 932, 988,
+    1047, 1109, 1175, 1245, 1319, 1397, 1480, 1568, 1661, 1760, 1865, 1976,
+    2093, 2217, 2349, 2489, 2637, 2794, 2960, 3136, 3322, 3520, 3729, 3951,
+    4186, 4435, 4699, 4978,
+};
+constexpr size_t NOTE_COUNT = sizeof(NOTE_FREQUENCIES) / sizeof(NOTE_FREQUENCIES[0]);
+
+inline uint16_t noteFrequency(PackedNote n) { return n.note < NOTE_COUNT ? NOTE_FREQUENCIES[n.note] : 0; }
+
+// length of the note given the length of a whole note
+inline unsigned long noteDuration(PackedNote n, unsigned long whole_note)
+{
+    unsigned long duration = whole_note >> (n.code & DURATION_SHIFT_MASK);
+    if (n.code & DURATION_DOTTED) duration += duration / 2;
+    return duration;
+}
+
+template <size_t N>
+struct PackedSong {
+    PackedNote notes[N];
+    static constexpr size_t size() { return N; }
+};
+
+namespace song_compiler {
+
+// never defined: reaching it while compiling a song makes the constant
+// expression invalid, so a typo in a song string is a build error
+void syntaxError(const char *what);
+
+constexpr bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == '|'; }
+
+constexpr size_t countNotes(const char *s)
+{
+    size_t n = 0;
+    for (size_t i = 0; s[i]; i++) {
+        if (!isSpace(s[i]) && (i == 0 || isSpace(s[i - 1]))) n++;
+    }
+    return n;
+}
+
+constexpr size_t skipSpace(const char *s, size_t i)
+{
+    while (s[i] && isSpace(s[i])) i++;
+    return i;
+}
+
+// semitone offsets of C D E F G A B
+constexpr int letterSemitone(char c)
+{
+    return c == 'C' ? 0 : c == 'D' ? 2 : c == 'E' ? 4 : c == 'F' ? 5 : c == 'G' ? 7 : c == 'A' ? 9 : c == 'B' ? 11 : -1;
+}
+
+constexpr PackedNote parseNote(const char *s, size_t &i)
+{
+    PackedNote out = {NOTE_REST, 0};
+    if (s[i] == 'R') {
+        i++;
+    } else {
+        int semitone = letterSemitone(s[i]);
+        if (semitone < 0) syntaxError("unknown note letter");
+        i++;
+        if (s[i] == 'S' || s[i] == '#') {
+            semitone++;
+            i++;
+        }
+        if (s[i] < '0' || s[i] > '8') syntaxError("missing octave");
+        semitone += (s[i] - '0') * 12;
+        i++;
+        // B0 is index 1
+        int index = semitone - 11 + 1;
+        if (index < 1 || index >= static_cast<int>(NOTE_COUNT)) syntaxError("note out of range");
+        out.note = static_cast<uint8_t>(index);
+    }
+
+    if (s[i] != '/') syntaxError("expected '/' before the divider");
+    i++;
+    int divider = 0;
+    while (s[i] >= '0' && s[i] <= '9') divider = divider * 10 + (s[i++] - '0');
+    int shift = -1;
+    for (int b = 0; b <= 6; b++) {
+        if (divider == (1 << b)) shift = b;
+    }
+    if (shift < 0) syntaxError("divider must be 1, 2, 4, ... 64");
+    out.code = static_cast<uint8_t>(shift);
+    if (s[i] == '.') {
+        out.code |= DURATION_DOTTED;
+        i++;
+    }
+    if (s[i] && !isSpace(s[i])) syntaxError("junk after note");
+    return out;
+}
+
+template <size_t N>
+constexpr PackedSong<N> compile(const char *s)
+{
+    PackedSong<N> song = {};
+    size_t i = skipSpace(s, 0);
+    for (size_t n = 0; n < N; n++) {
+        song.notes[n] = parseNote(s, i);
+        i = skipSpace(s, i);
+    }
+    return song;
+}
+
+}
+
+// constexpr auto TUNE = SONG("E5/4 B4/8 C5/8");
+#define SONG(text) song_compiler::compile<song_compiler::countNotes(text)>(text)
+
+#endif
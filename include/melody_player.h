@@ -0,0 +1,61 @@
+#ifndef MELODY_PLAYER_H
+#define MELODY_PLAYER_H
+
+#include <Arduino.h>
+#include <FspTimer.h>
+#include <pwm.h>
+#include "melody_format.h"
+
+struct MelodyStats {
+    unsigned long onsets;
+    unsigned long max_error_us;    // worst note start after its ideal time
+    unsigned long total_error_us;
+};
+
+// Plays a song in the background. A hardware timer ticks every TICK_US and its
+// ISR starts each note on the speaker's PWM output once the note's ideal onset
+// has passed, so nothing in loop() can delay a note by more than one tick.
+// Onsets are kept on an ideal grid (each note starts exactly one note length
+// after the previous ideal onset) and the tempo can change between notes.
+class MelodyPlayer {
+public:
+    static constexpr unsigned long TICK_US = 250;
+
+    explicit MelodyPlayer(int pin) : pwm_(pin) {}
+
+    bool begin();
+    void play(char song, bool repeat = true);
+    void stop();
+    bool playing() const { return playing_; }
+
+    // quarter notes per minute, from the next note on
+    void setTempo(float bpm);
+    float tempo() const { return 240000000.0f / whole_note_us_; }
+
+    MelodyStats stats() const;
+    void resetStats();
+
+private:
+    static void onTick(timer_callback_args_t *args);
+    void tick(unsigned long now);
+
+    PwmOut pwm_;
+    FspTimer timer_;
+    bool ready_ = false;
+
+    const PackedNote *melody_ = nullptr;
+    int notes_ = 0;
+    bool repeat_ = false;
+    volatile bool playing_ = false;
+    volatile unsigned long whole_note_us_ = 240000000UL / 103;
+
+    // only touched by the ISR while playing
+    int index_ = 0;
+    unsigned long next_onset_ = 0;
+    unsigned long note_off_ = 0;
+    bool sounding_ = false;
+    bool finishing_ = false;
+    MelodyStats stats_ = {0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef MODE_BUTTON_H
+#define MODE_BUTTON_H
+
+#include <Arduino.h>
+#include <FspTimer.h>
+#include "sample_ring.h"
+
+enum ButtonEvent : uint8_t { BUTTON_NONE, BUTTON_SHORT, BUTTON_LONG };
+
+// A debounced level change, stamped with the first edge of its bounce
+struct ButtonEdge {
+    bool down;
+    unsigned long us;   // micros() in the edge interrupt
+};
+
+struct ButtonStats {
+    unsigned long events;
+    unsigned long max_latency_us;     // debounced edge to the application acting on it
+    unsigned long total_latency_us;
+    unsigned long bounces;            // edge bursts that settled back where they started
+};
+
+// Active-low push button on a pin-change interrupt. The first edge arms a
+// one-shot hardware timer and edges inside its window are ignored; when it
+// expires the pin is read once and, if the level really changed, the edge goes
+// into a queue with the time of that first edge. poll() turns the queued edges
+// into short presses (on release) and long presses (once held LONG_PRESS_MS).
+class ModeButton {
+public:
+    static constexpr unsigned long SETTLE_US = 10000;
+    static constexpr unsigned long LONG_PRESS_MS = 3000;
+
+    explicit ModeButton(int pin) : pin_(pin) {}
+
+    // false when the pin has no interrupt or no timer is free: the button is dead
+    bool begin();
+
+    // Next press, if any. Call from loop() context only.
+    ButtonEvent poll(unsigned long now_us);
+    // The application acted on the last event poll() returned; counts its latency
+    void handled(unsigned long now_us);
+
+    bool down() const { return down_; }
+    // a debounced edge is waiting for poll(); for waking from sleep
+    bool pending() const { return !edges_.empty(); }
+    unsigned long lastEdgeMicros() const { return last_edge_us_; }
+    ButtonStats stats() const;
+    void resetStats();
+    // edges lost because poll() fell behind
+    uint32_t overruns() const { return edges_.overruns(); }
+
+private:
+    static void onEdge();
+    static void onSettled(timer_callback_args_t *args);
+    void settled();
+
+    static ModeButton *instance_;
+
+    int pin_;
+    FspTimer timer_;
+    SpscRing<ButtonEdge, 8> edges_;
+
+    // ISR side
+    volatile bool armed_ = false;
+    bool stable_down_ = false;
+    unsigned long first_edge_us_ = 0;
+    volatile unsigned long last_edge_us_ = 0;
+    volatile unsigned long bounces_ = 0;
+
+    // loop side
+    bool down_ = false;
+    bool long_sent_ = false;
+    unsigned long down_us_ = 0;
+    unsigned long event_us_ = 0;
+    ButtonStats stats_ = {0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef NOTIFY_QUEUE_H
+#define NOTIFY_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoBLE.h>
+
+struct NotifyStats {
+    unsigned long sent;
+    unsigned long coalesced;         // values replaced by a newer one before they went out
+    unsigned long dropped;           // refused, or a stream item pushed out, because every slot was taken
+    unsigned long waits;             // writes that waited for a radio buffer
+    unsigned long max_latency_us;    // push to writeValue() returning
+    unsigned long total_latency_us;
+    size_t max_depth;
+};
+
+// Outgoing characteristic values, written from one task instead of inline
+// where they are produced. A value replaces an older one of the same
+// characteristic that is still waiting, since the central only needs the latest
+// BPM or result. Stream items (waveform frames, telemetry batches, download
+// chunks) queue behind each other instead. With every slot taken a new stream
+// item is dropped and counted, so push() never waits for the radio. A new value
+// takes the oldest stream item's slot instead: the streams carry sequence
+// numbers and the download goes back on a NAK, but a lost result is just gone.
+//
+// writeValue() itself blocks while the radio's buffers are full. After a write
+// that waited, send() paces writes a little wider than the longest wait seen,
+// which is about one connection interval, so the next one finds a free buffer.
+// The pacing eases off by 1/8 after every write that went straight through.
+class NotifyQueue {
+public:
+    static constexpr size_t SLOTS = 8;
+    static constexpr size_t MAX_VALUE = 244;
+    // a write that took longer waited for a radio buffer: the link is congested
+    static constexpr unsigned long CONGESTED_US = 2000;
+
+    bool push(BLECharacteristic &characteristic, const uint8_t *value, size_t len, bool stream = false);
+    // an int characteristic's value, little-endian like BLEIntCharacteristic
+    bool push(BLECharacteristic &characteristic, int32_t value);
+
+    // Writes up to max values, oldest first, as the pacing allows. Returns how
+    // many went out.
+    int send(int max);
+
+    size_t depth() const { return depth_; }
+    size_t available() const { return SLOTS - depth_; }
+
+    NotifyStats stats() const { return stats_; }
+    void resetStats();
+
+private:
+    struct Slot {
+        BLECharacteristic *characteristic;
+        uint32_t seq;                // push order; the lowest goes out first
+        unsigned long queued_us;
+        uint16_t len;
+        bool used;
+        bool stream;
+        uint8_t value[MAX_VALUE];
+    };
+
+    Slot slots_[SLOTS] = {};
+    size_t depth_ = 0;
+    uint32_t seq_ = 0;
+    unsigned long spacing_us_ = 0;   // 0 = not congested
+    unsigned long next_write_us_ = 0;
+    NotifyStats stats_ = {0, 0, 0, 0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef POWER_MONITOR_H
+#define POWER_MONITOR_H
+
+#include <stdint.h>
+
+// One report window, all times in microseconds
+struct PowerReport {
+    unsigned long window_us;
+    unsigned long awake_us;        // MCU running rather than in WFI
+    unsigned long load_cell_us;    // HX711 powered up
+    uint32_t current_ua;           // estimated average supply current
+    unsigned long wakes;           // returns from idle to full rate
+    unsigned long max_wake_us;     // trigger to the first full-rate sample
+    unsigned long total_wake_us;
+};
+
+// Estimates the average supply current from the time each part spends in each
+// power state, at typical datasheet currents. It only covers what the firmware
+// switches: the RA4M1 (running vs WFI sleep), the HX711 (converting vs powered
+// down) and the BLE advertising events. The ESP32-S3's own baseline and the
+// OLED are left out, so compare reports with each other, not with a meter.
+class PowerMonitor {
+public:
+    static constexpr uint32_t MCU_RUN_UA = 6000;          // 48 MHz, flash cache on
+    static constexpr uint32_t MCU_SLEEP_UA = 2500;        // sleep mode, peripherals clocked
+    static constexpr uint32_t LOAD_CELL_UA = 1500;
+    static constexpr uint32_t LOAD_CELL_DOWN_UA = 1;
+    static constexpr uint32_t ADVERTISING_EVENT_UC = 120; // one event on all three channels
+
+    void begin(unsigned long now_us);
+
+    // WFI until the next interrupt, counting the time asleep
+    void sleep();
+    void setLoadCell(bool on, unsigned long now_us);
+    // advertising interval in 0.625 ms units, 0 when not advertising
+    void setAdvertising(uint16_t interval, unsigned long now_us);
+    void addWake(unsigned long latency_us);
+
+    // The window since the last report; starts a new one
+    PowerReport report(unsigned long now_us);
+
+private:
+    void account(unsigned long now_us);
+
+    unsigned long window_start_ = 0;
+    unsigned long last_us_ = 0;
+    unsigned long asleep_us_ = 0;
+    unsigned long load_cell_us_ = 0;
+    uint64_t advertising_ = 0;     // uC x 10^6: over the window in us it is uA
+    bool load_cell_on_ = false;
+    uint16_t interval_ = 0;
+    unsigned long wakes_ = 0;
+    unsigned long max_wake_us_ = 0;
+    unsigned long total_wake_us_ = 0;
+};
+
+#endif
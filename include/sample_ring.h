@@ -0,0 +1,55 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Fixed-size single-producer/single-consumer ring. The producer (usually an
+// ISR) only writes head_, the consumer (loop) only writes tail_, so no locks
+// or interrupt masking are needed. N must be a power of two.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    // Producer side. Drops the sample and counts an overrun when full.
+    bool push(const T &item)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            overruns_.store(overruns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool pop(T &item)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+    uint32_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    T items_[N];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint32_t> overruns_{0};
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+typedef void (*TaskFn)();
+
+// Per-task timing bookkeeping, all in microseconds
+struct TaskStats {
+    unsigned long runs;
+    unsigned long missed;     // deadlines skipped because the task started a whole period late
+    unsigned long overruns;   // runs that took longer than the task's budget
+    unsigned long max_late;   // worst start time past the deadline
+    unsigned long max_run;    // worst run time
+};
+
+struct Task {
+    const char *name;
+    TaskFn fn;
+    unsigned long period;     // 0 = one-shot
+    unsigned long budget;
+    unsigned long next_due;
+    bool active;
+    TaskStats stats;
+};
+
+// Cooperative deadline scheduler. Tasks are plain functions that must return
+// promptly (no delay()); each has its own period or is a one-shot that gets
+// armed with a delay. run() is called from loop() as often as possible and
+// starts every task whose deadline has passed. Late periodic tasks are not
+// replayed in a burst: missed deadlines are counted and the task is realigned
+// to its period grid. Times are micros() and wrap-safe.
+class Scheduler {
+public:
+    static constexpr int MAX_TASKS = 16;
+
+    // Returns the task id, or -1 when the table is full. Periodic tasks start
+    // active with their first run offset from now; one-shots start idle.
+    int addPeriodic(const char *name, TaskFn fn, unsigned long period_us, unsigned long budget_us,
+                    unsigned long offset_us = 0);
+    int addOneShot(const char *name, TaskFn fn, unsigned long budget_us);
+
+    // (Re)arm a task to run delay_us from now; a periodic task keeps its period afterwards
+    void start(int id, unsigned long delay_us = 0);
+    void stop(int id);
+    bool isActive(int id) const;
+    void setPeriod(int id, unsigned long period_us);
+
+    void run(unsigned long now);
+
+    // Time until the earliest active deadline (0 if something is already due)
+    unsigned long timeUntilNext(unsigned long now) const;
+
+    int count() const { return count_; }
+    const Task &task(int id) const { return tasks_[id]; }
+    void resetStats();
+
+private:
+    int add(const char *name, TaskFn fn, unsigned long period_us, unsigned long budget_us);
+
+    Task tasks_[MAX_TASKS];
+    int count_ = 0;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "compression_quality.h"
+#include "flash_store.h"
+
+// Append-only log of testing sessions in flash, kept as a ring of erase
+// blocks. Each block starts with a header, and then records follow:
+//
+//   block header  u16 magic | u8 version | u8 crc8 | u32 seq (grows by one per block)
+//   record        u8 type | u8 len | payload[len] | u8 crc8(type..payload) | u8 commit
+//
+// The commit byte is programmed on its own after the rest of the record, so
+// a record torn by a reset has no commit and is skipped on the next mount.
+// When a record doesn't fit the active block, the next block in the ring is
+// erased (dropping the oldest data), so wear spreads evenly over all blocks.
+//
+// Payloads are varints (see waveform_codec.h):
+//   SESSION_START  session | start_ms
+//   COMPRESSIONS   per compression: dt_ms (from the previous press, or the
+//                  session start) | zigzag delta of peak_10g | residual_100g |
+//                  duty_pct | flags
+//   SESSION_END    session | duration_ms | compressions | avg_bpm_x10 |
+//                  accuracy_pct | consistency_pct | flags (END_ABORTED)
+//
+// The append calls only encode into a small RAM queue, which takes O(1).
+// pump() then does at most one flash operation per call, chunked to
+// PUMP_CHUNK bytes, so it can run from a low-priority task.
+class SessionLog {
+public:
+    enum RecordType : uint8_t { SESSION_START = 1, COMPRESSIONS = 2, SESSION_END = 3 };
+    enum EndFlags : uint8_t { END_ABORTED = 1 };
+
+    static constexpr uint16_t MAGIC = 0x4C53;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr uint8_t COMMIT = 0xA5;
+    static constexpr size_t MAX_PAYLOAD = 48;
+    static constexpr size_t QUEUE = 4;
+    static constexpr size_t PUMP_CHUNK = 16;
+    static constexpr uint8_t MAX_FAILURES = 3;
+
+    struct Record {
+        uint8_t type;
+        uint8_t len;
+        uint8_t payload[MAX_PAYLOAD];
+    };
+
+    struct Summary {
+        float avg_bpm;
+        float accuracy;       // 0-1
+        float consistency;    // 0-1
+    };
+
+    // Position of the next record for next(); start from begin()
+    struct Cursor {
+        uint8_t age;          // 0 = oldest block
+        uint16_t offset;
+    };
+
+    explicit SessionLog(FlashStore &flash) : flash_(flash) {}
+
+    // Scans the blocks for the newest one and its end. Blocks with a bad
+    // header count as free, and reading a block stops at its first bad record.
+    // Returns false if the flash didn't open.
+    bool mount();
+
+    void beginSession(unsigned long now);
+    void addCompression(const CompressionQuality &quality);
+    void endSession(unsigned long now, const Summary &summary, uint8_t flags = 0);
+    bool inSession() const { return in_session_; }
+
+    // One flash operation at most; call every few ms
+    void pump();
+    bool idle() const { return step_ == STEP_IDLE && queued_ == 0; }
+
+    Cursor begin() const { return Cursor{0, HEADER_SIZE}; }
+    // Reads the committed record at the cursor and advances it; false at the end of the log
+    bool next(Cursor &cursor, Record &record);
+
+    uint16_t sessions() const { return next_session_; }
+    unsigned long records() const { return records_; }
+    unsigned long dropped() const { return dropped_; }
+    unsigned long failures() const { return failures_; }
+    size_t blocks() const { return blocks_; }
+    // Sequence number of the oldest block (0 while empty). It changes only
+    // when the oldest block is erased, so positions in the log stay valid while it holds.
+    uint32_t oldestSeq() const { return valid_blocks_ ? seq_ - (valid_blocks_ - 1) : 0; }
+
+private:
+    enum Step : uint8_t { STEP_IDLE, STEP_ERASE, STEP_HEADER, STEP_BODY, STEP_COMMIT };
+
+    bool readHeader(size_t block, uint32_t &seq);
+    // scans one block's records; returns the offset after the last good one
+    size_t scanBlock(size_t block, bool count_sessions);
+    bool readRecordAt(uint32_t address, size_t limit, Record &record);
+    uint8_t physicalBlock(uint8_t age) const;
+
+    bool enqueue(const Record &record);
+    void flushCompressions();
+    void startRecord(uint8_t type);
+    void putVarint(Record &record, uint32_t value);
+
+    FlashStore &flash_;
+    size_t block_size_ = 0;
+    size_t blocks_ = 0;
+    bool mounted_ = false;
+
+    // write side
+    bool has_active_ = false;
+    uint8_t active_ = 0;
+    uint8_t target_ = 0;           // block being erased for the next header
+    uint8_t valid_blocks_ = 0;     // blocks holding log data, ending at active_
+    uint32_t seq_ = 0;
+    uint32_t pos_ = 0;             // offset inside the active block
+    bool sealed_ = false;          // active block can't take more records
+    Step step_ = STEP_IDLE;
+    uint8_t out_[MAX_PAYLOAD + 3];
+    size_t out_len_ = 0;
+    size_t out_done_ = 0;
+    uint8_t consecutive_failures_ = 0;
+
+    Record queue_[QUEUE];
+    size_t head_ = 0;
+    size_t queued_ = 0;
+
+    // session being recorded
+    bool in_session_ = false;
+    uint16_t session_ = 0;
+    uint16_t next_session_ = 0;
+    unsigned long session_start_ = 0;
+    unsigned long last_press_ = 0;
+    int32_t last_peak_ = 0;
+    uint32_t session_compressions_ = 0;
+    Record building_;
+
+    unsigned long records_ = 0;
+    unsigned long dropped_ = 0;
+    unsigned long failures_ = 0;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "compression_quality.h"
+
+// Batched compression telemetry. One notification carries as many records as
+// fit the negotiated ATT payload (MTU - 3), all little-endian:
+//
+//   header  u16 seq | u8 version | u8 count | u32 base_ms (press time of the first record)
+//   record  u16 dt_ms         press time minus the previous record's (0 for the first)
+//           u16 peak_10g      peak force in 10 g units
+//           u8  peak_4ms      onset to peak, 4 ms units
+//           u8  press_4ms     onset to unloaded, 4 ms units
+//           u8  release_4ms   unloaded to the next onset, 4 ms units (0 if FINAL)
+//           u16 bpm_x10       instantaneous rate from the previous press, 0 if unknown
+//           u8  residual_100g lowest force before the next press (recoil check)
+//           u8  duty_pct      press share of the cycle (0 if FINAL)
+//           u8  flags         CompressionQuality::Flags
+//
+// 12-byte records still fit one per packet at the default 23-byte MTU. A
+// record is added once its cycle is complete, i.e. when the next press starts.
+// A batch goes out when it is full or TIMEOUT_MS after its first record.
+class TelemetryBatcher {
+public:
+    static constexpr uint8_t VERSION = 2;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t RECORD_SIZE = 12;
+    static constexpr uint16_t MIN_MTU = 23;    // BLE default before an MTU exchange
+    static constexpr uint16_t MAX_MTU = 247;
+    static constexpr size_t MAX_PACKET = MAX_MTU - 3;
+    static constexpr unsigned long TIMEOUT_MS = 1000;
+
+    TelemetryBatcher() { setMtu(MIN_MTU); }
+
+    // clamps to [MIN_MTU, MAX_MTU]; a smaller MTU flushes on the next full check
+    void setMtu(uint16_t mtu);
+    uint16_t mtu() const { return mtu_; }
+    size_t capacity() const { return capacity_; }
+
+    void add(const CompressionQuality &quality, unsigned long now);
+    size_t pending() const { return count_; }
+    bool ready(unsigned long now) const;
+
+    // Writes the batch into out (MAX_PACKET bytes) and starts the next one; returns its length
+    size_t flush(uint8_t *out);
+    // Drops the pending records (nobody to send them to)
+    void discard();
+
+    uint16_t sequence() const { return seq_; }
+    unsigned long dropped() const { return dropped_; }
+
+private:
+    uint8_t records_[MAX_PACKET - HEADER_SIZE];
+    uint16_t mtu_ = MIN_MTU;
+    size_t capacity_ = 1;
+    size_t count_ = 0;
+    uint16_t seq_ = 0;
+    unsigned long base_ms_ = 0;
+    unsigned long last_press_ = 0;
+    unsigned long first_added_ = 0;
+    unsigned long dropped_ = 0;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef TEST_ACCUMULATOR_H
+#define TEST_ACCUMULATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Scores a testing session of any length in constant memory. Each interval
+// between presses goes into a Welford mean/variance of the instantaneous BPM
+// and into a histogram of the interval with BIN_MS bins, so the percentiles
+// need no sample buffer. Time in band is the share of the session (first to
+// last press) spent in intervals whose rate is within [MIN_BPM, MAX_BPM].
+// An interval over PAUSE_MS is a pause: it counts as time out of band but
+// stays out of the rate statistics.
+struct TestSummary {
+    enum Flags : uint8_t {
+        CLIPPED = 1 << 0,           // an interval fell outside the histogram; percentiles stop at its edge
+    };
+
+    unsigned long compressions;
+    unsigned long duration_ms;      // test start to summary
+    float mean_bpm;
+    float sd_bpm;
+    float p10_bpm;                  // 10 % of the intervals were slower than this
+    float p50_bpm;
+    float p90_bpm;
+    float in_band;                  // 0-1, time-weighted
+    float accuracy;                 // 0-1, mean rate against TARGET_BPM
+    float consistency;              // 0-1, sd against MAX_STD_DEV
+    uint16_t pauses;
+    uint8_t flags;
+};
+
+// Result record for the result characteristic, little-endian, 20 bytes so it
+// fits one notification at the default MTU:
+//
+//   u8 version | u16 compressions | u16 duration_s | u16 mean_bpm_x10 |
+//   u16 sd_bpm_x10 | u16 p10_bpm_x10 | u16 p50_bpm_x10 | u16 p90_bpm_x10 |
+//   u8 in_band_pct | u8 accuracy_pct | u8 consistency_pct | u8 pauses | u8 flags
+constexpr uint8_t TEST_RESULT_VERSION = 1;
+constexpr size_t TEST_RESULT_SIZE = 20;
+size_t encodeTestResult(const TestSummary &summary, uint8_t *out);
+
+class TestAccumulator {
+public:
+    static constexpr unsigned long BIN_MS = 8;
+    static constexpr size_t BINS = 128;
+    static constexpr unsigned long HIST_MIN_MS = 250;    // 240 BPM
+    static constexpr unsigned long PAUSE_MS = 2000;       // 30 BPM
+
+    TestAccumulator() { reset(0); }
+    void reset(unsigned long start_ms);
+
+    // Press time of a completed compression, in order
+    void addPress(unsigned long press_time);
+    unsigned long compressions() const { return compressions_; }
+
+    TestSummary summary(unsigned long now) const;
+
+private:
+    // interval (ms) below which the fraction q of all intervals lie
+    float intervalPercentile(float q) const;
+
+    unsigned long start_ms_;
+    unsigned long last_press_;
+    unsigned long compressions_;
+    unsigned long intervals_;
+    float mean_;
+    float m2_;
+    unsigned long span_ms_;         // first to last press, pauses included
+    unsigned long in_band_ms_;
+    uint16_t pauses_;
+    uint8_t flags_;
+    uint16_t bins_[BINS];
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef WAVEFORM_CODEC_H
+#define WAVEFORM_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Force waveform frames for the streaming characteristic, little-endian:
+//
+//   u16 seq | u8 version | u8 count | u32 t0_ms | u16 period_x10 | varint samples...
+//
+// t0_ms is the timestamp of the first sample and period_x10 the mean sample
+// spacing in 0.1 ms (100 ms at 10 SPS). Version 1 had no version byte and a
+// u8 period that stopped at 25.5 ms. Samples are grams; the first is zig-zag coded as is and
+// every following one as the zig-zag delta from its predecessor, each as a
+// LEB128 varint, so a quiet signal costs one byte per sample. Frames are
+// self-contained: losing one never corrupts the next.
+
+constexpr uint8_t WAVEFORM_VERSION = 2;
+constexpr size_t WAVEFORM_HEADER_SIZE = 10;
+constexpr size_t WAVEFORM_MAX_VARINT = 5;
+
+inline uint32_t zigzagEncode(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+inline int32_t zigzagDecode(uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+
+// Returns the bytes written (1-5)
+size_t varintEncode(uint32_t v, uint8_t *out);
+// Returns the bytes consumed, 0 if the varint runs past len or is over-long
+size_t varintDecode(const uint8_t *in, size_t len, uint32_t &v);
+
+class WaveformEncoder {
+public:
+    // capacity = frame size limit in bytes (ATT payload), at most MAX_FRAME
+    static constexpr size_t MAX_FRAME = 244;
+
+    explicit WaveformEncoder(size_t capacity = 20) { setCapacity(capacity); }
+
+    void setCapacity(size_t capacity);
+
+    // false when the sample doesn't fit: flush() and add it again
+    bool add(int32_t grams, unsigned long timestamp);
+    size_t count() const { return count_; }
+    unsigned long firstTimestamp() const { return t0_; }
+
+    // Finishes the frame into out (MAX_FRAME bytes), returns its length; the next frame starts empty
+    size_t flush(uint8_t *out);
+    uint16_t sequence() const { return seq_; }
+
+private:
+    uint8_t payload_[MAX_FRAME - WAVEFORM_HEADER_SIZE];
+    size_t capacity_ = 20;
+    size_t used_ = 0;
+    size_t count_ = 0;
+    int32_t last_ = 0;
+    unsigned long t0_ = 0;
+    unsigned long t_last_ = 0;
+    uint16_t seq_ = 0;
+};
+
+struct WaveformFrame {
+    uint16_t seq;
+    uint8_t count;
+    unsigned long t0;
+    float period_ms;
+};
+
+// Decodes frames and keeps count of frames lost in between
+class WaveformDecoder {
+public:
+    // Returns the number of samples written to out, or -1 for a malformed
+    // frame or one from another version
+    int decode(const uint8_t *frame, size_t len, int32_t *out, size_t max_samples, WaveformFrame &info);
+
+    unsigned long frames() const { return frames_; }
+    unsigned long lost() const { return lost_; }
+    void reset();
+
+private:
+    bool started_ = false;
+    uint16_t expected_ = 0;
+    unsigned long frames_ = 0;
+    unsigned long lost_ = 0;
+};
+
+#endif
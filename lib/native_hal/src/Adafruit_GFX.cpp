@@ -0,0 +1,42 @@
+#include "Adafruit_GFX.h"
+#include "native_sim.h"
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t i = x; i < x + w; i++)
+        for (int16_t j = y; j < y + h; j++) drawPixel(i, j, color);
+}
+
+void Adafruit_GFX::getTextBounds(const char *str, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+    size_t len = strlen(str);
+    *x1 = x;
+    *y1 = y;
+    *w = static_cast<uint16_t>(len * 6 * text_size_);
+    *h = static_cast<uint16_t>(len ? 8 * text_size_ : 0);
+}
+
+size_t Adafruit_GFX::write(uint8_t c)
+{
+    if (c == '\n') {
+        cursor_x_ = 0;
+        cursor_y_ += 8 * text_size_;
+        text_ += ' ';
+        sim::setDrawnText(text_);
+        return 1;
+    }
+    if (c == '\r') return 1;
+
+    text_ += static_cast<char>(c);
+    sim::setDrawnText(text_);
+    // 5x7 placeholder glyph: column i takes 7 bits from a scramble of the code
+    for (int col = 0; col < 5; col++) {
+        uint8_t bits = static_cast<uint8_t>((c * (col + 3) * 37) >> 1) & 0x7F;
+        for (int row = 0; row < 7; row++) {
+            if (bits & (1 << row))
+                fillRect(cursor_x_ + col * text_size_, cursor_y_ + row * text_size_, text_size_, text_size_, text_color_);
+        }
+    }
+    cursor_x_ += 6 * text_size_;
+    return 1;
+}
@@ -0,0 +1,46 @@
+#ifndef NATIVE_ADAFRUIT_GFX_H
+#define NATIVE_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+#include <string>
+
+// Classic 6x8 text cursor model of Adafruit_GFX. Glyphs are placeholder bit
+// patterns derived from the character code; what matters on the host is that
+// different text gives different pixels and the text itself is kept for the
+// frame log.
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : width_(w), height_(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    void setCursor(int16_t x, int16_t y) { cursor_x_ = x; cursor_y_ = y; }
+    void setTextSize(uint8_t s) { text_size_ = s > 0 ? s : 1; }
+    void setTextColor(uint16_t c) { text_color_ = c; }
+    void setTextColor(uint16_t c, uint16_t) { text_color_ = c; }
+    void getTextBounds(const char *str, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+
+    int16_t width() const { return width_; }
+    int16_t height() const { return height_; }
+    int16_t getCursorX() const { return cursor_x_; }
+    int16_t getCursorY() const { return cursor_y_; }
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+    // text drawn since the last clear, for the frame recorder
+    const std::string &drawnText() const { return text_; }
+    void clearDrawnText() { text_.clear(); }
+
+protected:
+    int16_t width_;
+    int16_t height_;
+    int16_t cursor_x_ = 0;
+    int16_t cursor_y_ = 0;
+    uint8_t text_size_ = 1;
+    uint16_t text_color_ = 1;
+    std::string text_;
+};
+
+#endif
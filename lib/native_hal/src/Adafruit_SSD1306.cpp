@@ -0,0 +1,75 @@
+#include "Adafruit_SSD1306.h"
+#include "native_sim.h"
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi, int8_t)
+    : Adafruit_GFX(w, h), wire_(twi)
+{
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306()
+{
+    free(buffer_);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t, uint8_t i2caddr, bool, bool)
+{
+    if (!buffer_) buffer_ = static_cast<uint8_t *>(malloc(width_ * ((height_ + 7) / 8)));
+    if (!buffer_) return false;
+    if (i2caddr) address_ = i2caddr;
+    wire_->setClock(400000);
+    clearDisplay();
+    return true;
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c)
+{
+    wire_->beginTransmission(address_);
+    wire_->write(static_cast<uint8_t>(0x00));
+    wire_->write(c);
+    wire_->endTransmission();
+}
+
+void Adafruit_SSD1306::display()
+{
+    if (!buffer_) return;
+    // page/column address window, then the buffer in 31-byte data chunks
+    static const uint8_t window[] = {0x22, 0x00, 0xFF, 0x21, 0x00};
+    for (uint8_t c : window) ssd1306_command(c);
+    ssd1306_command(static_cast<uint8_t>(width_ - 1));
+
+    size_t count = width_ * ((height_ + 7) / 8);
+    const uint8_t *ptr = buffer_;
+    while (count) {
+        wire_->beginTransmission(address_);
+        wire_->write(static_cast<uint8_t>(0x40));
+        size_t chunk = count < 31 ? count : 31;
+        wire_->write(ptr, chunk);
+        wire_->endTransmission();
+        ptr += chunk;
+        count -= chunk;
+    }
+}
+
+void Adafruit_SSD1306::clearDisplay()
+{
+    if (buffer_) memset(buffer_, 0, width_ * ((height_ + 7) / 8));
+    clearDrawnText();
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (!buffer_ || x < 0 || y < 0 || x >= width_ || y >= height_) return;
+    uint8_t &byte_ref = buffer_[x + (y / 8) * width_];
+    uint8_t bit = 1 << (y & 7);
+    switch (color) {
+    case SSD1306_WHITE: byte_ref |= bit; break;
+    case SSD1306_BLACK: byte_ref &= ~bit; break;
+    case SSD1306_INVERSE: byte_ref ^= bit; break;
+    }
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y)
+{
+    if (!buffer_ || x < 0 || y < 0 || x >= width_ || y >= height_) return false;
+    return buffer_[x + (y / 8) * width_] & (1 << (y & 7));
+}
@@ -0,0 +1,41 @@
+#ifndef NATIVE_ADAFRUIT_SSD1306_H
+#define NATIVE_ADAFRUIT_SSD1306_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Adafruit_GFX.h"
+
+#define SSD1306_BLACK   0
+#define SSD1306_WHITE   1
+#define SSD1306_INVERSE 2
+#define BLACK   SSD1306_BLACK
+#define WHITE   SSD1306_WHITE
+#define INVERSE SSD1306_INVERSE
+
+#define SSD1306_EXTERNALVCC  0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+
+// Framebuffer-compatible SSD1306: display() pushes the whole buffer through
+// Wire in the same 32-byte transactions as the real driver and records a frame
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi = &Wire, int8_t rst_pin = -1);
+    ~Adafruit_SSD1306();
+
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0, bool reset = true, bool periphBegin = true);
+    void display();
+    void clearDisplay();
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    bool getPixel(int16_t x, int16_t y);
+    uint8_t *getBuffer() { return buffer_; }
+    void ssd1306_command(uint8_t c);
+    void dim(bool) {}
+    void invertDisplay(bool) {}
+
+private:
+    TwoWire *wire_;
+    uint8_t address_ = 0x3C;
+    uint8_t *buffer_ = nullptr;
+};
+
+#endif
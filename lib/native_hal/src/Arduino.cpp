@@ -0,0 +1,116 @@
+#include "Arduino.h"
+#include "native_sim.h"
+#include <stdio.h>
+
+HardwareSerial Serial;
+
+unsigned long millis() { return static_cast<unsigned long>(sim::nowMicros() / 1000); }
+
+unsigned long micros() { return static_cast<unsigned long>(sim::nowMicros()); }
+
+void delay(unsigned long ms) { sim::advance(ms * 1000ULL); }
+
+void delayMicroseconds(unsigned int us) { sim::advance(us); }
+
+void yield() { sim::advance(1); }
+
+void pinMode(int pin, int mode)
+{
+    sim::claimPin(pin, false);
+    // a pulled-up input idles high unless something drives it
+    if (mode == INPUT_PULLUP && sim::pinLevel(pin) == LOW) sim::driveInput(pin, HIGH);
+}
+
+void digitalWrite(int pin, int value)
+{
+    if (sim::pinClaimed(pin)) return;
+    sim::driveInput(pin, value ? HIGH : LOW);
+    sim::onPinWrite(pin, value ? HIGH : LOW);
+}
+
+int digitalRead(int pin) { return sim::pinLevel(pin); }
+
+// like the UNO R4 core: a pin without an interrupt channel is silently ignored
+void attachInterrupt(int interrupt, void (*isr)(), int mode)
+{
+    if (interrupt == 2 || interrupt == 3) sim::setHandler(interrupt, isr, mode);
+}
+
+void detachInterrupt(int interrupt) { sim::setHandler(interrupt, nullptr, 0); }
+
+void noInterrupts() { sim::setInterruptsEnabled(false); }
+
+void interrupts() { sim::setInterruptsEnabled(true); }
+
+void __WFI() { sim::waitForInterrupt(); }
+
+void tone(int pin, unsigned int frequency, unsigned long) { sim::recordTone(pin, frequency); }
+
+void noTone(int pin) { sim::recordTone(pin, 0); }
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%ld", n);
+        return write(buf);
+    }
+    return print(static_cast<unsigned long>(n), base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+    return write(buf);
+}
+
+size_t Print::print(double n, int digits)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+void HardwareSerial::begin(unsigned long baud) { baud_ = baud; }
+
+int HardwareSerial::availableForWrite()
+{
+    if (!baud_) return TX_BUFFER_SIZE;
+    uint64_t now = sim::nowMicros();
+    uint64_t byte_us = 10000000ULL / baud_;
+    uint64_t queued = tx_idle_at_ > now ? (tx_idle_at_ - now + byte_us - 1) / byte_us : 0;
+    return queued >= TX_BUFFER_SIZE ? 0 : TX_BUFFER_SIZE - static_cast<int>(queued);
+}
+
+void HardwareSerial::flush()
+{
+    if (tx_idle_at_ > sim::nowMicros()) sim::advanceTo(tx_idle_at_);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    // nothing is transmitted before begin(), like the board
+    if (!baud_) return 1;
+    uint64_t byte_us = 10000000ULL / baud_;
+    while (availableForWrite() == 0) sim::advance(byte_us);
+    uint64_t now = sim::nowMicros();
+    tx_idle_at_ = (tx_idle_at_ > now ? tx_idle_at_ : now) + byte_us;
+
+    FILE *out = sim::serialOut();
+    if (out) fputc(c, out);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; i++) write(buffer[i]);
+    return size;
+}
@@ -0,0 +1,124 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the subset of the Arduino core the firmware uses. Time is
+// virtual: millis()/micros() read the simulation clock and delay() advances it,
+// so setup()/loop() run deterministically and faster than real time.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define LED_BUILTIN 13
+#define NOT_AN_INTERRUPT -1
+
+#define DEC 10
+#define HEX 16
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+
+void attachInterrupt(int interrupt, void (*isr)(), int mode);
+void detachInterrupt(int interrupt);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void noInterrupts();
+void interrupts();
+// CMSIS sleep: returns at the next interrupt, the core's 1 ms tick at the latest
+void __WFI();
+
+void tone(int pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(int pin);
+
+class String {
+public:
+    String() {}
+    String(const char *s) : s_(s ? s : "") {}
+    String(const std::string &s) : s_(s) {}
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return s_.size(); }
+    bool operator==(const String &o) const { return s_ == o.s_; }
+
+private:
+    std::string s_;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int availableForWrite() { return 0; }
+
+    size_t write(const char *str) { return write(reinterpret_cast<const uint8_t *>(str), strlen(str)); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(int n, int base = DEC) { return print(static_cast<long>(n), base); }
+    size_t print(unsigned int n, int base = DEC) { return print(static_cast<unsigned long>(n), base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+// Serial goes to stdout, a file, or nowhere depending on the simulation options.
+// Bytes drain from a 64-byte TX buffer at the configured baud rate; a write to
+// a full buffer blocks on the virtual clock the way the UART driver would.
+class HardwareSerial : public Print {
+public:
+    static const int TX_BUFFER_SIZE = 64;
+
+    void begin(unsigned long baud);
+    void end() {}
+    operator bool() const { return true; }
+    int availableForWrite() override;
+    void flush();
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+private:
+    unsigned long baud_ = 0;
+    uint64_t tx_idle_at_ = 0;   // virtual time the TX buffer will be empty
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,166 @@
+#include "ArduinoBLE.h"
+#include "native_sim.h"
+#include <strings.h>
+
+BLELocalDevice BLE;
+
+bool BLEDevice::connected() const
+{
+    return present_ && BLE.connected();
+}
+
+bool BLEDevice::disconnect()
+{
+    return BLE.disconnect();
+}
+
+BLECharacteristic::BLECharacteristic(const char *uuid, uint8_t properties, int value_size, bool)
+    : state_(std::make_shared<State>())
+{
+    state_->uuid = uuid;
+    state_->properties = properties;
+    state_->value_size = value_size;
+}
+
+BLECharacteristic::BLECharacteristic(const char *uuid, uint8_t properties, const char *value)
+    : BLECharacteristic(uuid, properties, strlen(value))
+{
+    writeValue(value);
+}
+
+const char *BLECharacteristic::uuid() const { return state_ ? state_->uuid.c_str() : ""; }
+uint8_t BLECharacteristic::properties() const { return state_ ? state_->properties : 0; }
+int BLECharacteristic::valueSize() const { return state_ ? state_->value_size : 0; }
+int BLECharacteristic::valueLength() const { return state_ ? static_cast<int>(state_->value.size()) : 0; }
+const uint8_t *BLECharacteristic::value() const { return state_ ? state_->value.data() : nullptr; }
+
+int BLECharacteristic::readValue(uint8_t *value, int length)
+{
+    int n = std::min(length, valueLength());
+    memcpy(value, state_->value.data(), n);
+    return n;
+}
+
+int BLECharacteristic::writeValue(const uint8_t *value, int length, bool)
+{
+    if (!state_) return 0;
+    if (length > state_->value_size) length = state_->value_size;
+    state_->value.assign(value, value + length);
+    // like ATT, a notification only carries what fits the MTU
+    int payload = std::min(length, sim::options().att_mtu - 3);
+    if (state_->subscribed && BLE.connected() && canNotify()) {
+        sim::awaitLinkBuffer();
+        sim::recordNotification(state_->uuid, value, payload);
+    }
+    return 1;
+}
+
+bool BLECharacteristic::written()
+{
+    if (!state_ || !state_->written) return false;
+    state_->written = false;
+    return true;
+}
+
+bool BLECharacteristic::subscribed() const { return state_ && state_->subscribed; }
+
+bool BLECharacteristic::canNotify() const { return properties() & (BLENotify | BLEIndicate); }
+
+void BLECharacteristic::setEventHandler(int event, BLECharacteristicEventHandler handler)
+{
+    if (state_ && event >= 0 && event < BLECharacteristicEventLast) state_->handlers[event] = handler;
+}
+
+void BLECharacteristic::centralWrite(const std::vector<uint8_t> &value)
+{
+    state_->value = value;
+    if (static_cast<int>(state_->value.size()) > state_->value_size) state_->value.resize(state_->value_size);
+    state_->written = true;
+    if (state_->handlers[BLEWritten]) state_->handlers[BLEWritten](BLEDevice(true), *this);
+}
+
+void BLECharacteristic::setSubscribed(bool subscribed)
+{
+    if (!canNotify() || state_->subscribed == subscribed) return;
+    state_->subscribed = subscribed;
+    int event = subscribed ? BLESubscribed : BLEUnsubscribed;
+    if (state_->handlers[event]) state_->handlers[event](BLEDevice(true), *this);
+}
+
+int BLELocalDevice::begin() { return 1; }
+
+void BLELocalDevice::end()
+{
+    connected_ = false;
+    advertising_ = false;
+}
+
+bool BLELocalDevice::setLocalName(const char *) { return true; }
+
+bool BLELocalDevice::setAdvertisedService(const BLEService &) { return true; }
+
+void BLELocalDevice::addService(BLEService &service)
+{
+    for (const BLECharacteristic &c : service.characteristics()) characteristics_.push_back(c);
+}
+
+int BLELocalDevice::advertise()
+{
+    advertising_ = true;
+    return 1;
+}
+
+void BLELocalDevice::stopAdvertise() { advertising_ = false; }
+
+void BLELocalDevice::setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler)
+{
+    if (event < BLEDeviceLastEvent) handlers_[event] = handler;
+}
+
+bool BLELocalDevice::disconnect()
+{
+    if (!connected_) return false;
+    // the scripted central does not come back once the peripheral drops it
+    dropped_ = true;
+    update();
+    return true;
+}
+
+void BLELocalDevice::update()
+{
+    const sim::Options &opts = sim::options();
+    unsigned long now = millis();
+    bool in_window = opts.central && !dropped_ && now >= opts.central_from_ms && now < opts.central_until_ms;
+    // a new connection needs us to be advertising; an existing one just stays up
+    bool want = in_window && (connected_ || advertising_);
+
+    if (want && !connected_) {
+        connected_ = true;
+        advertising_ = false;
+        for (BLECharacteristic &c : characteristics_) c.setSubscribed(true);
+        if (handlers_[BLEConnected]) handlers_[BLEConnected](BLEDevice(true));
+    } else if (!want && connected_) {
+        connected_ = false;
+        for (BLECharacteristic &c : characteristics_) c.setSubscribed(false);
+        if (handlers_[BLEDisconnected]) handlers_[BLEDisconnected](BLEDevice(true));
+    }
+
+    while (connected_ && next_write_ < opts.ble_writes.size() && opts.ble_writes[next_write_].at_ms <= now) {
+        const sim::BleWrite &w = opts.ble_writes[next_write_++];
+        for (BLECharacteristic &c : characteristics_) {
+            if (strcasecmp(c.uuid(), w.uuid.c_str()) == 0) c.centralWrite(w.value);
+        }
+    }
+}
+
+void BLELocalDevice::poll(unsigned long timeout)
+{
+    update();
+    if (timeout) delay(timeout);
+}
+
+BLEDevice BLELocalDevice::central()
+{
+    update();
+    return BLEDevice(connected_);
+}
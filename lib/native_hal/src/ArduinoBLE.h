@@ -0,0 +1,161 @@
+#ifndef NATIVE_ARDUINO_BLE_H
+#define NATIVE_ARDUINO_BLE_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ArduinoBLE peripheral API backed by a scripted central: it connects inside
+// the --central window, subscribes to every notify characteristic, replays
+// --ble-write values and has each notification recorded with its timestamp.
+
+enum BLEProperty {
+    BLEBroadcast = 0x01,
+    BLERead = 0x02,
+    BLEWriteWithoutResponse = 0x04,
+    BLEWrite = 0x08,
+    BLENotify = 0x10,
+    BLEIndicate = 0x20
+};
+
+enum BLEDeviceEvent { BLEConnected = 0, BLEDisconnected = 1, BLEDiscovered = 2, BLEDeviceLastEvent };
+
+enum BLECharacteristicEvent {
+    BLESubscribed = 0,
+    BLEUnsubscribed = 1,
+    BLEWritten = 3,
+    BLEUpdated = BLEWritten,
+    BLECharacteristicEventLast
+};
+
+class BLEDevice {
+public:
+    BLEDevice() {}
+    explicit BLEDevice(bool present) : present_(present) {}
+    operator bool() const { return present_; }
+    bool connected() const;
+    String address() const { return present_ ? String("5e:1a:c0:de:00:01") : String("00:00:00:00:00:00"); }
+    bool disconnect();
+
+private:
+    bool present_ = false;
+};
+
+class BLECharacteristic;
+typedef void (*BLEDeviceEventHandler)(BLEDevice device);
+typedef void (*BLECharacteristicEventHandler)(BLEDevice device, BLECharacteristic characteristic);
+
+// Handle to shared characteristic state, copyable like the real class
+class BLECharacteristic {
+public:
+    BLECharacteristic() {}
+    BLECharacteristic(const char *uuid, uint8_t properties, int value_size, bool fixed_length = false);
+    BLECharacteristic(const char *uuid, uint8_t properties, const char *value);
+
+    const char *uuid() const;
+    uint8_t properties() const;
+    int valueSize() const;
+    int valueLength() const;
+    const uint8_t *value() const;
+    int readValue(uint8_t *value, int length);
+
+    int writeValue(const uint8_t *value, int length, bool with_response = true);
+    int writeValue(const char *value) { return writeValue(reinterpret_cast<const uint8_t *>(value), strlen(value)); }
+
+    bool written();
+    bool subscribed() const;
+    bool canNotify() const;
+
+    void setEventHandler(int event, BLECharacteristicEventHandler handler);
+
+    operator bool() const { return static_cast<bool>(state_); }
+
+    // host-side hooks used by the scripted central
+    void centralWrite(const std::vector<uint8_t> &value);
+    void setSubscribed(bool subscribed);
+
+private:
+    struct State {
+        std::string uuid;
+        uint8_t properties = 0;
+        int value_size = 0;
+        std::vector<uint8_t> value;
+        bool written = false;
+        bool subscribed = false;
+        BLECharacteristicEventHandler handlers[BLECharacteristicEventLast] = {};
+    };
+    std::shared_ptr<State> state_;
+};
+
+template <typename T>
+class BLETypedCharacteristic : public BLECharacteristic {
+public:
+    BLETypedCharacteristic(const char *uuid, uint8_t properties)
+        : BLECharacteristic(uuid, properties, sizeof(T), true) {}
+
+    int writeValue(T value) { return BLECharacteristic::writeValue(reinterpret_cast<const uint8_t *>(&value), sizeof(T)); }
+    T value() const
+    {
+        T v{};
+        if (valueLength() >= static_cast<int>(sizeof(T))) memcpy(&v, BLECharacteristic::value(), sizeof(T));
+        return v;
+    }
+};
+
+typedef BLETypedCharacteristic<int32_t> BLEIntCharacteristic;
+typedef BLETypedCharacteristic<uint32_t> BLEUnsignedIntCharacteristic;
+typedef BLETypedCharacteristic<uint16_t> BLEUnsignedShortCharacteristic;
+typedef BLETypedCharacteristic<uint8_t> BLEByteCharacteristic;
+typedef BLETypedCharacteristic<float> BLEFloatCharacteristic;
+
+class BLEService {
+public:
+    explicit BLEService(const char *uuid) : uuid_(uuid) {}
+    const char *uuid() const { return uuid_.c_str(); }
+    void addCharacteristic(BLECharacteristic &characteristic) { characteristics_.push_back(characteristic); }
+    const std::vector<BLECharacteristic> &characteristics() const { return characteristics_; }
+
+private:
+    std::string uuid_;
+    std::vector<BLECharacteristic> characteristics_;
+};
+
+class BLELocalDevice {
+public:
+    int begin();
+    void end();
+    void poll(unsigned long timeout = 0);
+    bool connected() const { return connected_; }
+    bool disconnect();
+    BLEDevice central();
+
+    bool setLocalName(const char *name);
+    bool setDeviceName(const char *) { return true; }
+    bool setAdvertisedService(const BLEService &service);
+    void addService(BLEService &service);
+    int advertise();
+    void stopAdvertise();
+    void setAdvertisingInterval(uint16_t interval) { advertising_interval_ = interval; }
+    void setConnectionInterval(uint16_t, uint16_t) {}
+    void setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler);
+
+    // host-side state for diagnostics
+    uint16_t advertisingInterval() const { return advertising_interval_; }
+    bool advertising() const { return advertising_; }
+
+private:
+    void update();
+
+    bool connected_ = false;
+    bool dropped_ = false;
+    bool advertising_ = false;
+    uint16_t advertising_interval_ = 160;
+    size_t next_write_ = 0;
+    std::vector<BLECharacteristic> characteristics_;
+    BLEDeviceEventHandler handlers_[BLEDeviceLastEvent] = {};
+};
+
+extern BLELocalDevice BLE;
+
+#endif
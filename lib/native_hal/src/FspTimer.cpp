@@ -0,0 +1,62 @@
+#include "FspTimer.h"
+#include "native_sim.h"
+
+bool FspTimer::begin(timer_mode_t mode, uint8_t type, uint8_t channel, float freq_hz, float duty_perc,
+                     GPTimerCbk_f cbk, void *ctx)
+{
+    if (freq_hz <= 0) return false;
+    mode_ = mode;
+    period_us_ = static_cast<uint64_t>(1e6 / freq_hz + 0.5);
+    if (period_us_ == 0) period_us_ = 1;
+    cbk_ = cbk;
+    ctx_ = ctx;
+    return true;
+}
+
+bool FspTimer::start()
+{
+    if (running_) return true;
+    running_ = true;
+    uint32_t generation = ++generation_;
+    sim::schedule(sim::nowMicros() + period_us_, [this, generation] { overflow(generation); });
+    return true;
+}
+
+bool FspTimer::stop()
+{
+    running_ = false;
+    generation_++;
+    return true;
+}
+
+bool FspTimer::set_frequency(float freq_hz)
+{
+    if (freq_hz <= 0) return false;
+    period_us_ = static_cast<uint64_t>(1e6 / freq_hz + 0.5);
+    if (period_us_ == 0) period_us_ = 1;
+    return true;
+}
+
+void FspTimer::overflow(uint32_t generation)
+{
+    if (!running_ || generation != generation_) return;
+    if (mode_ == TIMER_MODE_ONE_SHOT) {
+        running_ = false;
+    } else {
+        // the counter reloads in hardware, so the next overflow doesn't drift with ISR latency
+        sim::schedule(sim::nowMicros() + period_us_, [this, generation] { overflow(generation); });
+    }
+    sim::raiseIrq([this, generation] {
+        if (generation != generation_) return;
+        timer_callback_args_t args = {ctx_, TIMER_EVENT_CYCLE_END, 0};
+        if (cbk_) cbk_(&args);
+    });
+}
+
+int8_t FspTimer::get_available_timer(uint8_t &type, bool force)
+{
+    // plenty of channels on the host; hand out AGT numbers like the core does first
+    static int8_t next = 0;
+    type = AGT_TIMER;
+    return next++;
+}
@@ -0,0 +1,58 @@
+#ifndef NATIVE_FSPTIMER_H
+#define NATIVE_FSPTIMER_H
+
+// Host stand-in for the Renesas core's FspTimer: periodic and one-shot modes
+// whose overflow callback runs as an interrupt on the virtual clock.
+
+#include <stdint.h>
+
+#define GPT_TIMER 0
+#define AGT_TIMER 1
+
+enum timer_mode_t {
+    TIMER_MODE_PERIODIC = 0,
+    TIMER_MODE_ONE_SHOT = 1,
+    TIMER_MODE_PWM = 2,
+};
+
+enum timer_event_t {
+    TIMER_EVENT_CYCLE_END = 0,
+};
+
+struct timer_callback_args_t {
+    void const *p_context;
+    timer_event_t event;
+    uint32_t capture;
+};
+
+typedef void (*GPTimerCbk_f)(timer_callback_args_t *);
+
+class FspTimer {
+public:
+    ~FspTimer() { end(); }
+
+    bool begin(timer_mode_t mode, uint8_t type, uint8_t channel, float freq_hz, float duty_perc,
+               GPTimerCbk_f cbk = nullptr, void *ctx = nullptr);
+    bool setup_overflow_irq(uint8_t priority = 12, void (*isr)() = nullptr) { return true; }
+    bool open() { return true; }
+    bool start();
+    bool stop();
+    bool reset() { return true; }   // start() always counts a full period here
+    bool close() { return stop(); }
+    void end() { stop(); }
+    bool set_frequency(float freq_hz);
+
+    static int8_t get_available_timer(uint8_t &type, bool force = false);
+
+private:
+    void overflow(uint32_t generation);
+
+    timer_mode_t mode_ = TIMER_MODE_PERIODIC;
+    uint64_t period_us_ = 0;
+    GPTimerCbk_f cbk_ = nullptr;
+    void *ctx_ = nullptr;
+    bool running_ = false;
+    uint32_t generation_ = 0;   // bumped on stop so stale overflow events drop out
+};
+
+#endif
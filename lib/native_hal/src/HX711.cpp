@@ -0,0 +1,117 @@
+#include "HX711.h"
+
+void HX711::begin(byte dout, byte pd_sck, byte gain)
+{
+    pd_sck_ = pd_sck;
+    dout_ = dout;
+    pinMode(pd_sck_, OUTPUT);
+    pinMode(dout_, INPUT);
+    set_gain(gain);
+}
+
+bool HX711::is_ready()
+{
+    return digitalRead(dout_) == LOW;
+}
+
+void HX711::set_gain(byte gain)
+{
+    switch (gain) {
+    case 128: gain_ = 1; break;
+    case 64: gain_ = 3; break;
+    case 32: gain_ = 2; break;
+    }
+}
+
+long HX711::read()
+{
+    wait_ready();
+
+    noInterrupts();
+    uint32_t value = 0;
+    for (int i = 0; i < 24; i++) {
+        digitalWrite(pd_sck_, HIGH);
+        delayMicroseconds(1);
+        value = (value << 1) | (digitalRead(dout_) == HIGH ? 1 : 0);
+        digitalWrite(pd_sck_, LOW);
+        delayMicroseconds(1);
+    }
+    for (unsigned int i = 0; i < gain_; i++) {
+        digitalWrite(pd_sck_, HIGH);
+        delayMicroseconds(1);
+        digitalWrite(pd_sck_, LOW);
+        delayMicroseconds(1);
+    }
+    interrupts();
+
+    if (value & 0x800000UL) value |= 0xFF000000UL;
+    return static_cast<int32_t>(value);
+}
+
+void HX711::wait_ready(unsigned long delay_ms)
+{
+    while (!is_ready()) {
+        if (delay_ms) delay(delay_ms);
+        else delayMicroseconds(100);
+    }
+}
+
+bool HX711::wait_ready_retry(int retries, unsigned long delay_ms)
+{
+    for (int count = 0; count < retries; count++) {
+        if (is_ready()) return true;
+        delay(delay_ms);
+    }
+    return false;
+}
+
+bool HX711::wait_ready_timeout(unsigned long timeout, unsigned long delay_ms)
+{
+    unsigned long start = millis();
+    while (millis() - start < timeout) {
+        if (is_ready()) return true;
+        delay(delay_ms ? delay_ms : 1);
+    }
+    return false;
+}
+
+long HX711::read_average(byte times)
+{
+    long sum = 0;
+    for (byte i = 0; i < times; i++) sum += read();
+    return times ? sum / times : 0;
+}
+
+double HX711::get_value(byte times)
+{
+    return read_average(times) - offset_;
+}
+
+float HX711::get_units(byte times)
+{
+    return get_value(times) / scale_;
+}
+
+void HX711::tare(byte times)
+{
+    set_offset(read_average(times));
+}
+
+void HX711::set_scale(float scale) { scale_ = scale; }
+
+float HX711::get_scale() { return scale_; }
+
+void HX711::set_offset(long offset) { offset_ = offset; }
+
+long HX711::get_offset() { return offset_; }
+
+void HX711::power_down()
+{
+    digitalWrite(pd_sck_, LOW);
+    digitalWrite(pd_sck_, HIGH);
+}
+
+void HX711::power_up()
+{
+    digitalWrite(pd_sck_, LOW);
+}
@@ -0,0 +1,35 @@
+#ifndef NATIVE_HX711_H
+#define NATIVE_HX711_H
+
+#include <Arduino.h>
+
+// Same interface as bogde/HX711, clocking the simulated chip through the pin shim
+class HX711 {
+public:
+    void begin(byte dout, byte pd_sck, byte gain = 128);
+    bool is_ready();
+    void set_gain(byte gain = 128);
+    long read();
+    void wait_ready(unsigned long delay_ms = 0);
+    bool wait_ready_retry(int retries = 3, unsigned long delay_ms = 0);
+    bool wait_ready_timeout(unsigned long timeout = 1000, unsigned long delay_ms = 0);
+    long read_average(byte times = 10);
+    double get_value(byte times = 1);
+    float get_units(byte times = 1);
+    void tare(byte times = 10);
+    void set_scale(float scale = 1.f);
+    float get_scale();
+    void set_offset(long offset = 0);
+    long get_offset();
+    void power_down();
+    void power_up();
+
+private:
+    byte pd_sck_ = 0;
+    byte dout_ = 0;
+    byte gain_ = 1;
+    long offset_ = 0;
+    float scale_ = 1.f;
+};
+
+#endif
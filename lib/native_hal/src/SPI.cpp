@@ -0,0 +1,42 @@
+#include "SPI.h"
+#include "native_sim.h"
+
+SPIClass SPI;
+
+void SPIClass::begin()
+{
+    pinMode(PIN_SPI_MOSI, OUTPUT);
+    pinMode(PIN_SPI_MISO, INPUT);
+    digitalWrite(PIN_SPI_MOSI, LOW);
+    // SCK becomes the peripheral's even where nothing is wired to it
+    sim::claimPin(PIN_SPI_SCK, true);
+}
+
+void SPIClass::end() {}
+
+uint8_t SPIClass::shift(uint8_t data)
+{
+    uint8_t in = 0;
+    for (int i = 0; i < 8; i++) {
+        int bit = settings_.bit_order_ == MSBFIRST ? 7 - i : i;
+        digitalWrite(PIN_SPI_MOSI, (data >> bit) & 1 ? HIGH : LOW);
+        if (digitalRead(PIN_SPI_MISO) == HIGH) in |= 1 << bit;
+    }
+    return in;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    uint8_t in = shift(data);
+    digitalWrite(PIN_SPI_MOSI, LOW);
+    sim::advance((8ULL * 1000000ULL + settings_.clock_ - 1) / settings_.clock_);
+    return in;
+}
+
+void SPIClass::transfer(void *buf, size_t count)
+{
+    uint8_t *bytes = static_cast<uint8_t *>(buf);
+    for (size_t i = 0; i < count; i++) bytes[i] = shift(bytes[i]);
+    digitalWrite(PIN_SPI_MOSI, LOW);
+    sim::advance((count * 8ULL * 1000000ULL + settings_.clock_ - 1) / settings_.clock_);
+}
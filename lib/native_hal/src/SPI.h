@@ -0,0 +1,51 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include <Arduino.h>
+
+// UNO R4 header pins of the SPI peripheral
+#define PIN_SPI_MOSI 11
+#define PIN_SPI_MISO 12
+#define PIN_SPI_SCK  13
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+public:
+    SPISettings(uint32_t clock = 4000000, uint8_t bit_order = MSBFIRST, uint8_t mode = SPI_MODE0)
+        : clock_(clock), bit_order_(bit_order), mode_(mode) {}
+
+    uint32_t clock_;
+    uint8_t bit_order_;
+    uint8_t mode_;
+};
+
+// SPI master working at pin level: every MOSI bit is driven through the pin
+// shim (so a device clocked from MOSI sees the edges) and MISO is sampled in
+// the middle of each bit. MOSI idles low between transfers, like the RA4M1
+// with SPPCR.MOIFE set. Bus time is charged to the virtual clock per transfer.
+class SPIClass {
+public:
+    void begin();
+    void end();
+    void beginTransaction(const SPISettings &settings) { settings_ = settings; }
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t data);
+    void transfer(void *buf, size_t count);
+
+private:
+    uint8_t shift(uint8_t data);
+
+    SPISettings settings_;
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,34 @@
+#include "Wire.h"
+#include "native_sim.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    address_ = address;
+    pending_ = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (pending_ >= sizeof(buffer_)) return 0;
+    buffer_[pending_++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len)
+{
+    size_t n = 0;
+    while (n < len && write(data[n])) n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+    // address byte plus payload, 9 clocks each (8 data + ACK), start/stop ignored
+    size_t bytes = pending_ + 1;
+    sim::i2cTransaction(address_, buffer_, pending_);
+    sim::advance((bytes * 9ULL * 1000000ULL) / clock_hz_);
+    pending_ = 0;
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// I2C master that hands each transaction to the simulated bus (where the
+// SSD1306 panel model lives) and charges the bus time to the virtual clock
+class TwoWire {
+public:
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t hz) { clock_hz_ = hz; }
+    uint32_t getClock() const { return clock_hz_; }
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t len);
+    uint8_t endTransmission(bool stop = true);
+
+private:
+    uint32_t clock_hz_ = 100000;
+    uint8_t address_ = 0;
+    uint8_t buffer_[256];
+    size_t pending_ = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
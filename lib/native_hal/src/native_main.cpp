@@ -0,0 +1,45 @@
+// the unit tests under test/ bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <chrono>
+#include "native_sim.h"
+
+// the firmware entry points, unchanged from the board build
+void setup();
+void loop();
+
+int main(int argc, char **argv)
+{
+    if (!sim::parseArgs(argc, argv)) {
+        sim::printUsage(argv[0]);
+        return 2;
+    }
+    sim::begin();
+    const sim::Options &opts = sim::options();
+
+    auto wall_start = std::chrono::steady_clock::now();
+    setup();
+    sim::capturePanel();
+    uint64_t end_us = opts.duration_ms * 1000ULL;
+    while (sim::nowMicros() < end_us) {
+        loop();
+        sim::capturePanel();
+        sim::stats().loops++;
+        sim::advance(opts.loop_cost_us);
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    sim::end();
+
+    const sim::Stats &stats = sim::stats();
+    double virtual_s = sim::nowMicros() / 1e6;
+    fprintf(stderr,
+            "sim: %.1f s virtual in %.3f s wall (%.0fx), %lu loops, %lu conversions, "
+            "%lu frames, %lu I2C bytes, %lu notifications (%.0f ms blocked), %.1f s asleep\n",
+            virtual_s, wall_s, wall_s > 0 ? virtual_s / wall_s : 0.0, stats.loops, stats.conversions,
+            stats.frames, stats.i2c_bytes, stats.notifications, stats.link_blocked_us / 1e3,
+            stats.asleep_us / 1e6);
+    return 0;
+}
+
+#endif
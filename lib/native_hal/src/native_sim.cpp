@@ -0,0 +1,584 @@
+#include "native_sim.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <fstream>
+#include <sstream>
+
+namespace sim {
+
+namespace {
+
+Options opts;
+Stats counters;
+uint64_t now_us = 0;
+std::multimap<uint64_t, std::function<void()>> events;
+
+uint8_t data_flash[DATA_FLASH_SIZE];
+
+// radio buffers in use and the central's next connection event
+struct Link {
+    int queued = 0;
+    uint64_t next_event = 0;
+} link;
+FILE *serial_file = nullptr;
+FILE *frames_file = nullptr;
+FILE *ble_file = nullptr;
+FILE *tones_file = nullptr;
+
+// pins and the interrupt controller
+constexpr int NUM_PINS = 64;
+int levels[NUM_PINS];
+bool claimed[NUM_PINS];
+void (*handlers[NUM_PINS])();
+int handler_modes[NUM_PINS];
+bool pending[NUM_PINS];
+bool irq_enabled = true;
+bool in_isr = false;
+std::vector<std::function<void()>> pending_irqs;
+
+// SSD1306 panel model: horizontal addressing inside the column/page window
+struct Panel {
+    uint8_t gddram[128 * 8] = {};
+    uint8_t col_start = 0, col_end = 127, page_start = 0, page_end = 7;
+    uint8_t col = 0, page = 0;
+    bool dirty = false;
+    std::string text;
+} panel;
+
+// force source
+std::mt19937 rng;
+std::normal_distribution<float> noise(0.0f, 1.0f);
+std::vector<std::pair<double, float>> trace;   // (ms, grams)
+bool trace_is_series = false;                  // one value per conversion, no time column
+
+// simulated HX711: DOUT low = conversion ready, MSB first on PD_SCK rising edges
+struct Hx711Chip {
+    uint32_t latched = 0;
+    int pulses = 0;
+    bool ready = false;
+    int clk = LOW;
+    uint64_t clk_high_since = 0;
+    bool powered = true;
+    uint64_t settled_at = 0;
+    uint64_t period_us = 12500;
+} chip;
+
+uint32_t toCounts(float grams)
+{
+    long counts = opts.hx711_offset + lroundf(grams * opts.hx711_scale);
+    if (counts > 0x7FFFFF) counts = 0x7FFFFF;
+    if (counts < -0x800000) counts = -0x800000;
+    return static_cast<uint32_t>(counts) & 0xFFFFFF;
+}
+
+void setDout(int level)
+{
+    driveInput(opts.hx711_data_pin, level);
+}
+
+// a contact closing or opening: a few random flips, settling at `level` after bounce_us
+void scheduleBounce(int pin, uint64_t at_us, int level)
+{
+    std::vector<uint64_t> flips;
+    if (opts.bounce_us > 0) {
+        std::uniform_int_distribution<uint64_t> when(0, opts.bounce_us - 1);
+        for (int i = 0; i < 6; i++) flips.push_back(at_us + when(rng));
+        std::sort(flips.begin(), flips.end());
+    }
+    int other = level == LOW ? HIGH : LOW;
+    for (size_t i = 0; i < flips.size(); i++) {
+        int l = i % 2 == 0 ? level : other;
+        schedule(flips[i], [pin, l] { driveInput(pin, l); });
+    }
+    schedule(at_us + opts.bounce_us, [pin, level] { driveInput(pin, level); });
+}
+
+void conversion()
+{
+    // PD_SCK held high for more than 60 us powers the chip down
+    if (chip.clk == HIGH && now_us - chip.clk_high_since > 60) chip.powered = false;
+
+    if (chip.powered && now_us >= chip.settled_at && chip.clk == LOW) {
+        float grams = forceAt(now_us) + opts.noise_grams * noise(rng);
+        chip.latched = toCounts(grams);
+        chip.pulses = 0;
+        chip.ready = true;
+        counters.conversions++;
+        setDout(LOW);
+    }
+    schedule(now_us + chip.period_us, conversion);
+}
+
+void clockEdge(int level)
+{
+    if (level == chip.clk) return;
+    chip.clk = level;
+
+    if (level == HIGH) {
+        chip.clk_high_since = now_us;
+        if (!chip.powered || !chip.ready) return;
+        chip.pulses++;
+        if (chip.pulses <= 24) {
+            setDout((chip.latched >> (24 - chip.pulses)) & 1 ? HIGH : LOW);
+        } else {
+            // 25th..27th pulse pick the next gain; DOUT returns high until the next conversion
+            chip.ready = false;
+            setDout(HIGH);
+        }
+    } else if (now_us - chip.clk_high_since > 60) {
+        // waking from power-down: the output needs four conversions to settle
+        chip.powered = true;
+        chip.ready = false;
+        chip.settled_at = now_us + 4 * chip.period_us;
+        setDout(HIGH);
+    }
+}
+
+void loadTrace()
+{
+    std::ifstream in(opts.trace_path);
+    if (!in) {
+        fprintf(stderr, "sim: cannot open trace %s\n", opts.trace_path.c_str());
+        exit(2);
+    }
+    std::string line;
+    size_t index = 0;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t comma = line.find(',');
+        if (comma == std::string::npos) {
+            trace_is_series = true;
+            trace.push_back({index++ * 1000.0 / opts.sps, strtof(line.c_str(), nullptr)});
+        } else {
+            trace.push_back({strtod(line.c_str(), nullptr), strtof(line.c_str() + comma + 1, nullptr)});
+        }
+    }
+}
+
+float traceAt(double ms)
+{
+    if (trace.empty()) return 0.0f;
+    if (ms <= trace.front().first) return trace.front().second;
+    if (ms >= trace.back().first) return trace.back().second;
+    auto it = std::lower_bound(trace.begin(), trace.end(), std::make_pair(ms, -1e30f));
+    auto prev = it - 1;
+    double span = it->first - prev->first;
+    float frac = span > 0 ? static_cast<float>((ms - prev->first) / span) : 0.0f;
+    return prev->second + frac * (it->second - prev->second);
+}
+
+FILE *openOrDie(const std::string &path)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "sim: cannot write %s\n", path.c_str());
+        exit(2);
+    }
+    return f;
+}
+
+bool parseList(const std::string &value, std::vector<unsigned long> &out)
+{
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ':')) {
+        if (item.empty()) return false;
+        out.push_back(strtoul(item.c_str(), nullptr, 10));
+    }
+    return true;
+}
+
+}
+
+Options &options() { return opts; }
+Stats &stats() { return counters; }
+
+void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --duration=MS          virtual time to run (default 60000)\n"
+            "  --trace=FILE           load-cell force in grams: 'ms,grams' rows or one value per conversion\n"
+            "  --bpm=N --peak=G --duty=F --noise=G --drift=G_PER_MIN\n"
+            "                         synthetic compression generator (used without --trace)\n"
+            "  --from=MS --until=MS   generator compresses only inside this window\n"
+            "  --sps=N                HX711 output rate (default 80)\n"
+            "  --hx711=DOUT:SCK       HX711 wiring (default 2:7; 12:11 for the SPI backend)\n"
+            "  --offset=COUNTS        HX711 reading with nothing on the cell (default 8400)\n"
+            "  --flash=FILE           keep the data flash in FILE across runs\n"
+            "  --press=PIN:MS:HOLD    press a button (repeatable)\n"
+            "  --bounce=US            buttons chatter this long after each press and release\n"
+            "  --no-central           never connect a BLE central\n"
+            "  --central=FROM:UNTIL   central connection window in ms\n"
+            "  --ble-write=MS:UUID:HEX  central writes a characteristic (repeatable)\n"
+            "  --mtu=N                ATT MTU the central negotiates (default 23)\n"
+            "  --link=MS:PER_EVENT:BUFFERS  slow central: connection interval, notifications sent\n"
+            "                         per connection event, radio buffers (default no limit)\n"
+            "  --loop-cost=US         CPU time charged per loop() pass (default 20)\n"
+            "  --seed=N --serial=FILE --quiet --frames=FILE --ble=FILE --tones=FILE\n",
+            program);
+}
+
+bool parseArgs(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string key = arg, value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            key = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+        const char *v = value.c_str();
+
+        if (key == "--help" || key == "-h") return false;
+        else if (key == "--duration") opts.duration_ms = strtoul(v, nullptr, 10);
+        else if (key == "--trace") opts.trace_path = value;
+        else if (key == "--bpm") opts.bpm = strtof(v, nullptr);
+        else if (key == "--peak") opts.peak_grams = strtof(v, nullptr);
+        else if (key == "--duty") opts.duty = strtof(v, nullptr);
+        else if (key == "--noise") opts.noise_grams = strtof(v, nullptr);
+        else if (key == "--drift") opts.drift_grams_per_min = strtof(v, nullptr);
+        else if (key == "--from") opts.compress_from_ms = strtoul(v, nullptr, 10);
+        else if (key == "--until") opts.compress_until_ms = strtoul(v, nullptr, 10);
+        else if (key == "--sps") opts.sps = strtof(v, nullptr);
+        else if (key == "--seed") opts.seed = strtoul(v, nullptr, 10);
+        else if (key == "--loop-cost") opts.loop_cost_us = strtoul(v, nullptr, 10);
+        else if (key == "--offset") opts.hx711_offset = strtol(v, nullptr, 10);
+        else if (key == "--flash") opts.flash_path = value;
+        else if (key == "--serial") opts.serial_path = value;
+        else if (key == "--quiet") opts.quiet = true;
+        else if (key == "--frames") opts.frames_path = value;
+        else if (key == "--ble") opts.ble_path = value;
+        else if (key == "--tones") opts.tones_path = value;
+        else if (key == "--no-central") opts.central = false;
+        else if (key == "--bounce") opts.bounce_us = strtoul(v, nullptr, 10);
+        else if (key == "--mtu") opts.att_mtu = atoi(v);
+        else if (key == "--press") {
+            std::vector<unsigned long> f;
+            if (!parseList(value, f) || f.size() != 3) return false;
+            opts.presses.push_back({static_cast<int>(f[0]), f[1], f[2]});
+        } else if (key == "--link") {
+            std::vector<unsigned long> f;
+            if (!parseList(value, f) || f.size() != 3 || f[0] == 0 || f[1] == 0 || f[2] == 0) return false;
+            opts.link_interval_ms = f[0];
+            opts.link_per_event = static_cast<int>(f[1]);
+            opts.link_buffers = static_cast<int>(f[2]);
+        } else if (key == "--hx711") {
+            std::vector<unsigned long> f;
+            if (!parseList(value, f) || f.size() != 2) return false;
+            opts.hx711_data_pin = static_cast<int>(f[0]);
+            opts.hx711_clk_pin = static_cast<int>(f[1]);
+        } else if (key == "--central") {
+            std::vector<unsigned long> f;
+            if (!parseList(value, f) || f.size() != 2) return false;
+            opts.central_from_ms = f[0];
+            opts.central_until_ms = f[1];
+        } else if (key == "--ble-write") {
+            size_t a = value.find(':'), b = value.find(':', a + 1);
+            if (a == std::string::npos || b == std::string::npos) return false;
+            BleWrite w;
+            w.at_ms = strtoul(value.substr(0, a).c_str(), nullptr, 10);
+            w.uuid = value.substr(a + 1, b - a - 1);
+            std::string hex = value.substr(b + 1);
+            for (size_t h = 0; h + 1 < hex.size(); h += 2)
+                w.value.push_back(static_cast<uint8_t>(strtoul(hex.substr(h, 2).c_str(), nullptr, 16)));
+            opts.ble_writes.push_back(w);
+        } else {
+            fprintf(stderr, "sim: unknown argument %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+void begin()
+{
+    rng.seed(opts.seed);
+    for (int i = 0; i < NUM_PINS; i++) {
+        levels[i] = LOW;
+        handlers[i] = nullptr;
+        pending[i] = false;
+    }
+    if (!opts.trace_path.empty()) loadTrace();
+    if (!opts.flash_path.empty()) {
+        // a missing file is a board that never ran: the image stays erased
+        FILE *f = fopen(opts.flash_path.c_str(), "rb");
+        if (f) {
+            if (fread(data_flash, 1, DATA_FLASH_SIZE, f) != DATA_FLASH_SIZE) {
+                fprintf(stderr, "sim: %s is shorter than the data flash\n", opts.flash_path.c_str());
+            }
+            fclose(f);
+        }
+    }
+    if (!opts.serial_path.empty()) serial_file = openOrDie(opts.serial_path);
+    if (!opts.frames_path.empty()) frames_file = openOrDie(opts.frames_path);
+    if (!opts.ble_path.empty()) ble_file = openOrDie(opts.ble_path);
+    if (!opts.tones_path.empty()) tones_file = openOrDie(opts.tones_path);
+
+    chip.period_us = static_cast<uint64_t>(1e6 / opts.sps);
+    levels[opts.hx711_data_pin] = HIGH;
+    schedule(chip.period_us, conversion);
+
+    for (const ButtonPress &press : opts.presses) {
+        int pin = press.pin;
+        scheduleBounce(pin, press.at_ms * 1000ULL, LOW);
+        scheduleBounce(pin, (press.at_ms + press.hold_ms) * 1000ULL, HIGH);
+    }
+}
+
+void end()
+{
+    if (serial_file) fclose(serial_file);
+    if (frames_file) fclose(frames_file);
+    if (ble_file) fclose(ble_file);
+    if (tones_file) fclose(tones_file);
+    serial_file = frames_file = ble_file = tones_file = nullptr;
+    if (!opts.flash_path.empty()) {
+        FILE *f = openOrDie(opts.flash_path);
+        fwrite(data_flash, 1, DATA_FLASH_SIZE, f);
+        fclose(f);
+    }
+}
+
+uint8_t *dataFlash() { return data_flash; }
+
+uint64_t nowMicros() { return now_us; }
+
+void schedule(uint64_t at_us, std::function<void()> event)
+{
+    events.emplace(at_us, std::move(event));
+}
+
+void advanceTo(uint64_t us)
+{
+    // events may nest (an ISR delaying inside an event), so always re-read the head
+    while (!events.empty() && events.begin()->first <= us) {
+        auto it = events.begin();
+        std::function<void()> event = std::move(it->second);
+        if (it->first > now_us) now_us = it->first;
+        events.erase(it);
+        event();
+    }
+    if (us > now_us) now_us = us;
+}
+
+void advance(uint64_t us) { advanceTo(now_us + us); }
+
+void waitForInterrupt()
+{
+    if (!pending_irqs.empty()) return;
+    // the core's millis() tick interrupts every 1 ms; anything else that is
+    // scheduled may raise an interrupt too, so wake for it and let loop() decide
+    uint64_t wake = (now_us / 1000 + 1) * 1000;
+    if (!events.empty() && events.begin()->first < wake) wake = events.begin()->first;
+    if (wake <= now_us) return;
+    counters.asleep_us += wake - now_us;
+    advanceTo(wake);
+}
+
+float forceAt(uint64_t us)
+{
+    double ms = us / 1000.0;
+    float drift = opts.drift_grams_per_min * static_cast<float>(ms / 60000.0);
+    if (!trace.empty()) return traceAt(ms) + drift;
+
+    if (ms < opts.compress_from_ms || ms >= opts.compress_until_ms || opts.bpm <= 0) return drift;
+    double period = 60000.0 / opts.bpm;
+    double phase = fmod(ms - opts.compress_from_ms, period) / period;
+    if (phase >= opts.duty) return drift;
+    return drift + opts.peak_grams * static_cast<float>(sin(M_PI * phase / opts.duty));
+}
+
+void driveInput(int pin, int level)
+{
+    if (pin < 0 || pin >= NUM_PINS || levels[pin] == level) return;
+    int old = levels[pin];
+    levels[pin] = level;
+    raiseEdge(pin, old, level);
+}
+
+void onPinWrite(int pin, int level)
+{
+    if (pin == opts.hx711_clk_pin) clockEdge(level);
+}
+
+int pinLevel(int pin)
+{
+    return (pin >= 0 && pin < NUM_PINS) ? levels[pin] : LOW;
+}
+
+void claimPin(int pin, bool claim)
+{
+    if (pin >= 0 && pin < NUM_PINS) claimed[pin] = claim;
+}
+
+bool pinClaimed(int pin)
+{
+    return pin >= 0 && pin < NUM_PINS && claimed[pin];
+}
+
+static void dispatchPending()
+{
+    bool again = true;
+    while (again && irq_enabled && !in_isr) {
+        again = false;
+        for (int pin = 0; pin < NUM_PINS; pin++) {
+            if (!pending[pin] || !handlers[pin]) continue;
+            pending[pin] = false;
+            in_isr = true;
+            handlers[pin]();
+            in_isr = false;
+            again = true;
+        }
+        while (!pending_irqs.empty() && irq_enabled && !in_isr) {
+            std::function<void()> isr = std::move(pending_irqs.front());
+            pending_irqs.erase(pending_irqs.begin());
+            in_isr = true;
+            isr();
+            in_isr = false;
+            again = true;
+        }
+    }
+}
+
+void raiseEdge(int pin, int old_level, int new_level)
+{
+    if (!handlers[pin]) return;
+    int mode = handler_modes[pin];
+    bool fire = mode == CHANGE || (mode == FALLING && old_level == HIGH && new_level == LOW) ||
+                (mode == RISING && old_level == LOW && new_level == HIGH);
+    if (!fire) return;
+    // one flag per line, like the ICU: edges while pending coalesce
+    pending[pin] = true;
+    dispatchPending();
+}
+
+bool interruptsEnabled() { return irq_enabled && !in_isr; }
+
+void raiseIrq(std::function<void()> isr)
+{
+    pending_irqs.push_back(std::move(isr));
+    dispatchPending();
+}
+
+void setHandler(int pin, void (*isr)(), int mode)
+{
+    if (pin < 0 || pin >= NUM_PINS) return;
+    handlers[pin] = isr;
+    handler_modes[pin] = mode;
+    pending[pin] = false;
+}
+
+void setInterruptsEnabled(bool enabled)
+{
+    irq_enabled = enabled;
+    dispatchPending();
+}
+
+FILE *serialOut()
+{
+    if (opts.quiet) return nullptr;
+    return serial_file ? serial_file : stdout;
+}
+
+void recordFrame(const uint8_t *buffer, size_t len, const std::string &text)
+{
+    counters.frames++;
+    if (!frames_file) return;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buffer[i];
+        for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    fprintf(frames_file, "%llu %08x %s\n", static_cast<unsigned long long>(now_us / 1000), ~crc, text.c_str());
+}
+
+void recordNotification(const std::string &uuid, const uint8_t *value, size_t len)
+{
+    counters.notifications++;
+    if (!ble_file) return;
+    fprintf(ble_file, "%llu %s ", static_cast<unsigned long long>(now_us / 1000), uuid.c_str());
+    for (size_t i = 0; i < len; i++) fprintf(ble_file, "%02x", value[i]);
+    fprintf(ble_file, "\n");
+}
+
+void awaitLinkBuffer()
+{
+    if (opts.link_interval_ms == 0) return;
+    uint64_t interval = opts.link_interval_ms * 1000ULL;
+    uint64_t start = now_us;
+    for (;;) {
+        if (now_us >= link.next_event) {
+            uint64_t events = (now_us - link.next_event) / interval + 1;
+            link.queued = static_cast<int>(std::max<int64_t>(0, link.queued - static_cast<int64_t>(events) * opts.link_per_event));
+            link.next_event += events * interval;
+        }
+        if (link.queued < opts.link_buffers) break;
+        advanceTo(link.next_event);
+    }
+    link.queued++;
+    counters.link_blocked_us += now_us - start;
+}
+
+void recordTone(int pin, float hz)
+{
+    if (hz > 0) counters.tones++;
+    if (!tones_file) return;
+    fprintf(tones_file, "%llu %d %.1f\n", static_cast<unsigned long long>(now_us), pin, hz);
+}
+
+static void panelCommands(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if ((c == 0x21 || c == 0x22) && i + 2 < len) {
+            uint8_t a = data[i + 1], b = data[i + 2];
+            if (c == 0x21) {
+                panel.col_start = panel.col = a & 0x7F;
+                panel.col_end = b & 0x7F;
+            } else {
+                panel.page_start = panel.page = a & 0x07;
+                panel.page_end = b > 7 ? 7 : b;
+            }
+            i += 2;
+        } else if (c == 0x20 || c == 0x81 || c == 0x8D || c == 0xA8 || c == 0xD3 || c == 0xD5 ||
+                   c == 0xD9 || c == 0xDA || c == 0xDB) {
+            i++;   // one argument byte
+        }
+    }
+}
+
+static void panelData(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t &cell = panel.gddram[panel.page * 128 + panel.col];
+        if (cell != data[i]) panel.dirty = true;
+        cell = data[i];
+        if (panel.col++ >= panel.col_end) {
+            panel.col = panel.col_start;
+            if (panel.page++ >= panel.page_end) panel.page = panel.page_start;
+        }
+    }
+}
+
+void i2cTransaction(uint8_t address, const uint8_t *data, size_t len)
+{
+    counters.i2c_bytes += len + 1;
+    if ((address != 0x3C && address != 0x3D) || len == 0) return;
+    if (data[0] == 0x40) panelData(data + 1, len - 1);
+    else if (data[0] == 0x00) panelCommands(data + 1, len - 1);
+}
+
+void setDrawnText(const std::string &text) { panel.text = text; }
+
+void capturePanel()
+{
+    if (!panel.dirty) return;
+    panel.dirty = false;
+    recordFrame(panel.gddram, sizeof(panel.gddram), panel.text);
+}
+
+}
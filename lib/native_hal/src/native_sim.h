@@ -0,0 +1,144 @@
+#ifndef NATIVE_SIM_H
+#define NATIVE_SIM_H
+
+// Simulation side of the host HAL: the virtual clock, the event queue that
+// stands in for peripherals running in parallel with the CPU, the simulated
+// HX711 and the recorders for OLED frames and BLE notifications.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace sim {
+
+struct ButtonPress {
+    int pin;
+    unsigned long at_ms;
+    unsigned long hold_ms;
+};
+
+struct BleWrite {
+    unsigned long at_ms;
+    std::string uuid;
+    std::vector<uint8_t> value;
+};
+
+struct Options {
+    unsigned long duration_ms = 60000;
+
+    // force source: a trace file, or the synthetic compression generator
+    std::string trace_path;
+    float bpm = 105.0f;
+    float peak_grams = 30000.0f;
+    float duty = 0.5f;              // fraction of each cycle spent pressing
+    float noise_grams = 20.0f;      // gaussian, per conversion
+    float drift_grams_per_min = 0.0f;
+    unsigned long compress_from_ms = 6000;
+    unsigned long compress_until_ms = 0xFFFFFFFFUL;
+    unsigned int seed = 1;
+
+    // simulated HX711 wiring and conversion constants
+    int hx711_data_pin = 2;
+    int hx711_clk_pin = 7;
+    float sps = 80.0f;
+    long hx711_offset = 8400;
+    float hx711_scale = 117.58f;
+
+    std::vector<ButtonPress> presses;
+    unsigned long bounce_us = 0;    // contact chatter after each press and release
+
+    bool central = true;
+    unsigned long central_from_ms = 0;
+    unsigned long central_until_ms = 0xFFFFFFFFUL;
+    std::vector<BleWrite> ble_writes;
+    // negotiated ATT MTU; notifications carry at most mtu - 3 bytes
+    int att_mtu = 23;
+    // link to a slow central: the radio holds link_buffers notifications and
+    // sends link_per_event of them per connection event; 0 = no limit
+    unsigned long link_interval_ms = 0;
+    int link_per_event = 0;
+    int link_buffers = 0;
+
+    // CPU time charged to every loop() pass on top of what it delays/transfers
+    unsigned long loop_cost_us = 20;
+
+    std::string flash_path;    // data flash image kept across runs; empty = erased at every boot
+    std::string serial_path;   // empty = stdout
+    bool quiet = false;
+    std::string frames_path;
+    std::string ble_path;
+    std::string tones_path;
+};
+
+Options &options();
+
+// The board's 8 KB data flash for the firmware's RamFlashStore: loaded from
+// --flash=FILE in begin() and written back in end()
+constexpr size_t DATA_FLASH_SIZE = 8 * 1024;
+uint8_t *dataFlash();
+
+// Parse --key=value style arguments into options(); returns false on a bad argument
+bool parseArgs(int argc, char **argv);
+void printUsage(const char *program);
+
+void begin();
+void end();
+
+uint64_t nowMicros();
+// Move the clock forward, running every peripheral event that falls due on the way
+void advanceTo(uint64_t us);
+void advance(uint64_t us);
+// Sleep until the next peripheral event or 1 ms tick, whichever is first
+void waitForInterrupt();
+void schedule(uint64_t at_us, std::function<void()> event);
+
+// grams on the load cell at the given time, from the trace or generator
+float forceAt(uint64_t us);
+
+// pin plumbing shared by the Arduino shim and the simulated devices
+void driveInput(int pin, int level);
+void onPinWrite(int pin, int level);
+int pinLevel(int pin);
+// a pin a peripheral took over (SPI.begin() takes SCK): digitalWrite() doesn't
+// reach it until pinMode() makes it a GPIO again, as on the R4 core
+void claimPin(int pin, bool claimed);
+bool pinClaimed(int pin);
+void raiseEdge(int pin, int old_level, int new_level);
+bool interruptsEnabled();
+void setHandler(int pin, void (*isr)(), int mode);
+void setInterruptsEnabled(bool enabled);
+// a peripheral interrupt (timer overflow): runs now, or once interrupts are enabled again
+void raiseIrq(std::function<void()> isr);
+
+// recorders
+FILE *serialOut();
+void recordFrame(const uint8_t *buffer, size_t len, const std::string &text);
+void recordNotification(const std::string &uuid, const uint8_t *value, size_t len);
+// a notification waiting for a radio buffer blocks the caller, like ArduinoBLE's HCI layer
+void awaitLinkBuffer();
+// speaker output switched on at `hz` (0 = silent)
+void recordTone(int pin, float hz);
+// one I2C write; the SSD1306 at 0x3C/0x3D keeps its own GDDRAM from these
+void i2cTransaction(uint8_t address, const uint8_t *data, size_t len);
+// text last drawn through Adafruit_GFX, logged next to each frame
+void setDrawnText(const std::string &text);
+// record the panel contents if they changed since the last frame
+void capturePanel();
+
+struct Stats {
+    unsigned long loops = 0;
+    unsigned long frames = 0;
+    unsigned long notifications = 0;
+    unsigned long i2c_bytes = 0;
+    unsigned long conversions = 0;
+    unsigned long tones = 0;
+    uint64_t asleep_us = 0;
+    uint64_t link_blocked_us = 0;
+};
+Stats &stats();
+
+}
+
+#endif
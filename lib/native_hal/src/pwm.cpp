@@ -0,0 +1,43 @@
+#include "pwm.h"
+#include "native_sim.h"
+
+bool PwmOut::begin(float freq_hz, float duty_perc)
+{
+    float old_hz = hz_;
+    bool was_on = duty_ > 0;
+    hz_ = freq_hz;
+    duty_ = duty_perc;
+    changed(old_hz, was_on);
+    return freq_hz > 0;
+}
+
+bool PwmOut::period_us(int us)
+{
+    if (us <= 0) return false;
+    float old_hz = hz_;
+    hz_ = 1e6f / us;
+    changed(old_hz, duty_ > 0);
+    return true;
+}
+
+bool PwmOut::pulse_perc(float duty)
+{
+    bool was_on = duty_ > 0;
+    duty_ = duty;
+    changed(hz_, was_on);
+    return true;
+}
+
+void PwmOut::end()
+{
+    bool was_on = duty_ > 0;
+    duty_ = 0;
+    changed(hz_, was_on);
+}
+
+void PwmOut::changed(float old_hz, bool was_on)
+{
+    bool on = duty_ > 0 && hz_ > 0;
+    if (on && (!was_on || old_hz != hz_)) sim::recordTone(pin_, hz_);
+    else if (!on && was_on) sim::recordTone(pin_, 0);
+}
@@ -0,0 +1,24 @@
+#ifndef NATIVE_PWM_H
+#define NATIVE_PWM_H
+
+// Host stand-in for the Renesas core's PwmOut. Only the audible state matters
+// here: every change of frequency or on/off is logged as a tone event.
+
+class PwmOut {
+public:
+    explicit PwmOut(int pinNumber) : pin_(pinNumber) {}
+
+    bool begin(float freq_hz, float duty_perc);
+    bool period_us(int us);
+    bool pulse_perc(float duty);
+    void end();
+
+private:
+    void changed(float old_hz, bool was_on);
+
+    int pin_;
+    float hz_ = 0;
+    float duty_ = 0;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "background_tare.h"
+#include <math.h>
+
+void BackgroundTare::begin(int32_t offset, float gain, unsigned long now)
+{
+    running_ = true;
+    restored_ = offset;
+    offset_ = offset;
+    gain_ = gain;
+    start_ = now;
+    sum_ = 0;
+    count_ = 0;
+    drift_grams_ = 0.0f;
+}
+
+BackgroundTare::Result BackgroundTare::add(int32_t raw, unsigned long timestamp)
+{
+    if (!running_) return RUNNING;
+    if (count_ == 0 || raw < min_) min_ = raw;
+    if (count_ == 0 || raw > max_) max_ = raw;
+    sum_ += raw;
+    count_++;
+    if (timestamp - start_ < WINDOW_MS) return RUNNING;
+
+    running_ = false;
+    int32_t mean = static_cast<int32_t>(sum_ / static_cast<int64_t>(count_));
+    drift_grams_ = (mean - restored_) * gain_;
+    if ((max_ - min_) * fabsf(gain_) > STILL_GRAMS) return MOVING;
+    if (fabsf(drift_grams_) > MAX_DRIFT_GRAMS) return LOADED;
+    offset_ = mean;
+    return ACCEPTED;
+}
@@ -0,0 +1,566 @@
+#ifdef PULSECOACH_BENCH
+
+#include <HX711.h>
+#include "bench.h"
+#include "bpm_helper.h"
+#include "bulk_transfer.h"
+#include "compression_detector.h"
+#include "compression_history.h"
+#include "cycle_counter.h"
+#include "dsp_kernels.h"
+#include "feedback_display.h"
+#include "flash_store.h"
+#include "hx711_driver.h"
+#include "load_cell_isr.h"
+#include "loop.h"
+#include "waveform_codec.h"
+
+void loop();
+extern Hx711Driver loadCell;
+
+namespace {
+
+volatile float sink;
+
+struct BenchResult {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    int iters;
+};
+
+uint32_t microsClock() { return micros(); }
+
+template <typename F>
+BenchResult measure(int iters, F fn, uint32_t (*clock)() = cycleCount)
+{
+    BenchResult r = {0xFFFFFFFFUL, 0, 0, iters};
+    for (int i = 0; i < iters; i++) {
+        uint32_t start = clock();
+        fn();
+        uint32_t elapsed = clock() - start;
+        if (elapsed < r.min) r.min = elapsed;
+        if (elapsed > r.max) r.max = elapsed;
+        r.total += elapsed;
+    }
+    return r;
+}
+
+void report(Print &out, const char *name, int n, const BenchResult &r, const char *unit = CYCLE_COUNTER_UNIT)
+{
+    out.print("bench ");
+    out.print(name);
+    out.print(" n=");
+    out.print(n);
+    out.print(" iters=");
+    out.print(r.iters);
+    out.print(" min=");
+    out.print(r.min);
+    out.print(" avg=");
+    out.print(static_cast<unsigned long>(r.total / r.iters));
+    out.print(" max=");
+    out.print(r.max);
+    out.print(" ");
+    out.println(unit);
+}
+
+// realistic press times: ~105 BPM with a little jitter
+void fillTimes(std::vector<unsigned long> &times, int n)
+{
+    times.clear();
+    unsigned long t = 10000;
+    for (int i = 0; i < n; i++) {
+        times.push_back(t);
+        t += 540 + (i * 37) % 60;
+    }
+}
+
+template <size_t N>
+void benchHistory(Print &out, int iters)
+{
+    static CompressionHistory<N, BPM_WINDOW> history;
+    history.clear();
+    unsigned long t = 10000;
+    // warm up to full so every measured push also evicts
+    for (size_t i = 0; i < N; i++) history.push_back(t += 570);
+    report(out, "history_push", N, measure(iters, [&] { history.push_back(t += 540 + (t % 60)); }));
+    report(out, "history_stats", N, measure(iters, [&] { sink = computeBpmStats(history, N).weighted_mean; }));
+}
+
+constexpr int TRACE_SAMPLES = 400;   // 5 s at 80 SPS
+int32_t trace[TRACE_SAMPLES];
+
+// synthetic 105 BPM compressions, 30 kg peaks and a little noise, at 80 SPS
+void fillSyntheticTrace()
+{
+    uint32_t seed = 1;
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        float phase = fmodf(i * 12.5f, 571.4f) / 571.4f;
+        float grams = phase < 0.5f ? 30000.0f * sinf(PI * phase / 0.5f) : 0.0f;
+        seed = seed * 1103515245UL + 12345;
+        trace[i] = lroundf(grams) + static_cast<int32_t>((seed >> 16) % 41) - 20;
+    }
+}
+
+// 5 s of whatever the load cell measures right now (a recorded trace in the sim)
+int captureLiveTrace()
+{
+    int n = 0;
+    unsigned long start = millis();
+    LoadCellSample sample;
+    while (n < TRACE_SAMPLES && millis() - start < 10000) {
+        if (loadCellPop(sample)) trace[n++] = lroundf(loadCell.toGrams(sample.raw));
+        else yield();
+    }
+    return n;
+}
+
+// raw -> Q15 force for the whole trace: a float divide per conversion as in
+// the HX711 library's get_units(), against the driver's fixed-point multipliers
+void benchConvert(Print &out, int iters)
+{
+    static int32_t raw[TRACE_SAMPLES];
+    const int32_t offset = 8400;
+    const float counts_per_gram = 117.58f;
+    for (int i = 0; i < TRACE_SAMPLES; i++) raw[i] = offset + lroundf(trace[i] * counts_per_gram);
+    volatile int16_t q15 = 0;
+
+    report(out, "convert_float_divide", TRACE_SAMPLES, measure(iters, [&] {
+        for (int i = 0; i < TRACE_SAMPLES; i++) q15 = gramsToQ15((raw[i] - offset) / counts_per_gram);
+    }));
+    Hx711Driver cell;
+    cell.setOffset(offset);
+    cell.setCalibration(1.0f / counts_per_gram);
+    report(out, "convert_fixed_linear", TRACE_SAMPLES, measure(iters, [&] {
+        for (int i = 0; i < TRACE_SAMPLES; i++) q15 = gramsFixedToQ15(cell.toGramsFixed(raw[i]), Hx711Driver::GRAMS_FRAC_BITS);
+    }));
+    cell.setCalibration(1.0f / counts_per_gram, 1.2e-11f);
+    report(out, "convert_fixed_curve", TRACE_SAMPLES, measure(iters, [&] {
+        for (int i = 0; i < TRACE_SAMPLES; i++) q15 = gramsFixedToQ15(cell.toGramsFixed(raw[i]), Hx711Driver::GRAMS_FRAC_BITS);
+    }));
+}
+
+// Bytes per sample on the wire and encode time for the trace in frames of the
+// given size; test/test_waveform_codec checks that it decodes
+void benchWaveform(Print &out, const char *name, int n, size_t frame_size)
+{
+    WaveformEncoder encoder(frame_size);
+    uint8_t frame[WaveformEncoder::MAX_FRAME];
+    size_t bytes = 0;
+    uint32_t cycles = 0;
+
+    for (int i = 0; i < n; i++) {
+        uint32_t start = cycleCount();
+        bool added = encoder.add(trace[i], i * 12);
+        cycles += cycleCount() - start;
+        if (!added) {
+            bytes += encoder.flush(frame);
+            encoder.add(trace[i], i * 12);
+        }
+    }
+    if (encoder.count() > 0) bytes += encoder.flush(frame);
+
+    out.print("bench ");
+    out.print(name);
+    out.print(" frame=");
+    out.print(static_cast<unsigned long>(frame_size));
+    out.print(" samples=");
+    out.print(n);
+    out.print(" bytes_per_sample=");
+    out.print(n > 0 ? static_cast<double>(bytes) / n : 0.0, 3);
+    out.print(" encode_avg=");
+    out.print(n > 0 ? cycles / n : 0);
+    out.println(" " CYCLE_COUNTER_UNIT);
+}
+
+// CPU time per sample for the detector update with its own IIR low-pass;
+// test/test_compression_detector checks what it detects
+void benchDetector(Print &out, const char *name, int n)
+{
+    CompressionDetector detector;
+    uint32_t cycles = 0;
+    for (int i = 0; i < n; i++) {
+        uint32_t start = cycleCount();
+        detector.update(trace[i], i * 12);
+        cycles += cycleCount() - start;
+    }
+
+    out.print("bench ");
+    out.print(name);
+    out.print(" samples=");
+    out.print(n);
+    out.print(" update_avg=");
+    out.print(n > 0 ? cycles / n : 0);
+    out.println(" " CYCLE_COUNTER_UNIT);
+}
+
+// q15 block kernels: per-sample cost of the scalar and dual-MAC versions
+// against a float FIR. Off the M4 the dual-MAC one would only time the
+// portable instruction stand-ins, so it prints n/a there.
+// test/test_dsp_kernels checks that the versions agree.
+void benchBlockFilter(Print &out, size_t block)
+{
+    const int16_t *taps = LoadCellBlockFilter::LOWPASS;
+    constexpr int HISTORY = LoadCellBlockFilter::TAPS - 1;
+    static int16_t x[HISTORY + TRACE_SAMPLES];
+    static int16_t y[TRACE_SAMPLES], d[TRACE_SAMPLES];
+    for (int i = 0; i < HISTORY; i++) x[i] = 0;
+    for (int i = 0; i < TRACE_SAMPLES; i++) x[HISTORY + i] = gramsToQ15(trace[i]);
+
+    int blocks = TRACE_SAMPLES / block;
+    int samples = blocks * block;
+    const int16_t zero[2] = {0, 0};
+    auto run = [&](void (*fir)(const int16_t *, int, const int16_t *, int16_t *, size_t),
+                   void (*slope)(const int16_t *, const int16_t *, int16_t *, size_t)) {
+        uint32_t cycles = 0;
+        for (int b = 0; b < blocks; b++) {
+            int16_t *yb = y + b * block;
+            const int16_t *prev = b == 0 ? zero : yb - 2;
+            uint32_t start = cycleCount();
+            fir(taps, LoadCellBlockFilter::TAPS, x + b * block, yb, block);
+            slope(prev, yb, d + b * block, block);
+            cycles += cycleCount() - start;
+        }
+        return cycles;
+    };
+
+    uint32_t scalar = run(firQ15Scalar, slopeQ15Scalar);
+
+    uint32_t float_cycles = 0;
+    for (int i = 0; i < samples; i++) {
+        uint32_t start = cycleCount();
+        float acc = 0;
+        for (int k = 0; k < LoadCellBlockFilter::TAPS; k++) acc += taps[k] / 32768.0f * x[i + k];
+        sink = acc;
+        float_cycles += cycleCount() - start;
+    }
+
+    out.print("bench fir_q15 block=");
+    out.print(static_cast<unsigned long>(block));
+    out.print(" samples=");
+    out.print(samples);
+    out.print(" scalar=");
+    out.print(samples > 0 ? scalar / samples : 0);
+#if defined(__ARM_FEATURE_DSP)
+    uint32_t simd = run(firQ15Simd, slopeQ15Simd);
+    out.print(" simd=");
+    out.print(samples > 0 ? simd / samples : 0);
+#else
+    out.print(" simd=n/a");
+#endif
+    out.print(" float=");
+    out.print(samples > 0 ? float_cycles / samples : 0);
+    out.println(" " CYCLE_COUNTER_UNIT "/sample");
+}
+
+// Loopback stand-in for the BLE link: one connection event every
+// LINK_INTERVAL_US carries up to LINK_PACKETS notifications, and a central
+// write reaches the device at the following event. loss_pct of the
+// notifications are dropped at random to exercise the go-back.
+constexpr unsigned long LINK_INTERVAL_US = 15000;
+constexpr int LINK_PACKETS = 6;
+constexpr unsigned long LINK_LIMIT_US = 120000000UL;
+uint8_t bulk_image[8 * 512];
+std::vector<uint8_t> bulk_reference;
+
+// The app side: reassembles in order, acks every half window, at the end and
+// a NAK once for each gap
+struct LoopbackCentral {
+    std::vector<uint8_t> data;
+    std::vector<std::vector<uint8_t>> outbox;
+    uint32_t log_id = 0;
+    uint32_t total = 0;
+    uint32_t received = 0;
+    uint32_t acked = 0;
+    size_t chunk = 0;
+    uint8_t window = 1;
+    bool gap = false;
+    bool done = false;
+    bool error = false;
+
+    static uint32_t u32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+    void command(std::initializer_list<uint8_t> head, uint32_t a, uint32_t b, bool with_b)
+    {
+        std::vector<uint8_t> c(head);
+        for (int i = 0; i < 4; i++) c.push_back((a >> (8 * i)) & 0xFF);
+        for (int i = 0; with_b && i < 4; i++) c.push_back((b >> (8 * i)) & 0xFF);
+        outbox.push_back(c);
+    }
+
+    void start(uint16_t mtu, uint8_t window_chunks)
+    {
+        chunk = mtu - 3 - BulkSender::DATA_HEADER;
+        done = error = false;
+        // resumes if the log is the one we were downloading
+        command({BulkSender::CMD_START, static_cast<uint8_t>(mtu & 0xFF), static_cast<uint8_t>(mtu >> 8), window_chunks},
+                log_id, received, true);
+    }
+
+    void receive(const uint8_t *p, size_t len)
+    {
+        switch (p[0]) {
+        case BulkSender::PKT_INFO:
+            log_id = u32(p + 1);
+            received = acked = u32(p + 5);
+            total = u32(p + 9);
+            window = p[13];
+            data.resize(received);
+            break;
+        case BulkSender::PKT_DATA:
+            // go-back-N: anything past a gap comes again; say so once per gap
+            if (u32(p + 1) != received) {
+                if (!gap) command({BulkSender::CMD_NAK}, received, 0, false);
+                gap = true;
+                break;
+            }
+            gap = false;
+            data.insert(data.end(), p + BulkSender::DATA_HEADER, p + len);
+            received += len - BulkSender::DATA_HEADER;
+            if (received == total || received - acked >= window * chunk / 2) {
+                command({BulkSender::CMD_ACK}, received, 0, false);
+                acked = received;
+            }
+            break;
+        case BulkSender::PKT_DONE:
+            done = true;
+            break;
+        case BulkSender::PKT_ERROR:
+            error = true;
+            break;
+        }
+    }
+};
+
+// Runs connection events until the download ends or stop_at bytes arrived;
+// returns the link time used and adds the CPU time per packet to cycles
+unsigned long runLoopback(BulkSender &sender, LoopbackCentral &central, int loss_pct, uint32_t stop_at,
+                          uint32_t &cycles, uint32_t &packets, uint32_t &seed)
+{
+    uint8_t packet[BulkSender::MAX_PACKET];
+    unsigned long t = 0;
+    while (!central.done && !central.error && t < LINK_LIMIT_US) {
+        t += LINK_INTERVAL_US;
+        unsigned long now = t / 1000;
+        for (const std::vector<uint8_t> &c : central.outbox) sender.onCommand(c.data(), c.size(), now);
+        central.outbox.clear();
+        for (int k = 0; k < LINK_PACKETS; k++) {
+            uint32_t start = cycleCount();
+            size_t len = sender.fill(packet, now);
+            if (len > 0) sender.sent(now);
+            cycles += cycleCount() - start;
+            if (len == 0) break;
+            packets++;
+            seed = seed * 1103515245UL + 12345;
+            if (static_cast<int>((seed >> 16) % 100) < loss_pct) continue;
+            central.receive(packet, len);
+        }
+        if (stop_at && central.received >= stop_at) {
+            sender.stop();
+            break;
+        }
+    }
+    return t;
+}
+
+// Fills a small RAM log with sessions until it has wrapped and keeps the
+// record stream as the app should see it
+void fillBulkLog(SessionLog &log)
+{
+    for (int s = 0; s < 24; s++) {
+        log.beginSession(s * 20000UL);
+        for (int i = 0; i < 30; i++) {
+            CompressionQuality q = {};
+            q.press_time = s * 20000UL + 500 + i * 570 + (i * 37) % 40;
+            q.peak_grams = 20000.0f + (i * 7919 % 23) * 1000.0f;
+            q.residual_grams = (i % 5) * 400.0f;
+            q.duty_pct = 45 + i % 10;
+            log.addCompression(q);
+            while (!log.idle()) log.pump();
+        }
+        log.endSession(s * 20000UL + 18000, SessionLog::Summary{105.0f, 0.9f, 0.85f});
+        while (!log.idle()) log.pump();
+    }
+
+    bulk_reference.clear();
+    SessionLog::Cursor cursor = log.begin();
+    SessionLog::Record record;
+    while (log.next(cursor, record)) {
+        bulk_reference.push_back(record.type);
+        bulk_reference.push_back(record.len);
+        bulk_reference.insert(bulk_reference.end(), record.payload, record.payload + record.len);
+    }
+}
+
+// Download throughput over the loopback link for one MTU/window pair, and
+// whether the reassembled stream matches the log byte for byte. With resume
+// the link drops halfway and the app picks up from the offset it had.
+void benchBulk(Print &out, SessionLog &log, uint16_t mtu, uint8_t window, int loss_pct, bool resume)
+{
+    BulkSender sender(log);
+    LoopbackCentral central;
+    uint32_t cycles = 0, packets = 0, seed = 11;
+    unsigned long us = 0;
+    uint32_t resumed_at = 0;
+    if (resume) {
+        central.start(mtu, window);
+        us += runLoopback(sender, central, loss_pct, bulk_reference.size() / 2, cycles, packets, seed);
+        resumed_at = central.received;
+    }
+    central.start(mtu, window);
+    us += runLoopback(sender, central, loss_pct, 0, cycles, packets, seed);
+    bool ok = central.done && central.data == bulk_reference;
+
+    out.print("bench bulk mtu=");
+    out.print(mtu);
+    out.print(" window=");
+    out.print(window);
+    out.print(" loss=");
+    out.print(loss_pct);
+    out.print("% bytes=");
+    out.print(static_cast<unsigned long>(bulk_reference.size()));
+    if (resume) {
+        out.print(" resumed_at=");
+        out.print(static_cast<unsigned long>(resumed_at));
+    }
+    out.print(" link_ms=");
+    out.print(us / 1000);
+    out.print(" bytes_per_s=");
+    out.print(us > 0 ? static_cast<unsigned long>(bulk_reference.size() * 1000000ULL / us) : 0);
+    out.print(" retransmits=");
+    out.print(sender.retransmits());
+    out.print(" fill_avg=");
+    out.print(packets > 0 ? cycles / packets : 0);
+    out.print(" " CYCLE_COUNTER_UNIT " ok=");
+    out.println(ok ? 1 : 0);
+}
+
+// Wait for a conversion outside the timed region, then time only the readout.
+// The bogde library's read() would otherwise charge its own wait_ready() here.
+template <typename Ready, typename Read>
+BenchResult measureReadout(int iters, Ready ready, Read read, uint32_t (*clock)())
+{
+    BenchResult r = {0xFFFFFFFFUL, 0, 0, 0};
+    unsigned long start_ms = millis();
+    while (r.iters < iters && millis() - start_ms < 5000) {
+        if (!ready()) {
+            yield();
+            continue;
+        }
+        uint32_t start = clock();
+        read();
+        uint32_t elapsed = clock() - start;
+        if (elapsed < r.min) r.min = elapsed;
+        if (elapsed > r.max) r.max = elapsed;
+        r.total += elapsed;
+        r.iters++;
+    }
+    if (r.iters == 0) r = {0, 0, 0, 1};
+    return r;
+}
+
+// CPU time per HX711 sample: our driver on each backend against the bogde
+// library's read() on the same wiring. The DRDY interrupt is detached while
+// this runs and every reader leaves the chip idle with PD_SCK low.
+void benchHx711(Print &out, int iters)
+{
+    loadCellIsrEnd();
+    Hx711Reading reading;
+    const int dout = loadCell.doutPin(), sck = loadCell.sckPin();
+    const Hx711Driver::Gain gain = loadCell.gain();
+    const Hx711Driver::Backend backend = loadCell.backend();
+
+    for (int b = Hx711Driver::BITBANG; b <= backend; b++) {
+        loadCell.begin(dout, sck, gain, static_cast<Hx711Driver::Backend>(b), loadCell.ratePin());
+        const char *name = b == Hx711Driver::SPI_MOSI ? "hx711_spi" : "hx711_bitbang";
+        auto ready = [] { return loadCell.isReady(); };
+        auto read = [&] { loadCell.tryRead(reading); };
+        report(out, name, 1, measureReadout(iters, ready, read, cycleCount));
+        report(out, name, 1, measureReadout(iters, ready, read, microsClock), "us");
+    }
+
+    HX711 library;
+    library.begin(dout, sck);
+    auto ready = [&] { return library.is_ready(); };
+    auto read = [&] { sink = library.read(); };
+    report(out, "hx711_bogde", 1, measureReadout(iters, ready, read, cycleCount));
+    report(out, "hx711_bogde", 1, measureReadout(iters, ready, read, microsClock), "us");
+
+    loadCell.begin(dout, sck, gain, backend, loadCell.ratePin());
+    loadCellIsrBegin(loadCell);
+}
+
+}
+
+void runBenchmarks(Print &out, Adafruit_SSD1306 &display)
+{
+    constexpr int ITERS = 200;
+    cycleCounterBegin();
+    out.println("bench begin");
+
+    std::vector<unsigned long> times;
+    const int windows[] = {2, 5, SAMPLE_SIZE, 32, 128};
+    for (int n : windows) {
+        fillTimes(times, n);
+        report(out, "computeBpmStats", n, measure(ITERS, [&] { sink = computeBpmStats(times, n).std_dev; }));
+        report(out, "calculateWeightedAverageBPM", n,
+               measure(ITERS, [&] { sink = calculateWeightedAverageBPM(times, n); }));
+        report(out, "calculateBPMStandardDeviation", n,
+               measure(ITERS, [&] { sink = calculateBPMStandardDeviation(times, n); }));
+    }
+    // logs its verdict at debug level, so this includes queueing a record when that is compiled in
+    fillTimes(times, SAMPLE_SIZE);
+    report(out, "isConsistentCompression", SAMPLE_SIZE, measure(20, [&] { sink = isConsistentCompression(times); }));
+
+    benchHistory<BPM_WINDOW + 1>(out, ITERS);
+    benchHistory<SAMPLE_SIZE>(out, ITERS);
+    benchHistory<32>(out, ITERS);
+    benchHistory<128>(out, ITERS);
+
+    report(out, "setStackedText", 1, measure(ITERS, [&] {
+        clearOled(display);
+        setStackedText(display, "GOOD", "PACE", 2, SSD1306_WHITE);
+    }));
+    report(out, "display", 1, measure(20, [&] { display.display(); }));
+    // dirty-page path: alternate two messages so every call really redraws
+    FeedbackDisplay renderer(display, Wire, 0x3C);
+    renderer.showPace(PACE_GOOD);
+    int flip = 0;
+    report(out, "feedback_redraw", 1, measure(20, [&] { renderer.showPace(++flip & 1 ? PACE_TOO_FAST : PACE_TOO_SLOW); }));
+    report(out, "feedback_unchanged", 1, measure(ITERS, [&] { renderer.showPace(flip & 1 ? PACE_TOO_FAST : PACE_TOO_SLOW); }));
+
+    benchHx711(out, 40);
+
+    const size_t frames[] = {20, 64, WaveformEncoder::MAX_FRAME};
+    fillSyntheticTrace();
+    benchConvert(out, 20);
+    for (size_t f : frames) benchWaveform(out, "waveform_synthetic", TRACE_SAMPLES, f);
+    benchDetector(out, "detector_synthetic", TRACE_SAMPLES);
+    int live = captureLiveTrace();
+    for (size_t f : frames) benchWaveform(out, "waveform_live", live, f);
+    benchDetector(out, "detector_live", live);
+
+    const size_t blocks[] = {1, 4, LoadCellBlockFilter::BLOCK};
+    for (size_t b : blocks) benchBlockFilter(out, b);
+
+    RamFlashStore bulk_flash(bulk_image, sizeof(bulk_image), 512);
+    SessionLog bulk_log(bulk_flash);
+    bulk_log.mount();
+    fillBulkLog(bulk_log);
+    const uint16_t mtus[] = {BulkSender::MIN_MTU, 185, BulkSender::MAX_MTU};
+    const uint8_t bulk_windows[] = {1, 4, BulkSender::MAX_WINDOW};
+    for (uint16_t m : mtus) {
+        for (uint8_t w : bulk_windows) benchBulk(out, bulk_log, m, w, 0, false);
+    }
+    benchBulk(out, bulk_log, BulkSender::MIN_MTU, BulkSender::MAX_WINDOW, 2, false);
+    benchBulk(out, bulk_log, BulkSender::MAX_MTU, BulkSender::MAX_WINDOW, 0, true);
+
+    // macro: complete loop() passes with whatever the load cell is doing right now
+    report(out, "loop", 1, measure(100, [] { loop(); }));
+    // same in micros(): wall time on the board, modelled bus/UART time on the host
+    report(out, "loop_period", 1, measure(100, [] { loop(); }, microsClock), "us");
+
+    out.println("bench end");
+}
+
+#endif
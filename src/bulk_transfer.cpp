@@ -0,0 +1,186 @@
+#include "bulk_transfer.h"
+#include <string.h>
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+void BulkSender::onCommand(const uint8_t *data, size_t len, unsigned long now)
+{
+    if (len == 0) return;
+    switch (data[0]) {
+    case CMD_START:
+        if (len < 12) break;
+        start(data[1] | (data[2] << 8), data[3], getU32(data + 4), getU32(data + 8), now);
+        return;
+    case CMD_ACK:
+    case CMD_NAK: {
+        if (len < 5) break;
+        if (state_ != SENDING) return;
+        uint32_t offset = getU32(data + 1);
+        // out of range, or stale: cumulative acks make dropping it safe
+        if (offset > total_ || offset < acked_ || (offset == acked_ && data[0] == CMD_ACK)) return;
+        if (offset > acked_) last_progress_ = now;
+        acked_ = offset;
+        if (acked_ == total_) {
+            state_ = SEND_DONE;
+        } else if (data[0] == CMD_NAK) {
+            // the app saw a gap at offset: go back now rather than on the timeout
+            seek(pos_, acked_);
+            last_progress_ = now;
+            retransmits_++;
+        } else if (acked_ > pos_.offset) {
+            // an ack from before a go-back covers data we are about to resend
+            seek(pos_, acked_);
+        }
+        return;
+    }
+    case CMD_STOP:
+        state_ = IDLE;
+        return;
+    }
+    fail(ERR_BAD_COMMAND);
+}
+
+void BulkSender::stop()
+{
+    state_ = IDLE;
+}
+
+void BulkSender::start(uint16_t mtu, uint8_t window, uint32_t log_id, uint32_t offset, unsigned long now)
+{
+    if (mtu < MIN_MTU) mtu = MIN_MTU;
+    if (mtu > MAX_MTU) mtu = MAX_MTU;
+    chunk_ = mtu - 3 - DATA_HEADER;
+    window_ = window < 1 ? 1 : window > MAX_WINDOW ? MAX_WINDOW : window;
+
+    log_id_ = log_.oldestSeq();
+    seek(pos_, 0xFFFFFFFFUL);
+    total_ = pos_.offset;
+    // resume only into the same log; anything else starts over
+    start_offset_ = log_id == log_id_ && offset <= total_ ? offset : 0;
+    seek(pos_, start_offset_);
+
+    acked_ = start_offset_;
+    started_at_ = now;
+    last_progress_ = now;
+    state_ = SEND_INFO;
+}
+
+void BulkSender::fail(uint8_t reason)
+{
+    error_ = reason;
+    state_ = SEND_ERROR;
+}
+
+void BulkSender::seek(Position &pos, uint32_t offset)
+{
+    pos.cursor = log_.begin();
+    pos.has_record = false;
+    pos.used = 0;
+    pos.offset = 0;
+    advance(pos, nullptr, offset);
+}
+
+size_t BulkSender::advance(Position &pos, uint8_t *out, size_t max)
+{
+    size_t n = 0;
+    while (n < max) {
+        if (!pos.has_record || pos.used == pos.record.len + 2) {
+            if (!log_.next(pos.cursor, pos.record)) break;
+            pos.has_record = true;
+            pos.used = 0;
+        }
+        // the record as streamed: type | len | payload
+        if (pos.used < 2) {
+            if (out) out[n] = pos.used == 0 ? pos.record.type : pos.record.len;
+            pos.used++;
+            n++;
+            continue;
+        }
+        size_t left = pos.record.len + 2 - pos.used;
+        size_t take = max - n < left ? max - n : left;
+        if (out) memcpy(out + n, pos.record.payload + pos.used - 2, take);
+        pos.used += take;
+        n += take;
+    }
+    pos.offset += n;
+    return n;
+}
+
+size_t BulkSender::fill(uint8_t *out, unsigned long now)
+{
+    if ((state_ == SEND_INFO || state_ == SENDING) && log_.oldestSeq() != log_id_) fail(ERR_LOG_CHANGED);
+
+    switch (state_) {
+    case IDLE:
+        return 0;
+
+    case SEND_INFO:
+        out[0] = PKT_INFO;
+        putU32(out + 1, log_id_);
+        putU32(out + 5, start_offset_);
+        putU32(out + 9, total_);
+        out[13] = window_;
+        return 14;
+
+    case SEND_DONE:
+        out[0] = PKT_DONE;
+        putU32(out + 1, total_);
+        return 5;
+
+    case SEND_ERROR:
+        out[0] = PKT_ERROR;
+        out[1] = error_;
+        return 2;
+
+    case SENDING:
+        break;
+    }
+
+    if (pos_.offset == total_ || pos_.offset - acked_ >= window_ * chunk_) {
+        if (acked_ == pos_.offset || now - last_progress_ < ACK_TIMEOUT_MS) return 0;
+        // nothing acked for a while: resend from the last ack
+        seek(pos_, acked_);
+        last_progress_ = now;
+        retransmits_++;
+    }
+
+    staged_ = pos_;
+    uint32_t left = total_ - pos_.offset;
+    out[0] = PKT_DATA;
+    putU32(out + 1, pos_.offset);
+    return DATA_HEADER + advance(staged_, out + DATA_HEADER, left < chunk_ ? left : chunk_);
+}
+
+void BulkSender::sent(unsigned long now)
+{
+    switch (state_) {
+    case SEND_INFO:
+        state_ = acked_ == total_ ? SEND_DONE : SENDING;
+        break;
+    case SENDING:
+        pos_ = staged_;
+        break;
+    case SEND_DONE:
+        last_bytes_ = total_ - start_offset_;
+        last_ms_ = now - started_at_;
+        transfers_++;
+        state_ = IDLE;
+        break;
+    case SEND_ERROR:
+        state_ = IDLE;
+        break;
+    case IDLE:
+        break;
+    }
+}
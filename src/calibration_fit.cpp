@@ -0,0 +1,137 @@
+#include "calibration_fit.h"
+#include <math.h>
+
+void CalibrationFit::reset()
+{
+    points_ = 0;
+    state_ = IDLE;
+}
+
+bool CalibrationFit::capture(float grams, float gain)
+{
+    if (points_ == MAX_POINTS || gain == 0.0f) return false;
+    grams_ = grams;
+    max_sd_counts_ = STILL_GRAMS / fabsf(gain);
+    count_ = 0;
+    tries_ = 0;
+    state_ = CAPTURING;
+    return true;
+}
+
+CalibrationFit::Capture CalibrationFit::add(int32_t raw)
+{
+    if (state_ != CAPTURING) return state_;
+    if (count_ == 0) {
+        first_ = raw;
+        sum_ = 0;
+        sum_sq_ = 0;
+    }
+    int64_t d = raw - first_;
+    sum_ += d;
+    sum_sq_ += d * d;
+    if (++count_ < SAMPLES) return CAPTURING;
+
+    count_ = 0;
+    float mean = static_cast<float>(sum_) / SAMPLES;
+    float variance = static_cast<float>(sum_sq_) / SAMPLES - mean * mean;
+    if (variance > max_sd_counts_ * max_sd_counts_) {
+        if (++tries_ < MAX_TRIES) return CAPTURING;
+        state_ = IDLE;
+        return UNSTEADY;
+    }
+    point_[points_++] = Point{first_ + static_cast<int32_t>(lroundf(mean)), grams_};
+    state_ = IDLE;
+    return CAPTURED;
+}
+
+// Solves the n x n system a * x = b in place (Gaussian elimination, partial pivoting)
+static bool solve(double a[3][3], double b[3], int n)
+{
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+        }
+        if (fabs(a[pivot][col]) < 1e-12) return false;
+        for (int c = 0; c < n; c++) {
+            double t = a[col][c];
+            a[col][c] = a[pivot][c];
+            a[pivot][c] = t;
+        }
+        double t = b[col];
+        b[col] = b[pivot];
+        b[pivot] = t;
+        for (int r = col + 1; r < n; r++) {
+            double f = a[r][col] / a[col][col];
+            for (int c = col; c < n; c++) a[r][c] -= f * a[col][c];
+            b[r] -= f * b[col];
+        }
+    }
+    for (int r = n - 1; r >= 0; r--) {
+        for (int c = r + 1; c < n; c++) b[r] -= a[r][c] * b[c];
+        b[r] /= a[r][r];
+    }
+    return true;
+}
+
+bool CalibrationFit::fit(LoadCellCalibration &out, float &rms_grams) const
+{
+    if (points_ < 2) return false;
+
+    // distinct weights decide the order; x is scaled to about +-1 so the normal equations stay well conditioned
+    int distinct = 0;
+    double span = 0.0;
+    for (size_t i = 0; i < points_; i++) {
+        bool seen = false;
+        for (size_t j = 0; j < i; j++) seen = seen || fabsf(point_[j].grams - point_[i].grams) < 1.0f;
+        if (!seen) distinct++;
+        span = fmax(span, fabs(static_cast<double>(point_[i].raw - point_[0].raw)));
+    }
+    if (distinct < 2 || span == 0.0) return false;
+    int n = distinct >= 3 ? 3 : 2;
+
+    double a[3][3] = {};
+    double b[3] = {};
+    for (size_t i = 0; i < points_; i++) {
+        double u = (point_[i].raw - point_[0].raw) / span;
+        double powers[3] = {1.0, u, u * u};
+        for (int r = 0; r < n; r++) {
+            for (int c = 0; c < n; c++) a[r][c] += powers[r] * powers[c];
+            b[r] += powers[r] * point_[i].grams;
+        }
+    }
+    if (!solve(a, b, n)) return false;
+    double c0 = b[0];
+    double c1 = b[1] / span;
+    double c2 = n == 3 ? b[2] / (span * span) : 0.0;
+    if (c1 == 0.0) return false;
+
+    // zero crossing nearest the first point, then the coefficients around it
+    double d0 = -c0 / c1;
+    for (int i = 0; i < 4; i++) {
+        double slope = c1 + 2.0 * c2 * d0;
+        if (slope == 0.0) return false;
+        d0 -= (c0 + c1 * d0 + c2 * d0 * d0) / slope;
+    }
+    double zero = lround(d0);
+    double gain = c1 + 2.0 * c2 * zero;
+    double curve = c2;
+    // the slope must keep its sign over the range, with margin
+    for (int side = -1; side <= 1; side += 2) {
+        double d = side * 2.0 * span;
+        if ((gain + 2.0 * curve * d) * gain <= 0.0) return false;
+    }
+
+    out.offset = point_[0].raw + static_cast<int32_t>(zero);
+    out.gain = static_cast<float>(gain);
+    out.curve = static_cast<float>(curve);
+
+    double sq = 0.0;
+    for (size_t i = 0; i < points_; i++) {
+        double d = point_[i].raw - out.offset;
+        double e = gain * d + curve * d * d - point_[i].grams;
+        sq += e * e;
+    }
+    rms_grams = static_cast<float>(sqrt(sq / points_));
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "calibration_store.h"
+#include <string.h>
+
+static int32_t getI32(const uint8_t *p)
+{
+    return static_cast<int32_t>(p[0] | (p[1] << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+                                (static_cast<uint32_t>(p[3]) << 24));
+}
+
+bool CalibrationStore::readSlot(uint32_t address, LoadCellCalibration &out)
+{
+    uint8_t slot[HEADER_SIZE + PAYLOAD_SIZE + 2];
+    if (!flash_.read(address, slot, HEADER_SIZE)) return false;
+    size_t len = slot[3];
+    bool v1 = slot[2] == 1 && len == V1_PAYLOAD_SIZE;
+    if ((slot[0] | (slot[1] << 8)) != MAGIC || !(v1 || (slot[2] == VERSION && len == PAYLOAD_SIZE))) return false;
+    if (!flash_.read(address + HEADER_SIZE, slot + HEADER_SIZE, len + 2)) return false;
+    const uint8_t *tail = slot + HEADER_SIZE + len;
+    if (tail[1] != COMMIT || crc8(slot, HEADER_SIZE + len) != tail[0]) return false;
+
+    const uint8_t *p = slot + HEADER_SIZE;
+    out.offset = getI32(p);
+    if (v1) {
+        float scale;
+        memcpy(&scale, p + 4, sizeof(scale));
+        if (scale == 0.0f) return false;
+        out.gain = 1.0f / scale;
+        out.curve = 0.0f;
+        return true;
+    }
+    memcpy(&out.gain, p + 4, sizeof(out.gain));
+    memcpy(&out.curve, p + 8, sizeof(out.curve));
+    return out.gain != 0.0f;
+}
+
+bool CalibrationStore::load(LoadCellCalibration &out)
+{
+    if (!flash_.begin()) return false;
+    size_t size = flash_.blockSize();
+    bool found = false;
+    next_ = size;
+    // the last committed slot wins; torn or foreign slots are stepped over
+    for (uint32_t address = 0; address + SLOT_SIZE <= size; address += SLOT_SIZE) {
+        if (flash_.isBlank(address, SLOT_SIZE)) {
+            next_ = address;
+            break;
+        }
+        LoadCellCalibration slot;
+        if (readSlot(address, slot)) {
+            out = slot;
+            found = true;
+        }
+    }
+    scanned_ = true;
+    return found;
+}
+
+bool CalibrationStore::save(const LoadCellCalibration &calibration)
+{
+    if (!scanned_) {
+        LoadCellCalibration ignored;
+        load(ignored);
+    }
+    if (flash_.busy()) return false;
+    size_t size = flash_.blockSize();
+    while (next_ + SLOT_SIZE <= size && !flash_.isBlank(next_, SLOT_SIZE)) next_ += SLOT_SIZE;
+    if (next_ + SLOT_SIZE > size) {
+        if (!flash_.eraseBlock(0)) return false;
+        next_ = 0;
+    }
+
+    uint8_t slot[HEADER_SIZE + PAYLOAD_SIZE + 1];
+    slot[0] = MAGIC & 0xFF;
+    slot[1] = MAGIC >> 8;
+    slot[2] = VERSION;
+    slot[3] = PAYLOAD_SIZE;
+    uint32_t offset = static_cast<uint32_t>(calibration.offset);
+    for (int i = 0; i < 4; i++) slot[HEADER_SIZE + i] = (offset >> (8 * i)) & 0xFF;
+    memcpy(slot + HEADER_SIZE + 4, &calibration.gain, sizeof(calibration.gain));
+    memcpy(slot + HEADER_SIZE + 8, &calibration.curve, sizeof(calibration.curve));
+    slot[HEADER_SIZE + PAYLOAD_SIZE] = crc8(slot, HEADER_SIZE + PAYLOAD_SIZE);
+
+    uint32_t address = next_;
+    // the slot is used from here on, whether or not the writes below land
+    next_ += SLOT_SIZE;
+    const uint8_t commit = COMMIT;
+    return flash_.program(address, slot, sizeof(slot)) &&
+           flash_.program(address + sizeof(slot), &commit, 1);
+}
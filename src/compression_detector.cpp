@@ -0,0 +1,102 @@
+#include "compression_detector.h"
+
+CompressionDetector::CompressionDetector(uint8_t lowpass_shift) : lowpass_(lowpass_shift)
+{
+    reset();
+}
+
+void CompressionDetector::reset()
+{
+    lowpass_.reset();
+    baseline_.reset();
+    state_ = IDLE;
+    amplitude_ = INITIAL_AMPLITUDE;
+    press_threshold_ = INITIAL_AMPLITUDE * PRESS_FRACTION / 100;
+    peak_ = 0;
+    valley_ = 0;
+    pressed_before_ = false;
+    plateau_level_ = 0;
+    plateau_since_ = 0;
+    current_ = CompressionEvent{0, 0, 0, 0.0f};
+    event_ = current_;
+}
+
+void CompressionDetector::startPress(int32_t force, unsigned long now)
+{
+    state_ = PRESSING;
+    peak_ = force;
+    pressed_before_ = true;
+    current_ = CompressionEvent{now, now, 0, static_cast<float>(force)};
+}
+
+bool CompressionDetector::update(float grams, unsigned long now)
+{
+    int32_t filtered = lowpass_.update(static_cast<int32_t>(grams));
+
+    // an idle spell this long means a new trainee or a pause: forget the old amplitude
+    if (pressed_before_ && isIdle() && now - current_.press_time > AMPLITUDE_RESET_MS) {
+        amplitude_ = INITIAL_AMPLITUDE;
+    }
+    press_threshold_ = amplitude_ * PRESS_FRACTION / 100;
+    if (press_threshold_ < MIN_PRESS_GRAMS) press_threshold_ = MIN_PRESS_GRAMS;
+
+    bool settled = !pressed_before_ || now - event_.release_time >= BASELINE_SETTLE_MS;
+    int32_t force = filtered - baseline_.value();
+    baseline_.update(filtered, state_ == IDLE && settled && force < press_threshold_ / 2);
+    force = filtered - baseline_.value();
+
+    // a force that stopped moving while not idle is the new zero
+    if (filtered > plateau_level_ + PLATEAU_GRAMS || filtered < plateau_level_ - PLATEAU_GRAMS) {
+        plateau_level_ = filtered;
+        plateau_since_ = now;
+    } else if (now - plateau_since_ >= PLATEAU_MS && (state_ != IDLE || force >= press_threshold_ / 2)) {
+        baseline_.reset();
+        baseline_.update(filtered, true);
+        force = 0;
+        state_ = IDLE;
+    }
+
+    bool refractory = pressed_before_ && now - current_.press_time < REFRACTORY_MS;
+    bool completed = false;
+
+    switch (state_) {
+    case RECOILED:
+        // one-sample resting state so callers can observe the recoil, then re-arm
+        state_ = IDLE;
+        // fall through
+    case IDLE:
+        if (force >= press_threshold_ && !refractory) startPress(force, now);
+        break;
+
+    case PRESSING:
+    case PEAK:
+        if (force < peak_ * RELEASE_FRACTION / 100) {
+            current_.release_time = now;
+            event_ = current_;
+            state_ = RELEASING;
+            valley_ = force;
+            amplitude_ += (peak_ - amplitude_) / 4;
+            completed = true;
+        } else if (force > peak_) {
+            peak_ = force;
+            current_.peak_force = static_cast<float>(force);
+            current_.peak_time = now;
+            state_ = PRESSING;
+        } else {
+            state_ = PEAK;
+        }
+        break;
+
+    case RELEASING:
+        if (force < valley_) valley_ = force;
+        if (force < press_threshold_ / 2) {
+            state_ = RECOILED;
+        } else if (force >= valley_ + press_threshold_ && !refractory) {
+            // pushed again without recoiling: still a compression, just a poor one
+            startPress(force, now);
+        }
+        break;
+    }
+
+    return completed;
+}
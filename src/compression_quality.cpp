@@ -0,0 +1,146 @@
+#include "compression_quality.h"
+
+static uint16_t clampMs(unsigned long ms) { return ms > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(ms); }
+
+// x16 running average, 1/8 weight for the new value
+static void blend(int &avg_x16, int pct) { avg_x16 += (pct * 16 - avg_x16) / 8; }
+
+void QualityAnalyzer::reset()
+{
+    prev_state_ = CompressionDetector::IDLE;
+    zero_ = 0;
+    zero_time_ = 0;
+    in_cycle_ = false;
+    released_ = false;
+    unloaded_ = false;
+    unloaded_level_ = UNLOADED_MIN_GRAMS;
+    last_low_ = 0;
+    last_flat_ = 0;
+    previous_press_ = 0;
+    valley_ = 0;
+    valley_time_ = 0;
+    peak_time_ = 0;
+    unloaded_time_ = 0;
+    current_ = CompressionQuality{};
+    last_ = current_;
+    count_ = 0;
+    duty_seeded_ = false;
+    duty_x16_ = 0;
+    // start optimistic so the hint needs evidence
+    depth_ok_x16_ = 100 * 16;
+    recoil_ok_x16_ = 100 * 16;
+}
+
+void QualityAnalyzer::start(float force, unsigned long now, const CompressionDetector &detector)
+{
+    // a low sample from before the previous valley belongs to an older cycle
+    bool low_recent = last_low_ && (!in_cycle_ || unloaded_) && now - last_low_ < 1000;
+    unsigned long onset = low_recent ? last_low_ : (last_flat_ ? last_flat_ : now);
+    if (in_cycle_) finish(onset, false);
+
+    current_ = CompressionQuality{};
+    current_.onset_time = onset;
+    current_.press_time = now;
+    current_.peak_grams = force;
+    current_.interval_ms = previous_press_ ? clampMs(now - previous_press_) : 0;
+    previous_press_ = now;
+    peak_time_ = now;
+    in_cycle_ = true;
+    released_ = false;
+    unloaded_ = false;
+    valley_ = force;
+    valley_time_ = now;
+
+    int32_t level = detector.amplitude() / 10;
+    unloaded_level_ = level > UNLOADED_MIN_GRAMS ? level : UNLOADED_MIN_GRAMS;
+}
+
+void QualityAnalyzer::finish(unsigned long next_onset, bool final)
+{
+    CompressionQuality &q = current_;
+    unsigned long press_end = unloaded_ ? unloaded_time_ : valley_time_;
+    q.time_to_peak_ms = clampMs(peak_time_ - q.onset_time);
+    q.press_ms = clampMs(press_end - q.onset_time);
+    q.residual_grams = valley_;
+    if (final) {
+        q.flags |= CompressionQuality::FINAL;
+    } else {
+        q.release_ms = clampMs(next_onset > press_end ? next_onset - press_end : 0);
+        unsigned long cycle = next_onset - q.onset_time;
+        q.duty_pct = cycle > 0 ? static_cast<uint8_t>(q.press_ms * 100UL / cycle) : 0;
+        if (q.duty_pct > 100) q.duty_pct = 100;
+        if (!duty_seeded_) duty_x16_ = q.duty_pct * 16;
+        duty_seeded_ = true;
+        blend(duty_x16_, q.duty_pct);
+    }
+
+    if (q.peak_grams < DEPTH_MIN_GRAMS) q.flags |= CompressionQuality::DEPTH_LOW;
+    if (q.peak_grams > DEPTH_MAX_GRAMS) q.flags |= CompressionQuality::DEPTH_HIGH;
+    if (q.residual_grams > RECOIL_MAX_GRAMS) q.flags |= CompressionQuality::INCOMPLETE_RECOIL;
+    blend(depth_ok_x16_, q.flags & (CompressionQuality::DEPTH_LOW | CompressionQuality::DEPTH_HIGH) ? 0 : 100);
+    blend(recoil_ok_x16_, q.flags & CompressionQuality::INCOMPLETE_RECOIL ? 0 : 100);
+
+    last_ = q;
+    count_++;
+    in_cycle_ = false;
+}
+
+bool QualityAnalyzer::update(float filtered, float slope, unsigned long now, const CompressionDetector &detector)
+{
+    // the detector's zero, but only as fast as drift while compressions go on
+    float baseline = detector.baseline();
+    if (!in_cycle_ || baseline < zero_) {
+        zero_ = baseline;
+    } else {
+        float most = zero_ + ZERO_DRIFT_MAX_G_PER_MIN * (now - zero_time_) / 60000.0f;
+        zero_ = baseline < most ? baseline : most;
+    }
+    zero_time_ = now;
+    float force = filtered - zero_;
+    uint8_t state = detector.state();
+    bool pressing = state == CompressionDetector::PRESSING || state == CompressionDetector::PEAK;
+    bool was_pressing = prev_state_ == CompressionDetector::PRESSING || prev_state_ == CompressionDetector::PEAK;
+    prev_state_ = state;
+
+    unsigned long before = count_;
+    if (pressing && !was_pressing) start(force, now, detector);
+    // straight back to IDLE: the detector took a held force as its new zero
+    if (was_pressing && state == CompressionDetector::IDLE && in_cycle_) {
+        in_cycle_ = false;
+        previous_press_ = 0;
+    }
+
+    if (in_cycle_) {
+        if (pressing && force > current_.peak_grams) {
+            current_.peak_grams = force;
+            peak_time_ = now;
+        }
+        if (!pressing) released_ = true;
+        if (released_) {
+            if (force < valley_) {
+                valley_ = force;
+                valley_time_ = now;
+            }
+            if (!unloaded_ && force <= unloaded_level_) {
+                unloaded_ = true;
+                unloaded_time_ = now;
+            }
+            if (detector.isIdle() && now - peak_time_ > FINAL_TIMEOUT_MS) finish(now, true);
+        }
+    }
+    if (slope <= 0) last_flat_ = now;
+    int32_t level = detector.amplitude() / 10;
+    if (force <= (level > UNLOADED_MIN_GRAMS ? level : UNLOADED_MIN_GRAMS)) last_low_ = now;
+
+    return count_ != before;
+}
+
+QualityHint QualityAnalyzer::hint() const
+{
+    // leaning is the hardest habit to see from the outside, so it goes first
+    if (recoilOkPct() < HINT_BELOW_PCT) return HINT_FULL_RECOIL;
+    if (depthOkPct() < HINT_BELOW_PCT) {
+        return last_.flags & CompressionQuality::DEPTH_HIGH ? HINT_PUSH_SOFTER : HINT_PUSH_HARDER;
+    }
+    return HINT_NONE;
+}
@@ -0,0 +1,111 @@
+#include "debug_log.h"
+#include "waveform_codec.h"
+#include <string.h>
+
+namespace {
+
+uint8_t ring[LOG_RING_SIZE];
+size_t head = 0;      // next byte to send
+size_t used = 0;
+unsigned long last_ms = 0;
+unsigned long dropped = 0;
+unsigned long unreported = 0;
+
+bool push(const uint8_t *data, size_t len)
+{
+    if (len > LOG_RING_SIZE - used) return false;
+    size_t tail = (head + used) % LOG_RING_SIZE;
+    size_t first = LOG_RING_SIZE - tail < len ? LOG_RING_SIZE - tail : len;
+    memcpy(ring + tail, data, first);
+    memcpy(ring, data + first, len - first);
+    used += len;
+    return true;
+}
+
+}
+
+LogRecord::LogRecord(uint16_t id) : len_(ARGS_AT), id_(id), ms_(millis()) {}
+
+void LogRecord::add(int32_t v)
+{
+    if (len_ + WAVEFORM_MAX_VARINT <= sizeof(buf_)) len_ += varintEncode(zigzagEncode(v), buf_ + len_);
+}
+
+void LogRecord::add(uint32_t v)
+{
+    if (len_ + WAVEFORM_MAX_VARINT <= sizeof(buf_)) len_ += varintEncode(v, buf_ + len_);
+}
+
+void LogRecord::add(float v)
+{
+    if (len_ + sizeof(v) > sizeof(buf_)) return;
+    memcpy(buf_ + len_, &v, sizeof(v));   // little-endian on both targets
+    len_ += sizeof(v);
+}
+
+void LogRecord::add(const char *s)
+{
+    size_t n = s ? strlen(s) : 0;
+    if (n > LOG_MAX_STRING) n = LOG_MAX_STRING;
+    if (len_ + 1 + n > sizeof(buf_)) return;
+    buf_[len_++] = n;
+    memcpy(buf_ + len_, s, n);
+    len_ += n;
+}
+
+// dt counts from the last record that made it into the ring, so a dropped
+// one doesn't take its time with it
+bool LogRecord::send()
+{
+    uint8_t dt[WAVEFORM_MAX_VARINT];
+    size_t n = varintEncode(ms_ - last_ms, dt);
+    size_t start = ARGS_AT - 4 - n;
+    buf_[start] = LOG_MARKER;
+    buf_[start + 1] = len_ - start - 2;
+    buf_[start + 2] = id_ & 0xFF;
+    buf_[start + 3] = id_ >> 8;
+    memcpy(buf_ + start + 4, dt, n);
+    if (!push(buf_ + start, len_ - start)) return false;
+    last_ms = ms_;
+    return true;
+}
+
+void LogRecord::commit()
+{
+    static_assert(ARGS_AT == 4 + WAVEFORM_MAX_VARINT, "room for the header and any dt");
+    if (unreported > 0) {
+        // say how much is missing before the next record that fits
+        LogRecord gap(logId(LOG_LEVEL_WARN, "log: %lu records dropped"));
+        gap.ms_ = ms_;
+        gap.add(static_cast<uint32_t>(unreported));
+        if (!gap.send()) {
+            dropped++;
+            unreported++;
+            return;
+        }
+        unreported = 0;
+    }
+    if (!send()) {
+        dropped++;
+        unreported++;
+    }
+}
+
+void logDrain(Print &out)
+{
+    int room = out.availableForWrite();
+    if (room <= 0) room = LOG_BLIND_DRAIN;
+    while (room > 0 && used > 0) {
+        size_t n = LOG_RING_SIZE - head < used ? LOG_RING_SIZE - head : used;
+        if (n > static_cast<size_t>(room)) n = room;
+        n = out.write(ring + head, n);
+        if (n == 0) break;
+        head = (head + n) % LOG_RING_SIZE;
+        used -= n;
+        room -= n;
+    }
+}
+
+size_t logPending() { return used; }
+
+unsigned long logDropped() { return dropped; }
@@ -0,0 +1,117 @@
+#include "dsp_kernels.h"
+#include <string.h>
+#if defined(__ARM_FEATURE_DSP)
+#include <Arduino.h>
+#endif
+
+namespace {
+
+#if defined(__ARM_FEATURE_DSP)
+inline uint64_t smlald(uint32_t x, uint32_t y, uint64_t acc) { return __SMLALD(x, y, acc); }
+inline uint32_t shsub16(uint32_t x, uint32_t y) { return __SHSUB16(x, y); }
+#else
+// what the M4 instructions compute, halfword by halfword
+inline uint64_t smlald(uint32_t x, uint32_t y, uint64_t acc)
+{
+    int64_t lo = static_cast<int32_t>(static_cast<int16_t>(x)) * static_cast<int16_t>(y);
+    int64_t hi = static_cast<int32_t>(static_cast<int16_t>(x >> 16)) * static_cast<int16_t>(y >> 16);
+    return acc + static_cast<uint64_t>(lo + hi);
+}
+
+inline uint32_t shsub16(uint32_t x, uint32_t y)
+{
+    uint16_t lo = static_cast<uint16_t>((static_cast<int16_t>(x) - static_cast<int16_t>(y)) >> 1);
+    uint16_t hi = static_cast<uint16_t>((static_cast<int16_t>(x >> 16) - static_cast<int16_t>(y >> 16)) >> 1);
+    return lo | static_cast<uint32_t>(hi) << 16;
+}
+#endif
+
+inline int16_t roundQ15(int64_t acc)
+{
+    acc = (acc + (1 << 14)) >> 15;
+    if (acc > 32767) return 32767;
+    if (acc < -32768) return -32768;
+    return static_cast<int16_t>(acc);
+}
+
+}
+
+void firQ15Scalar(const int16_t *reversed, int taps, const int16_t *x, int16_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int64_t acc = 0;
+        for (int k = 0; k < taps; k++) acc += static_cast<int32_t>(reversed[k]) * x[i + k];
+        out[i] = roundQ15(acc);
+    }
+}
+
+void slopeQ15Scalar(const int16_t *prev, const int16_t *y, int16_t *d, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t older = i >= 2 ? y[i - 2] : prev[i];
+        d[i] = static_cast<int16_t>((y[i] - older) >> 1);
+    }
+}
+
+static inline uint32_t loadPair(const int16_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));   // unaligned word load on the M4
+    return v;
+}
+
+static inline void storePair(int16_t *p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+
+void firQ15Simd(const int16_t *reversed, int taps, const int16_t *x, int16_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        const int16_t *xi = x + i;
+        uint64_t acc = 0;
+        for (int k = 0; k < taps; k += 2) {
+            acc = smlald(loadPair(reversed + k), loadPair(xi + k), acc);
+        }
+        out[i] = roundQ15(static_cast<int64_t>(acc));
+    }
+}
+
+void slopeQ15Simd(const int16_t *prev, const int16_t *y, int16_t *d, size_t n)
+{
+    size_t i = 0;
+    // first two outputs reach back into the previous block
+    for (; i < n && i < 2; i++) d[i] = static_cast<int16_t>((y[i] - prev[i]) >> 1);
+    for (; i + 1 < n; i += 2) storePair(d + i, shsub16(loadPair(y + i), loadPair(y + i - 2)));
+    for (; i < n; i++) d[i] = static_cast<int16_t>((y[i] - y[i - 2]) >> 1);
+}
+
+// sums to 32768 for unity DC gain
+const int16_t LoadCellBlockFilter::LOWPASS[TAPS] = {116, 1248, 5277, 9743, 9743, 5277, 1248, 116};
+
+void LoadCellBlockFilter::reset()
+{
+    memset(window_, 0, sizeof(window_));
+    memset(prev_, 0, sizeof(prev_));
+}
+
+void LoadCellBlockFilter::process(const int16_t *in, int16_t *out, int16_t *slope, size_t n)
+{
+    if (n > BLOCK) n = BLOCK;
+    memcpy(window_ + TAPS - 1, in, n * sizeof(int16_t));
+
+#if defined(__ARM_FEATURE_DSP)
+    firQ15Simd(LOWPASS, TAPS, window_, out, n);
+    if (slope) slopeQ15Simd(prev_, out, slope, n);
+#else
+    firQ15Scalar(LOWPASS, TAPS, window_, out, n);
+    if (slope) slopeQ15Scalar(prev_, out, slope, n);
+#endif
+
+    // carry the newest inputs and outputs into the next call
+    memmove(window_, window_ + n, (TAPS - 1) * sizeof(int16_t));
+    if (n >= 2) {
+        prev_[0] = out[n - 2];
+        prev_[1] = out[n - 1];
+    } else if (n == 1) {
+        prev_[0] = prev_[1];
+        prev_[1] = out[0];
+    }
+}
@@ -0,0 +1,126 @@
+#include "feedback_display.h"
+#include "bpm_helper.h"
+#include "loop.h"
+
+PaceState classifyPace(float bpm, PaceState previous, float hysteresis)
+{
+    float low = MIN_BPM;
+    float high = MAX_BPM;
+    switch (previous) {
+    case PACE_GOOD:
+        low -= hysteresis;
+        high += hysteresis;
+        break;
+    case PACE_TOO_FAST:
+        high -= hysteresis;
+        break;
+    case PACE_TOO_SLOW:
+        low += hysteresis;
+        break;
+    case PACE_NONE:
+        break;
+    }
+    if (bpm > high) return PACE_TOO_FAST;
+    if (bpm < low) return PACE_TOO_SLOW;
+    return PACE_GOOD;
+}
+
+FeedbackDisplay::FeedbackDisplay(Adafruit_SSD1306 &display, TwoWire &wire, uint8_t i2c_address)
+    : display_(display), wire_(wire), address_(i2c_address), line1_(nullptr), line2_(nullptr),
+      shadow_valid_(false), stats_{0, 0, 0, 0}
+{
+}
+
+bool FeedbackDisplay::showStacked(const char *line1, const char *line2)
+{
+    if (line1_ && line2_ && strcmp(line1, line1_) == 0 && strcmp(line2, line2_) == 0) return false;
+    line1_ = line1;
+    line2_ = line2;
+
+    clearOled(display_);
+    setStackedText(display_, line1, line2, 2, SSD1306_WHITE);
+    flush();
+    stats_.redraws++;
+    return true;
+}
+
+bool FeedbackDisplay::showPace(PaceState state)
+{
+    switch (state) {
+    case PACE_GOOD: return showStacked("GOOD", "PACE");
+    case PACE_TOO_FAST: return showStacked("TOO", "FAST");
+    case PACE_TOO_SLOW: return showStacked("TOO", "SLOW");
+    case PACE_NONE: break;
+    }
+    return false;
+}
+
+bool FeedbackDisplay::showHint(QualityHint hint)
+{
+    switch (hint) {
+    case HINT_PUSH_HARDER: return showStacked("PUSH", "HARDER");
+    case HINT_PUSH_SOFTER: return showStacked("PUSH", "SOFTER");
+    case HINT_FULL_RECOIL: return showStacked("FULL", "RECOIL");
+    case HINT_NONE: break;
+    }
+    return false;
+}
+
+void FeedbackDisplay::invalidate()
+{
+    shadow_valid_ = false;
+    line1_ = nullptr;
+    line2_ = nullptr;
+}
+
+void FeedbackDisplay::command(const uint8_t *cmds, size_t len)
+{
+    wire_.beginTransmission(address_);
+    wire_.write(static_cast<uint8_t>(0x00));  // Co = 0, D/C = 0: command stream
+    wire_.write(cmds, len);
+    wire_.endTransmission();
+    stats_.bytes += len + 2;
+}
+
+void FeedbackDisplay::flush()
+{
+    // 32-byte Wire buffer minus the 0x40 data control byte
+    constexpr int CHUNK = 31;
+    const uint8_t *buffer = display_.getBuffer();
+    if (!buffer) return;
+
+    unsigned long start = micros();
+    wire_.setClock(400000);
+
+    for (int page = 0; page < PAGES; page++) {
+        const uint8_t *src = buffer + page * WIDTH;
+        uint8_t *dst = shadow_ + page * WIDTH;
+
+        int first = 0;
+        int last = WIDTH - 1;
+        if (shadow_valid_) {
+            while (first < WIDTH && src[first] == dst[first]) first++;
+            if (first == WIDTH) continue;
+            while (src[last] == dst[last]) last--;
+        }
+
+        // horizontal addressing: the window wraps inside this one page
+        const uint8_t window[] = {0x21, static_cast<uint8_t>(first), static_cast<uint8_t>(last),
+                                  0x22, static_cast<uint8_t>(page), static_cast<uint8_t>(page)};
+        command(window, sizeof(window));
+
+        for (int col = first; col <= last; col += CHUNK) {
+            int len = min(CHUNK, last - col + 1);
+            wire_.beginTransmission(address_);
+            wire_.write(static_cast<uint8_t>(0x40));
+            wire_.write(src + col, len);
+            wire_.endTransmission();
+            stats_.bytes += len + 2;
+        }
+        memcpy(dst + first, src + first, last - first + 1);
+        stats_.pages++;
+    }
+
+    shadow_valid_ = true;
+    stats_.i2c_us += micros() - start;
+}
@@ -0,0 +1,130 @@
+#include "flash_store.h"
+#include <string.h>
+
+RamFlashStore::RamFlashStore(uint8_t *memory, size_t size, size_t block_size)
+    : memory_(memory), size_(size), block_size_(block_size)
+{
+    memset(memory_, ERASED, size_);
+}
+
+bool RamFlashStore::read(uint32_t address, uint8_t *out, size_t len)
+{
+    if (address + len > size_) return false;
+    memcpy(out, memory_ + address, len);
+    return true;
+}
+
+bool RamFlashStore::program(uint32_t address, const uint8_t *data, size_t len)
+{
+    if (address + len > size_) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (memory_[address + i] != ERASED) return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (cut_after_ == 0) return false;
+        if (cut_after_ > 0) cut_after_--;
+        memory_[address + i] = data[i];
+    }
+    return true;
+}
+
+bool RamFlashStore::eraseBlock(uint32_t address)
+{
+    if (address % block_size_ != 0 || address >= size_) return false;
+    if (cut_after_ == 0) return false;
+    memset(memory_ + address, ERASED, block_size_);
+    return true;
+}
+
+bool RamFlashStore::isBlank(uint32_t address, size_t len)
+{
+    if (address + len > size_) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (memory_[address + i] != ERASED) return false;
+    }
+    return true;
+}
+
+bool FlashRegion::read(uint32_t address, uint8_t *out, size_t len)
+{
+    if (address + len > size_) return false;
+    return base_.read(start_ + address, out, len);
+}
+
+bool FlashRegion::program(uint32_t address, const uint8_t *data, size_t len)
+{
+    if (address + len > size_) return false;
+    return base_.program(start_ + address, data, len);
+}
+
+bool FlashRegion::eraseBlock(uint32_t address)
+{
+    if (address >= size_) return false;
+    return base_.eraseBlock(start_ + address);
+}
+
+bool FlashRegion::isBlank(uint32_t address, size_t len)
+{
+    if (address + len > size_) return false;
+    return base_.isBlank(start_ + address, len);
+}
+
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+#if defined(ARDUINO_ARCH_RENESAS)
+
+#include <Arduino.h>
+#include "r_flash_lp.h"
+
+static flash_lp_instance_ctrl_t flash_ctrl;
+static flash_cfg_t flash_cfg;
+
+bool DataFlashStore::begin()
+{
+    if (open_) return true;
+    flash_cfg.data_flash_bgo = false;
+    flash_cfg.p_callback = nullptr;
+    flash_cfg.p_context = nullptr;
+    flash_cfg.p_extend = nullptr;
+    flash_cfg.ipl = BSP_IRQ_DISABLED;
+    flash_cfg.irq = FSP_INVALID_VECTOR;
+    open_ = R_FLASH_LP_Open(&flash_ctrl, &flash_cfg) == FSP_SUCCESS;
+    return open_;
+}
+
+bool DataFlashStore::read(uint32_t address, uint8_t *out, size_t len)
+{
+    if (address + len > SIZE) return false;
+    memcpy(out, reinterpret_cast<const void *>(START + address), len);
+    return true;
+}
+
+bool DataFlashStore::program(uint32_t address, const uint8_t *data, size_t len)
+{
+    if (!open_ || address + len > SIZE) return false;
+    // data-flash P/E does not stall code-flash fetches, so interrupts (the DRDY ISR) keep running
+    return R_FLASH_LP_Write(&flash_ctrl, reinterpret_cast<uint32_t>(data), START + address, len) == FSP_SUCCESS;
+}
+
+bool DataFlashStore::eraseBlock(uint32_t address)
+{
+    if (!open_ || address % BLOCK != 0 || address >= SIZE) return false;
+    return R_FLASH_LP_Erase(&flash_ctrl, START + address, 1) == FSP_SUCCESS;
+}
+
+bool DataFlashStore::isBlank(uint32_t address, size_t len)
+{
+    if (!open_ || address + len > SIZE) return false;
+    flash_result_t result;
+    if (R_FLASH_LP_BlankCheck(&flash_ctrl, START + address, len, &result) != FSP_SUCCESS) return false;
+    return result == FLASH_RESULT_BLANK;
+}
+
+#endif
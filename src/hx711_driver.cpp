@@ -0,0 +1,195 @@
+#include "hx711_driver.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include <math.h>
+
+// PD_SCK high for more than 60 us powers the chip down, so every pulse here is
+// short and the SPI clock is fast enough that a whole frame takes a few us
+constexpr uint32_t SPI_CLOCK_HZ = 4000000;
+constexpr uint8_t SPI_FOUR_PULSES = 0xAA;
+
+#if defined(ARDUINO_ARCH_RENESAS)
+
+// a few cycles keep each PD_SCK phase above the HX711's 0.2 us minimum at 48 MHz
+static inline void sckPhaseDelay()
+{
+    __NOP(); __NOP(); __NOP(); __NOP(); __NOP();
+    __NOP(); __NOP(); __NOP(); __NOP(); __NOP();
+}
+
+static R_PORT0_Type *portOf(int pin)
+{
+    bsp_io_port_pin_t port_pin = g_pin_cfg[pin].pin;
+    uintptr_t stride = reinterpret_cast<uintptr_t>(R_PORT1) - reinterpret_cast<uintptr_t>(R_PORT0);
+    return reinterpret_cast<R_PORT0_Type *>(reinterpret_cast<uintptr_t>(R_PORT0) + (port_pin >> 8) * stride);
+}
+
+static uint16_t maskOf(int pin) { return 1u << (g_pin_cfg[pin].pin & 0xFF); }
+
+#endif
+
+bool Hx711Driver::begin(int dout, int sck, Gain gain, Backend backend, int rate_pin)
+{
+    dout_ = dout;
+    sck_ = sck;
+    gain_ = gain;
+    backend_ = backend;
+    rate_pin_ = rate_pin;
+
+    pinMode(dout_, INPUT);
+    if (rate_pin_ >= 0) pinMode(rate_pin_, OUTPUT);
+    setFastRate(true);
+
+    if (backend_ == SPI_MOSI) {
+        // dout/sck must be the board's MISO/MOSI; SCK itself is left unconnected
+        SPI.begin();
+#if defined(ARDUINO_ARCH_RENESAS)
+        // hold MOSI (= PD_SCK) low between transfers instead of repeating the last bit
+        R_SPI0->SPPCR_b.MOIFV = 0;
+        R_SPI0->SPPCR_b.MOIFE = 1;
+#endif
+    } else {
+        pinMode(sck_, OUTPUT);
+        digitalWrite(sck_, LOW);
+#if defined(ARDUINO_ARCH_RENESAS)
+        R_PORT0_Type *sck_port = portOf(sck_);
+        sck_set_ = &sck_port->POSR;
+        sck_clear_ = &sck_port->PORR;
+        sck_mask_ = maskOf(sck_);
+        dout_in_ = &portOf(dout_)->PIDR;
+        dout_mask_ = maskOf(dout_);
+#endif
+    }
+    return true;
+}
+
+void Hx711Driver::setFastRate(bool fast)
+{
+    if (rate_pin_ >= 0) digitalWrite(rate_pin_, fast ? HIGH : LOW);
+}
+
+bool Hx711Driver::isReady() const
+{
+#if defined(ARDUINO_ARCH_RENESAS)
+    if (dout_in_) return !(*dout_in_ & dout_mask_);
+#endif
+    return digitalRead(dout_) == LOW;
+}
+
+bool Hx711Driver::tryRead(Hx711Reading &reading)
+{
+    if (!isReady()) return false;
+    reading.timestamp = micros();
+
+    uint32_t value = backend_ == SPI_MOSI ? shiftInSpi() : shiftInBitBang();
+    // sign-extend the 24-bit two's complement result
+    if (value & 0x800000UL) value |= 0xFF000000UL;
+    reading.raw = static_cast<int32_t>(value);
+    return true;
+}
+
+uint32_t Hx711Driver::shiftInBitBang()
+{
+    uint32_t value = 0;
+    int pulses = 24 + gain_;
+#if defined(ARDUINO_ARCH_RENESAS)
+    // the whole frame takes ~15 us; keep it in one piece so PD_SCK never stays high.
+    // Callers may already be masked (loadCellIsrBegin()), so put back what was there
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (int i = 0; i < pulses; i++) {
+        *sck_set_ = sck_mask_;
+        sckPhaseDelay();
+        value = (value << 1) | ((*dout_in_ & dout_mask_) ? 1 : 0);
+        *sck_clear_ = sck_mask_;
+        sckPhaseDelay();
+    }
+    __set_PRIMASK(primask);
+#else
+    for (int i = 0; i < pulses; i++) {
+        digitalWrite(sck_, HIGH);
+        value = (value << 1) | (digitalRead(dout_) == HIGH ? 1 : 0);
+        digitalWrite(sck_, LOW);
+    }
+#endif
+    // the gain pulses shifted in DOUT's idle-high bits after the data
+    return (value >> gain_) & 0xFFFFFFUL;
+}
+
+uint32_t Hx711Driver::shiftInSpi()
+{
+    // six bytes of four pulses carry the 24 data bits, the last byte only the gain pulses
+    static const uint8_t GAIN_PULSES[4] = {0x00, 0x80, 0xA0, 0xA8};
+    uint8_t frame[7];
+    for (int i = 0; i < 6; i++) frame[i] = SPI_FOUR_PULSES;
+    frame[6] = GAIN_PULSES[gain_];
+
+    SPI.beginTransaction(SPISettings(SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
+    SPI.transfer(frame, sizeof(frame));
+    SPI.endTransaction();
+
+    // DOUT sampled while MOSI is '0' (PD_SCK low) sits in bits 6, 4, 2, 0
+    uint32_t value = 0;
+    for (int i = 0; i < 6; i++) {
+        uint8_t r = frame[i];
+        value = (value << 4) | ((r >> 3) & 0x8) | ((r >> 2) & 0x4) | ((r >> 1) & 0x2) | (r & 0x1);
+    }
+    return value;
+}
+
+void Hx711Driver::powerDown()
+{
+    if (backend_ == SPI_MOSI) SPI.end();
+    pinMode(sck_, OUTPUT);
+    digitalWrite(sck_, LOW);
+    digitalWrite(sck_, HIGH);
+}
+
+void Hx711Driver::powerUp()
+{
+    digitalWrite(sck_, LOW);
+    if (backend_ == SPI_MOSI) begin(dout_, sck_, gain_, backend_, rate_pin_);
+}
+
+bool Hx711Driver::tare(int times, unsigned long timeout_ms)
+{
+    int64_t sum = 0;
+    int got = 0;
+    unsigned long start = millis();
+    Hx711Reading reading;
+    while (got < times) {
+        if (millis() - start > timeout_ms) return false;
+        if (tryRead(reading)) {
+            sum += reading.raw;
+            got++;
+        } else {
+            yield();
+        }
+    }
+    offset_ = static_cast<int32_t>(sum / times);
+    return true;
+}
+
+bool Hx711Driver::setCalibration(float grams_per_count, float curve)
+{
+    double gain_q = ldexp(static_cast<double>(grams_per_count), GAIN_FRAC_BITS);
+    double curve_q = ldexp(static_cast<double>(curve), CURVE_FRAC_BITS);
+    if (grams_per_count == 0.0f || fabs(gain_q) > 2147483647.0 || fabs(curve_q) > 2147483647.0) return false;
+    grams_per_count_ = grams_per_count;
+    curve_ = curve;
+    gain_q_ = static_cast<int32_t>(lround(gain_q));
+    curve_q_ = static_cast<int32_t>(lround(curve_q));
+    return true;
+}
+
+int32_t Hx711Driver::toGramsFixed(int32_t raw) const
+{
+    // a 24-bit reading minus a 24-bit offset still fits 32 bits
+    int32_t d = raw - offset_;
+    int64_t grams = (static_cast<int64_t>(d) * gain_q_) >> (GAIN_FRAC_BITS - GRAMS_FRAC_BITS);
+    if (curve_q_ != 0) {
+        int64_t d2 = (static_cast<int64_t>(d) * d) >> 16;
+        grams += (d2 * curve_q_) >> (CURVE_FRAC_BITS - 16 - GRAMS_FRAC_BITS);
+    }
+    return static_cast<int32_t>(grams);
+}
@@ -0,0 +1,61 @@
+#include "load_cell_isr.h"
+#include "irq_pins.h"
+#include "sample_ring.h"
+#include <Arduino.h>
+
+namespace {
+
+// 16 samples = 200 ms of headroom at 80 SPS
+SpscRing<LoadCellSample, 16> samples;
+Hx711Driver *load_cell = nullptr;
+bool enabled = false;
+bool polled = false;    // DOUT has no interrupt: loadCellPoll() reads instead
+
+void loadCellDataReady()
+{
+    // clocking the bits out toggles DOUT and re-pends this interrupt; DOUT only
+    // stays low while a fresh conversion is waiting, so tryRead() ignores those
+    Hx711Reading reading;
+    if (!load_cell->tryRead(reading)) return;
+
+    samples.push(LoadCellSample{millis(), reading.raw, reading.timestamp});
+}
+
+}
+
+bool loadCellIsrBegin(Hx711Driver &driver)
+{
+    load_cell = &driver;
+    enabled = true;
+    polled = !pinHasIrq(load_cell->doutPin());
+    if (polled) return false;
+    attachInterrupt(digitalPinToInterrupt(load_cell->doutPin()), loadCellDataReady, FALLING);
+
+    // a conversion that was already waiting will never produce an edge
+    noInterrupts();
+    loadCellDataReady();
+    interrupts();
+    return true;
+}
+
+void loadCellIsrEnd()
+{
+    if (load_cell && !polled) detachInterrupt(digitalPinToInterrupt(load_cell->doutPin()));
+    enabled = false;
+}
+
+void loadCellPoll()
+{
+    // producer and consumer are both loop() context here
+    if (enabled && polled) loadCellDataReady();
+}
+
+bool loadCellPop(LoadCellSample &sample)
+{
+    return samples.pop(sample);
+}
+
+uint32_t loadCellOverruns()
+{
+    return samples.overruns();
+}
@@ -4,6 +4,31 @@
 #include <Wire.h>
 #include "setup.h"
 #include "loop.h"
+#include "compression_detector.h"
+#include "compression_quality.h"
+#include "debug_log.h"
+#include "dsp_kernels.h"
+#include "load_cell_isr.h"
+#include "feedback_display.h"
+#include "background_tare.h"
+#include "bulk_transfer.h"
+#include "calibration_fit.h"
+#include "calibration_store.h"
+#include "scheduler.h"
+#include "session_log.h"
+#include "melody_player.h"
+#include "mode_button.h"
+#include "notify_queue.h"
+#include "power_monitor.h"
+#include "telemetry.h"
+#include "test_accumulator.h"
+#include "waveform_codec.h"
+#ifdef PULSECOACH_BENCH
+#include "bench.h"
+#endif
+#if !defined(ARDUINO_ARCH_RENESAS)
+#include "native_sim.h"
+#endif
 
 #include "../include/song_setup.h"
 #include "../include/bpm_helper.h"
@@ -12,41 +37,206 @@
 BLEService customService("19B10000-E8F2-537E-4F6C-D104768A1214");
 BLEIntCharacteristic testCharacteristic("19B10001-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify);
 BLEIntCharacteristic numberCharacteristic("19B10002-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify);
-BLEIntCharacteristic resultCharacteristic("19B10003-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify);
+// test summary record, see test_accumulator.h
+BLECharacteristic resultCharacteristic("19B10003-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify, TEST_RESULT_SIZE);
+// batched compression records; the app writes its negotiated MTU (u16) here
+BLECharacteristic telemetryCharacteristic("19B10004-E8F2-537E-4F6C-D104768A1214",
+                                          BLERead | BLENotify | BLEWrite | BLEWriteWithoutResponse,
+                                          TelemetryBatcher::MAX_PACKET);
+// raw force stream, sent only while the app is subscribed
+BLECharacteristic waveformCharacteristic("19B10005-E8F2-537E-4F6C-D104768A1214", BLERead | BLENotify,
+                                         WaveformEncoder::MAX_FRAME);
+// session log download: the app writes commands, chunks come back as notifications
+BLECharacteristic transferCharacteristic("19B10006-E8F2-537E-4F6C-D104768A1214",
+                                         BLERead | BLENotify | BLEWrite | BLEWriteWithoutResponse,
+                                         BulkSender::MAX_PACKET);
 
 using namespace std;
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 
-#define  LC_DATA_PIN   7
-#define  LC_CLK_PIN    3
-#define  BTN_1_PIN     2
+#ifdef PULSECOACH_HX711_SPI
+// PD_SCK on MOSI and DOUT on MISO; the speaker moves off D11
+#define  LC_DATA_PIN   12
+#define  LC_CLK_PIN    11
+#define  LC_BACKEND    Hx711Driver::SPI_MOSI
+#define  SPEAKER_PIN   9
+#else
+// DOUT needs an interrupt pin (D2/D3); PD_SCK can go anywhere
+#define  LC_DATA_PIN   2
+#define  LC_CLK_PIN    7
+#define  LC_BACKEND    Hx711Driver::BITBANG
+#define  SPEAKER_PIN   11
+#endif
+#define  LC_RATE_PIN   -1    // RATE strapped high on the board (80 SPS)
 
 #define OLED_RESET     -1
 #define I2C_ADDRESS    0x3C  // Most SSD1306 I2C displays use 0x3C
 
 // Constants
-constexpr int MODE_BUTTON_PIN = 4;
-constexpr int TEST_DURATION = 15000;
-constexpr float CALIB_FACTOR = 117.58f;
+constexpr int MODE_BUTTON_PIN = 3;   // needs an interrupt pin, see irq_pins.h
+#ifndef PULSECOACH_TEST_SECONDS
+#define PULSECOACH_TEST_SECONDS 15   // 120 for an AHA-style two-minute cycle
+#endif
+constexpr unsigned long TEST_DURATION = PULSECOACH_TEST_SECONDS * 1000UL;
+constexpr float CALIB_FACTOR = 117.58f;   // counts per gram until the cell is calibrated
+// pacing melody in training mode: locked to TARGET_BPM, or following the trainee
+constexpr char TRAINING_SONG = TETRIS_SONG;
+constexpr bool MELODY_FOLLOWS_BPM = false;
+constexpr int BULK_BURST = 4;   // download chunks queued per bulkTask pass
+constexpr size_t BULK_RESERVE = 3;   // queue slots the download leaves for everything else
+constexpr int NOTIFY_BURST = 4;   // values written per bleTask pass
 // Global variables
 bool isTrainingMode = true;
-vector<unsigned long> compression_times;
+CompressionTimes compression_times;
 unsigned long last_compression = 0;
-unsigned long last_mode_button_press = 0;
 unsigned long test_start_time = 0;
 unsigned long test_button_presses = 0;
-constexpr unsigned long MODE_DEBOUNCE = 200;
 int len = 0;
 float calibrationFactor;
-
-HX711 loadCell;
+// worst gap between two loop() entries, for checking that nothing blocks
+unsigned long last_loop_start = 0;
+unsigned long max_loop_period_us = 0;
+// total time between loop() entries, against which I2C time is reported
+unsigned long loop_time_us = 0;
+
+// state handed between tasks
+bool central_connected = false;
+bool bpm_pending = false;          // a compression completed since the last publish
+bool feedback_pending = false;     // ... since the last feedback update
+int zero_burst_left = 0;
+// every interval of the running test; compression_times only keeps the last few
+TestAccumulator test_stats;
+TestSummary test_result = {};
+
+Scheduler scheduler;
+int zero_burst_task;
+int test_task;
+int result_task;
+int return_task;
+int sample_task;
+int button_task;
+int power_task;
+
+Hx711Driver loadCell;
+// the block FIR in sampleTask does the smoothing, so the detector takes its output as is
+LoadCellBlockFilter force_filter;
+CompressionDetector detector(0);
+QualityAnalyzer quality;
+#if defined(ARDUINO_ARCH_RENESAS)
+DataFlashStore flash;
+#else
+// host build: same 8 x 1 KB layout in RAM, kept across runs with --flash=FILE
+RamFlashStore flash(sim::dataFlash(), sim::DATA_FLASH_SIZE, 1024);
+#endif
+// blocks 0-6 hold the session log, block 7 the load-cell calibration
+FlashRegion log_flash(flash, 0, 7 * 1024);
+FlashRegion calibration_flash(flash, 7 * 1024, 1024);
+// testing sessions survive without a central; written by logTask
+SessionLog session_log(log_flash);
+CalibrationStore calibration(calibration_flash);
+BackgroundTare retare;
+bool calibration_dirty = false;    // retare moved the zero; logTask saves it
+// re-tares that move the zero less than this don't rewrite the flash
+constexpr float CAL_RESAVE_GRAMS = 20.0f;
+// boot to the first calibrated sample reaching the detector
+bool load_cell_seen = false;
+bool load_cell_warned = false;
+constexpr unsigned long LOAD_CELL_TIMEOUT_MS = 1000;
+// calibration mode: a long press in training mode, then one short press per
+// weight in CAL_WEIGHTS (placed on the cell in that order) and a long press to
+// fit with the points so far; the fitted zero, gain and curve replace CALIB_FACTOR
+struct CalibrationWeight {
+    float grams;
+    const char *label;
+};
+constexpr CalibrationWeight CAL_WEIGHTS[] = {{0, "EMPTY"}, {5000, "5 KG"}, {10000, "10 KG"}, {20000, "20 KG"}, {30000, "30 KG"}};
+constexpr size_t CAL_STEPS = sizeof(CAL_WEIGHTS) / sizeof(CAL_WEIGHTS[0]);
+static_assert(CAL_STEPS <= CalibrationFit::MAX_POINTS, "more calibration weights than points");
+constexpr unsigned long CAL_TIMEOUT_MS = 120000;   // gives up without a press for this long
+CalibrationFit cal_fit;
+bool calibrating = false;
+size_t cal_step = 0;
+unsigned long cal_last_input = 0;
+BulkSender bulk(session_log);
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+FeedbackDisplay feedback(display, Wire, I2C_ADDRESS);
+PaceState pace = PACE_NONE;
+MelodyPlayer melody(SPEAKER_PIN);
+ModeButton mode_button(MODE_BUTTON_PIN);
+TelemetryBatcher telemetry;
+WaveformEncoder waveform;
+// every characteristic write goes through here and out from bleTask
+NotifyQueue notify;
+// a frame goes out when full or this long after its first sample
+constexpr unsigned long WAVEFORM_LATENCY_MS = 100;
+// idle: after IDLE_AFTER_MS in training mode with no compressions, no central
+// and no button, the HX711 is powered up for one conversion every IDLE_WAKE_US,
+// the other tasks run IDLE_SLOWDOWN times slower, advertising slows down and
+// loop() sleeps in WFI; a force onset, a button edge or a central wakes it
+#ifndef PULSECOACH_IDLE_SECONDS
+#define PULSECOACH_IDLE_SECONDS 60
+#endif
+constexpr unsigned long IDLE_AFTER_MS = PULSECOACH_IDLE_SECONDS * 1000UL;
+constexpr unsigned long IDLE_WAKE_US = 250000;
+constexpr unsigned long IDLE_SLOWDOWN = 10;
+constexpr int32_t IDLE_ONSET_GRAMS = CompressionDetector::MIN_PRESS_GRAMS / 2;
+// no valid conversion for four output periods after power-up (80 SPS)
+constexpr unsigned long LOAD_CELL_SETTLE_US = 50000;
+constexpr uint16_t ADVERTISING_INTERVAL = 160;         // 0.625 ms units: 100 ms
+constexpr uint16_t IDLE_ADVERTISING_INTERVAL = 1600;   // 1 s
+enum WakeReason : uint8_t { WAKE_FORCE, WAKE_BUTTON, WAKE_CENTRAL };
+const char *const WAKE_NAMES[] = {"force", "button", "central"};
+PowerMonitor power;
+bool idle = false;
+bool idle_sampling = false;        // HX711 powered up for this wake's conversion
+bool wake_pending = false;         // left idle, first full-rate sample not in yet
+bool press_unseen = false;         // woken by a press already under way
+WakeReason wake_reason = WAKE_FORCE;
+unsigned long wake_trigger_us = 0;
+unsigned long idle_since = 0;
+unsigned long last_activity = 0;
+unsigned long full_periods[Scheduler::MAX_TASKS];
+
+void setupTasks();
+bool sendTestResult();
+void onCentralConnected(BLEDevice central);
+void onCentralDisconnected(BLEDevice central);
+LoadCellCalibration currentCalibration();
 
 using namespace std;
 
 void setup() {
+    // no waiting for a USB host: the log ring holds the boot messages until loop() drains them
+    Serial.begin(9600);
+    LOG_INFO("Starting program...");
+
+    /* SETUP HX711 */
+    // first, so conversions queue up while the radio and the panel start
+    loadCell.begin(LC_DATA_PIN, LC_CLK_PIN, Hx711Driver::CHANNEL_A_128, LC_BACKEND, LC_RATE_PIN);
+    LoadCellCalibration stored;
+    if (calibration.load(stored)) {
+        // zero and scale from the last run; retare checks the zero against the first idle seconds
+        loadCell.setOffset(stored.offset);
+        loadCell.setCalibration(stored.gain, stored.curve);
+        retare.begin(stored.offset, stored.gain, millis());
+    } else {
+        // first boot: one blocking tare (10 conversions), kept for next time
+        LOG_INFO("TARING!");
+        loadCell.setCalibration(1.0f / CALIB_FACTOR);
+        if (loadCell.tare()) {
+            calibration.save(currentCalibration());
+            retare.begin(loadCell.offset(), loadCell.gramsPerCount(), millis());
+            LOG_INFO("TARE COMPLETE!");
+        } else {
+            LOG_WARN("Load Cell NOT DETECTED!");
+            load_cell_warned = true;
+        }
+    }
+    // from here on conversions are read by the DRDY interrupt
+    if (!loadCellIsrBegin(loadCell)) LOG_INFO("Load cell: no interrupt on D%d, polling DOUT", LC_DATA_PIN);
+
     //OLED setup
     oledSetup(display, SSD1306_SWITCHCAPVCC, I2C_ADDRESS);
 
@@ -57,257 +247,721 @@ void setup() {
     customService.addCharacteristic(testCharacteristic);
     customService.addCharacteristic(numberCharacteristic);
     customService.addCharacteristic(resultCharacteristic);
+    customService.addCharacteristic(telemetryCharacteristic);
+    customService.addCharacteristic(waveformCharacteristic);
+    customService.addCharacteristic(transferCharacteristic);
     BLE.addService(customService);
     testCharacteristic.writeValue(0); // Initial value for testing
     numberCharacteristic.writeValue(0); // Initial value for the number
-    resultCharacteristic.writeValue(0); // Initial Result
+    sendTestResult(); // Initial Result
 
+    BLE.setEventHandler(BLEConnected, onCentralConnected);
+    BLE.setEventHandler(BLEDisconnected, onCentralDisconnected);
+    BLE.setAdvertisingInterval(ADVERTISING_INTERVAL);
     BLE.advertise();
-    Serial.println("BLE Peripheral - Arduino R4 WiFi is now advertising...");
+    power.begin(micros());
+    power.setLoadCell(true, micros());
+    power.setAdvertising(ADVERTISING_INTERVAL, micros());
+    LOG_INFO("BLE Peripheral - Arduino R4 WiFi is now advertising...");
   
-    pinMode(MODE_BUTTON_PIN, INPUT_PULLUP);
+    // a press switches mode on release, a long press starts calibration
+    if (!mode_button.begin()) LOG_WARN("Mode button: no interrupt on D%d or no timer left, button disabled", MODE_BUTTON_PIN);
     pinMode(LED_BUILTIN, OUTPUT);
-    compression_times.reserve(SAMPLE_SIZE);
-    Serial.begin(9600);
-    while (!Serial);
-    Serial.println("Starting program...");
+    melody.begin();
+    melody.setTempo(TARGET_BPM);
 
+    if (session_log.mount()) {
+        LOG_INFO("Session log: %lu sessions, %lu records", session_log.sessions(), session_log.records());
+    } else {
+        LOG_WARN("Session log: flash not available");
+    }
 
-    /* SETUP HX711 */
-    loadCell.begin(LC_DATA_PIN, LC_CLK_PIN);
-    while (!loadCell.is_ready()) {Serial.println("Load Cell NOT DETECTED!");}
-    Serial.println("TARING!");
-    delay(3000);
-    loadCell.tare();
-    Serial.println("TARE COMPLETE!");
-    delay(500);
-    loadCell.set_scale(CALIB_FACTOR);
-    Serial.println("Calibration Complete!");
-    delay(500);
+    setupTasks();
+
+#ifdef PULSECOACH_BENCH
+    runBenchmarks(Serial, display);
+#endif
     // /* END TEST HX711*/
 }
 
-void checkModeButton() {
-    unsigned long current_time = millis();
-    if (!digitalRead(MODE_BUTTON_PIN) && (current_time - last_mode_button_press > MODE_DEBOUNCE)) {
-        last_mode_button_press = current_time;
-        isTrainingMode = !isTrainingMode;
-        
-        compression_times.clear();  // Clear history on mode switch
+void switchMode() {
+    isTrainingMode = !isTrainingMode;
 
-        if (isTrainingMode) {
-            Serial.println("Switched to Training Mode");
-        } else {
-            Serial.println("Switched to Testing Mode");
-            test_start_time = millis() + 3000;
-            test_button_presses = 0;
+    compression_times.clear();  // Clear history on mode switch
+
+    if (isTrainingMode) {
+        LOG_INFO("Switched to Training Mode");
+    } else {
+        LOG_INFO("Switched to Testing Mode");
+        test_button_presses = 0;
+    }
+}
+
+LoadCellCalibration currentCalibration() {
+    return LoadCellCalibration{loadCell.offset(), loadCell.gramsPerCount(), loadCell.curve()};
+}
+
+void promptCalibrationWeight() {
+    feedback.showStacked("PLACE", CAL_WEIGHTS[cal_step].label);
+    LOG_INFO("Calibration: place %.0f g, then press", CAL_WEIGHTS[cal_step].grams);
+}
+
+void startCalibration() {
+    calibrating = true;
+    cal_step = 0;
+    cal_last_input = millis();
+    cal_fit.reset();
+    retare.cancel();
+    melody.stop();
+    compression_times.clear();
+    LOG_INFO("Calibration started: %d weights", static_cast<int>(CAL_STEPS));
+    promptCalibrationWeight();
+}
+
+void endCalibration() {
+    calibrating = false;
+    // the detector's baseline and amplitude were in the old units
+    detector.reset();
+    last_compression = millis();
+}
+
+// Fits the captured points and, if they make sense, puts the result in use and in flash
+void finishCalibration() {
+    LoadCellCalibration fitted;
+    float rms = 0.0f;
+    if (!cal_fit.fit(fitted, rms) || !loadCell.setCalibration(fitted.gain, fitted.curve)) {
+        feedback.showStacked("CAL", "FAILED");
+        LOG_WARN("Calibration failed: %d points don't fit", static_cast<int>(cal_fit.points()));
+        endCalibration();
+        return;
+    }
+    loadCell.setOffset(fitted.offset);
+    calibration_dirty = true;
+    feedback.showStacked("CAL", "SAVED");
+    LOG_INFO("Calibration: %d points, rms %.1f g, offset %ld, gain %.6f g/count, curve %e",
+             static_cast<int>(cal_fit.points()), rms, static_cast<long>(fitted.offset), fitted.gain, fitted.curve);
+    endCalibration();
+}
+
+void calibrationButton(ButtonEvent event) {
+    cal_last_input = millis();
+    if (event == BUTTON_LONG) {
+        finishCalibration();
+        return;
+    }
+    if (cal_fit.capturing()) return;
+    cal_fit.capture(CAL_WEIGHTS[cal_step].grams, loadCell.gramsPerCount());
+    LOG_DEBUG("Calibration: capturing %.0f g", CAL_WEIGHTS[cal_step].grams);
+    feedback.showStacked("HOLD", "STILL");
+}
+
+void calibrationSample(int32_t raw) {
+    switch (cal_fit.add(raw)) {
+    case CalibrationFit::IDLE:
+    case CalibrationFit::CAPTURING:
+        return;
+    case CalibrationFit::CAPTURED:
+        LOG_INFO("Calibration: %.0f g captured", CAL_WEIGHTS[cal_step].grams);
+        if (++cal_step == CAL_STEPS) {
+            finishCalibration();
+            return;
         }
+        break;
+    case CalibrationFit::UNSTEADY:
+        LOG_WARN("Calibration: %.0f g never settled, press to retry", CAL_WEIGHTS[cal_step].grams);
+        break;
     }
+    promptCalibrationWeight();
 }
 
 float handleTrainingMode() {
     float avg_bpm = 0;
     if (compression_times.size() >= 2) {
-        avg_bpm = calculateWeightedAverageBPM(compression_times);
-        float std_dev = calculateBPMStandardDeviation(compression_times);
-        bool is_consistent = isConsistentCompression(compression_times);
-        
-        Serial.print("Current BPM: ");
-        Serial.print(avg_bpm);
-        Serial.print(" (Std Dev: ");
-        Serial.print(std_dev);
-        Serial.println(")");
-
-        if (avg_bpm >= MIN_BPM && avg_bpm <= MAX_BPM) {
+        BpmStats stats = computeBpmStats(compression_times);
+        avg_bpm = stats.weighted_mean;
+        float std_dev = stats.std_dev;
+        bool is_consistent = stats.consistent;
+        LOG_DEBUG("Consistency: %.2f", stats.consistency);
+        LOG_INFO("Current BPM: %.2f (Std Dev: %.2f)", avg_bpm, std_dev);
+
+        pace = classifyPace(avg_bpm, pace);
+        if (pace == PACE_GOOD) {
             digitalWrite(LED_BUILTIN, HIGH);
-            clearOled(display);
-            delay(2);
-            setStackedText(display, "GOOD", "PACE", 2, SSD1306_WHITE);
-            delay(2);
-            display.display();
         } else {
             digitalWrite(LED_BUILTIN, LOW);
             if (!is_consistent) {
-                Serial.println("Compression rate too inconsistent!");
+                LOG_INFO("Compression rate too inconsistent!");
             }
-            if (avg_bpm > MAX_BPM) {
-                Serial.println("Too Fast!");
-                clearOled(display);
-                delay(2);
-                setStackedText(display, "TOO", "FAST", 2, SSD1306_WHITE);
-                delay(2);
-                display.display();
-            } else if (avg_bpm < MIN_BPM) {
-                Serial.println("Too Slow!");
-                clearOled(display);
-                delay(2);
-                setStackedText(display, "TOO", "SLOW", 2, SSD1306_WHITE);
-                delay(2);
-                display.display();
+            if (pace == PACE_TOO_FAST) {
+                LOG_INFO("Too Fast!");
+            } else {
+                LOG_INFO("Too Slow!");
             }
         }
+        // rate first; once that is right, depth and recoil get the screen
+        QualityHint hint = quality.hint();
+        if (pace == PACE_GOOD && hint != HINT_NONE) {
+            feedback.showHint(hint);
+        } else {
+            // only touches the panel when the message actually changes
+            feedback.showPace(pace);
+        }
     }
     return avg_bpm;
 }
 
-float handleTestingMode(bool& shouldSwitchToTraining, float& accuracy, float& consistency) {
+// Scores the whole test from test_stats once TEST_DURATION is up
+bool handleTestingMode() {
     clearOled(display);
     unsigned long current_time = millis();
     unsigned long elapsed_time = current_time - test_start_time;
 
-    if (elapsed_time >= TEST_DURATION) {
-        float avg_bpm = 0;
+    if (elapsed_time < TEST_DURATION) {
+        int remaining_seconds = (TEST_DURATION - elapsed_time) / 1000;
+        LOG_INFO("Time remaining: %d seconds", remaining_seconds);
+        return false;
+    }
+
+    test_result = test_stats.summary(current_time);
+    if (test_result.compressions >= 2) {
+        LOG_INFO("Test Complete. Avg BPM: %.2f | Accuracy: %.2f | Consistency: %.2f",
+                 test_result.mean_bpm, test_result.accuracy, test_result.consistency);
+        LOG_INFO("Compressions: %lu | BPM p10/p50/p90: %.2f/%.2f/%.2f | In band: %.2f%%", test_result.compressions,
+                 test_result.p10_bpm, test_result.p50_bpm, test_result.p90_bpm, test_result.in_band * 100.0f);
+    }
+
+    compression_times.clear();  // Reset for next session
+    return true;
+}
+
+bool sendTestResult() {
+    uint8_t record[TEST_RESULT_SIZE];
+    return notify.push(resultCharacteristic, record, encodeTestResult(test_result, record));
+}
 
-        if (compression_times.size() >= 2) {
-            avg_bpm = calculateWeightedAverageBPM(compression_times, compression_times.size());  // Use full history
-            float std_dev = calculateBPMStandardDeviation(compression_times, compression_times.size());
 
-            // Accuracy = closeness to target
-            accuracy = max(0.0f, 1.0f - fabs(avg_bpm - TARGET_BPM) / TARGET_BPM);  // 0–1 score
 
-            // Consistency = inverse of std dev
-            consistency = max(0.0f, 1.0f - std_dev / MAX_STD_DEV);  // 0–1 score
+/* TASKS: each one does a bounded amount of work and returns; anything that
+   used to wait with delay() re-arms a task for later instead */
 
-            Serial.print("Test Complete. Avg BPM: ");
-            Serial.print(avg_bpm);
-            Serial.print(" | Accuracy: ");
-            Serial.print(accuracy);
-            Serial.print(" | Consistency: ");
-            Serial.println(consistency);
-        }
+void sendWaveformFrame() {
+    uint8_t frame[WaveformEncoder::MAX_FRAME];
+    size_t len = waveform.flush(frame);
+    notify.push(waveformCharacteristic, frame, len, true);
+}
+
+bool waveformStreaming() {
+    return central_connected && waveformCharacteristic.subscribed();
+}
+
+void streamSample(int32_t value, unsigned long timestamp) {
+    if (!waveform.add(value, timestamp)) {
+        sendWaveformFrame();
+        waveform.add(value, timestamp);
+    }
+}
+
+void printQuality(const CompressionQuality &q) {
+    LOG_DEBUG("Quality: peak %.1f kg, recoil %.1f kg, duty %d%%", q.peak_grams / 1000.0f,
+              q.residual_grams / 1000.0f, quality.dutyPct());
+}
+
+// Feeds the post-boot re-tare and applies its verdict
+void updateRetare(const LoadCellSample &sample) {
+    switch (retare.add(sample.raw, sample.timestamp)) {
+    case BackgroundTare::RUNNING:
+        return;
+    case BackgroundTare::ACCEPTED:
+        loadCell.setOffset(retare.offset());
+        if (fabsf(retare.driftGrams()) >= CAL_RESAVE_GRAMS) calibration_dirty = true;
+        LOG_INFO("Re-tare: zero moved %.0f g", retare.driftGrams());
+        return;
+    case BackgroundTare::MOVING:
+        LOG_INFO("Re-tare skipped: cell in use");
+        return;
+    case BackgroundTare::LOADED:
+        LOG_WARN("Re-tare skipped: %.0f g on the cell", retare.driftGrams());
+        return;
+    }
+}
+
+// takes effect from the next advertising event
+void setAdvertisingInterval(uint16_t interval) {
+    BLE.stopAdvertise();
+    BLE.setAdvertisingInterval(interval);
+    BLE.advertise();
+    power.setAdvertising(interval, micros());
+}
 
-        compression_times.clear();  // Reset for next session
-        shouldSwitchToTraining = true;
-        return avg_bpm;
+void loadCellPower(bool on) {
+    if (on) {
+        loadCell.powerUp();
+#ifdef PULSECOACH_HX711_SPI
+        // powerUp() re-runs SPI.begin(), which takes D13 (SCK, unwired) from the pace LED
+        pinMode(LED_BUILTIN, OUTPUT);
+        digitalWrite(LED_BUILTIN, pace == PACE_GOOD ? HIGH : LOW);
+#endif
+        loadCellIsrBegin(loadCell);
     } else {
-        int remaining_seconds = (TEST_DURATION - elapsed_time) / 1000;
-        Serial.print("Time remaining: ");
-        Serial.print(remaining_seconds);
-        Serial.println(" seconds");
-        return 0;
+        loadCellIsrEnd();
+        loadCell.powerDown();
     }
-    
+    power.setLoadCell(on, micros());
 }
 
+void enterIdle() {
+    idle = true;
+    idle_since = millis();
+    loadCellPower(false);
+    LoadCellSample stale;
+    while (loadCellPop(stale)) {}
+    // powerTask starts the sample task for each wake's conversion
+    scheduler.stop(sample_task);
+    for (int i = 0; i < scheduler.count(); i++) {
+        full_periods[i] = scheduler.task(i).period;
+        if (i == power_task || full_periods[i] == 0 || full_periods[i] >= 1000000UL) continue;
+        scheduler.setPeriod(i, full_periods[i] * IDLE_SLOWDOWN);
+    }
+    scheduler.setPeriod(power_task, IDLE_WAKE_US);
+    setAdvertisingInterval(IDLE_ADVERTISING_INTERVAL);
+    LOG_INFO("Idle: nothing for %lu s", (idle_since - last_activity) / 1000);
+}
 
-void loop() {
-    // required force (grams) to trigger a compression
-    constexpr int FORCE_THRESH = 100;
-    bool compressed = false;
-    // number of compressions
-    int compressionCtr = 0;
-    float force;
-
-    bool oldTraining = isTrainingMode;
-    checkModeButton();
-    if (oldTraining != isTrainingMode){
-      testCharacteristic.writeValue(1); // start test
-      for (int i = 0; i < 5; i++) {
-              numberCharacteristic.writeValue(0);
-              delay(600);
-          }
-    }
-    bool pressed = 0;
-    BLEDevice central = BLE.central();
-    if (central) {
-        Serial.print("Connected to central: ");
-        Serial.println(central.address());
+// trigger_us: when the force, button edge or connection that ended the idle was seen
+void exitIdle(WakeReason reason, unsigned long trigger_us) {
+    idle = false;
+    for (int i = 0; i < scheduler.count(); i++) {
+        if (full_periods[i] > 0) scheduler.setPeriod(i, full_periods[i]);
     }
-  
-  
-    // user's compression reaches minimum threshold
-    if ((force = measureLoadCell(loadCell, LC_DATA_PIN, LC_CLK_PIN)) >= 3500.0)
-    {
-        compressed = true;
-        pressed = 1;
-        unsigned long currentTime = millis();
-        Serial.println("Pressed!");
-        delay(5);
-    
-        float currForce = force;
-        // hold while user's hand is pressed down
-        do 
-        {
-            
-            force = measureLoadCell(loadCell, LC_DATA_PIN, LC_CLK_PIN);
-            
-            if (force < currForce - 500) 
+    // already up if this wake's conversion found the force
+    if (!idle_sampling) loadCellPower(true);
+    idle_sampling = false;
+    scheduler.start(sample_task);
+    if (!central_connected) setAdvertisingInterval(ADVERTISING_INTERVAL);
+    wake_pending = true;
+    press_unseen = reason == WAKE_FORCE;
+    wake_reason = reason;
+    wake_trigger_us = trigger_us;
+    last_activity = millis();
+    LOG_INFO("Idle for %lu s", (last_activity - idle_since) / 1000);
+}
+
+// One conversion per wake: back to full rate on a force onset, otherwise
+// power the HX711 down again until the next wake
+void idleSample() {
+    LoadCellSample sample;
+    if (!loadCellPop(sample)) return;
+    int32_t grams = loadCell.toGramsFixed(sample.raw) >> Hx711Driver::GRAMS_FRAC_BITS;
+    // from the detector's zero, so a weight left on the cell doesn't wake it
+    if (grams - detector.baseline() >= IDLE_ONSET_GRAMS) {
+        exitIdle(WAKE_FORCE, sample.micros);
+        return;
+    }
+    idle_sampling = false;
+    scheduler.stop(sample_task);
+    loadCellPower(false);
+}
+
+// 5 ms: drain everything the DRDY interrupt queued since the last run, one
+// block at a time through the FIR, then into the detector
+void sampleTask() {
+    loadCellPoll();
+    if (idle) {
+        idleSample();
+        return;
+    }
+    if (calibrating) {
+        LoadCellSample sample;
+        while (loadCellPop(sample)) calibrationSample(sample.raw);
+        return;
+    }
+    bool streaming = waveformStreaming();
+    LoadCellSample samples[LoadCellBlockFilter::BLOCK];
+    int16_t block[LoadCellBlockFilter::BLOCK];
+    int16_t filtered[LoadCellBlockFilter::BLOCK];
+    int16_t slope[LoadCellBlockFilter::BLOCK];
+    size_t n;
+    do {
+        for (n = 0; n < LoadCellBlockFilter::BLOCK && loadCellPop(samples[n]); n++) {
+            if (retare.running()) updateRetare(samples[n]);
+            int32_t force = loadCell.toGramsFixed(samples[n].raw);
+            if (streaming) streamSample(force >> Hx711Driver::GRAMS_FRAC_BITS, samples[n].timestamp);
+            block[n] = gramsFixedToQ15(force, Hx711Driver::GRAMS_FRAC_BITS);
+        }
+        force_filter.process(block, filtered, slope, n);
+        if (n > 0 && !load_cell_seen) {
+            load_cell_seen = true;
+            LOG_INFO("Boot: first sample at %lu ms", millis());
+        }
+        // the first conversion after the trigger; one from the wake before it may still be queued
+        for (size_t i = 0; i < n && wake_pending; i++) {
+            long latency = static_cast<long>(samples[i].micros - wake_trigger_us);
+            if (latency < 0) continue;
+            wake_pending = false;
+            power.addWake(latency);
+            LOG_INFO("Awake (%s): full rate %ld us after the trigger", WAKE_NAMES[wake_reason], latency);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            unsigned long timestamp = samples[i].timestamp;
+            float force = filtered[i] * FORCE_Q15_GRAMS;
+            bool wasIdle = detector.isIdle();
+            bool completed = detector.update(force, timestamp);
+            if (quality.update(force, slope[i], timestamp, detector))
             {
-                compressed = false;
-                Serial.println("Released!");
+                // a cycle is complete once the next press starts
+                telemetry.add(quality.last(), millis());
+                if (session_log.inSession()) session_log.addCompression(quality.last());
+                printQuality(quality.last());
+            }
+            if (completed)
+            {
+                bpm_pending = true;
+                feedback_pending = true;
+                LOG_DEBUG("Released!");
+
+                // the history evicts the oldest press itself once it holds SAMPLE_SIZE
+                unsigned long pressTime = detector.lastEvent().press_time;
+                if (press_unseen) {
+                    // it began while the HX711 was off, so its press time is late
+                    press_unseen = false;
+                } else {
+                    compression_times.push_back(pressTime);
+                    if (!isTrainingMode && test_start_time != 0) test_stats.addPress(pressTime);
+                }
+                last_compression = pressTime;
+            }
+            else if (wasIdle && !detector.isIdle())
+            {
+                LOG_DEBUG("Pressed!");
             }
-            
-            currForce = force;
-            delay(5);
-            // if ((force = measureLoadCell(loadCell, LC_DATA_PIN, LC_CLK_PIN)) < 3500.0)
-            // {
-            //     compressed = false;
-            //     Serial.println("Released!");
-            //     delay(20);
-            // }
-        } while (compressed);
-        delay(2);
-        Serial.println("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA");
-
-        if (compression_times.size() >= SAMPLE_SIZE) {
-            compression_times.erase(compression_times.begin());
         }
+    } while (n == LoadCellBlockFilter::BLOCK);
+
+    if (!load_cell_seen && !load_cell_warned && millis() > LOAD_CELL_TIMEOUT_MS) {
+        LOG_WARN("Load Cell NOT DETECTED!");
+        load_cell_warned = true;
+    }
 
-        compression_times.push_back(currentTime);
-        last_compression = currentTime;
+    if (waveform.count() > 0 && (!streaming || millis() - waveform.firstTimestamp() >= WAVEFORM_LATENCY_MS)) {
+        sendWaveformFrame();
+    }
+}
+
+// 10 ms: take debounced presses from the button ISR and start/stop the test sequence on a switch
+void buttonTask() {
+    ButtonEvent event = mode_button.poll(micros());
+    if (calibrating) {
+        if (event != BUTTON_NONE) {
+            calibrationButton(event);
+            mode_button.handled(micros());
+        } else if (millis() - cal_last_input > CAL_TIMEOUT_MS) {
+            feedback.showStacked("CAL", "TIMEOUT");
+            LOG_WARN("Calibration abandoned");
+            endCalibration();
+        }
+        return;
+    }
+    if (event == BUTTON_LONG) {
+        if (isTrainingMode) {
+            startCalibration();
+            mode_button.handled(micros());
+        }
+        return;
+    }
+    if (event != BUTTON_SHORT) return;
+    switchMode();
+    mode_button.handled(micros());
+
+    notify.push(testCharacteristic, 1); // start test
+    zero_burst_left = 5;
+    scheduler.start(zero_burst_task);
+
+    scheduler.stop(result_task);
+    scheduler.stop(return_task);
+    // leaving a test early still leaves a record of it
+    if (session_log.inSession()) session_log.endSession(millis(), SessionLog::Summary{0, 0, 0}, SessionLog::END_ABORTED);
+    test_start_time = 0;
+    melody.stop();
+    if (isTrainingMode) {
+        scheduler.stop(test_task);
+    } else {
+        // 3 s lead-in before the countdown, which used to be covered by the zero burst delays
+        scheduler.start(test_task, 3000000UL);
     }
+}
+
+// 600 ms: five BPM = 0 writes after a mode switch, then stops itself
+void zeroBurstTask() {
+    notify.push(numberCharacteristic, 0);
+    if (--zero_burst_left <= 0) scheduler.stop(zero_burst_task);
+}
+
+// BLE.poll() runs these; the radio stops advertising while a central is connected
+void onCentralConnected(BLEDevice central) {
+    LOG_INFO("Connected to central: %s", central.address());
+    central_connected = true;
+    power.setAdvertising(0, micros());
+    if (idle) exitIdle(WAKE_CENTRAL, micros());
+}
 
-    /* END OF REPLACING LOGIC PART 1*/
+void onCentralDisconnected(BLEDevice central) {
+    LOG_INFO("Disconnected from central: %s", central.address());
+    central_connected = false;
+    // an interrupted download resumes from the app's offset on reconnect
+    bulk.stop();
+    power.setAdvertising(ADVERTISING_INTERVAL, micros());
+}
 
+// 10 ms: connection events, then a few queued values; a write that waits on a
+// congested link ends the pass so the sample task gets back in
+void bleTask() {
+    BLE.poll();
+    notify.send(NOTIFY_BURST);
+}
 
-    /* UNCOMMENT ALL BELOW!!! */
+// 100 ms: idle decay in either mode, live feedback in training mode once per compression
+void feedbackTask() {
     // Time-based decay logic — reset BPM and clear history if idle too long
-    const unsigned long DECAY_THRESHOLD = 4200; // 3 seconds
+    const unsigned long DECAY_THRESHOLD = 4200;
     if (millis() - last_compression > DECAY_THRESHOLD && !compression_times.empty()) {
-        Serial.println("No compressions detected for 4 seconds. Resetting...");
-        clearOled(display);
-        setStackedText(display, "NO", "BPM", 2, SSD1306_WHITE);
-        display.display();
+        LOG_INFO("No compressions detected for 4 seconds. Resetting...");
+        feedback.showStacked("NO", "BPM");
+        pace = PACE_NONE;
+        melody.stop();
         compression_times.clear();  // Clear for new set
         last_compression = millis(); // Avoid repeated clearing
-        if (central && central.connected()) {
-            numberCharacteristic.writeValue(0); // Send BPM = 0 over BLE
+        if (central_connected) {
+            notify.push(numberCharacteristic, 0); // Send BPM = 0 over BLE
         }
     }
-    
-    if (isTrainingMode) {
-        float avg_bpm = handleTrainingMode();
-        if (central.connected() && pressed) {
-            Serial.println("OOOOOOOOOOOOOOOOOOOOOOOOOOOOO");
-            numberCharacteristic.writeValue(avg_bpm);
-        }
-    } else {
-        static bool waitingToSwitch = false;
-        static unsigned long testEndTime = 0;
-        bool switchToTraining = false;
-        float accuracy = 0.0, consistency = 0.0;
-        float test_avg_bpm = handleTestingMode(switchToTraining, accuracy, consistency);
-
-        if (switchToTraining && !waitingToSwitch) {
-            // Send results once
-            if (central && central.connected()) {
-                delay(2000);
-                resultCharacteristic.writeValue(test_avg_bpm);
-                Serial.println("Sent test results to Flutter app.");
-            }
 
-            waitingToSwitch = true;
-            testEndTime = millis();
+    if (isTrainingMode && feedback_pending) handleTrainingMode();
+    feedback_pending = false;
+}
+
+// 20 ms: once per completed compression, send the BPM and pace the melody
+void publishTask() {
+    if (!bpm_pending) return;
+    bpm_pending = false;
+    if (!isTrainingMode || compression_times.size() < 2) return;
+
+    float avg_bpm = computeBpmStats(compression_times).weighted_mean;
+    // starts with the first measured rate and stops again on decay
+    if (!melody.playing()) melody.play(TRAINING_SONG);
+    melody.setTempo(MELODY_FOLLOWS_BPM ? avg_bpm : TARGET_BPM);
+
+    if (central_connected) {
+        notify.push(numberCharacteristic, static_cast<int32_t>(avg_bpm));
+    }
+}
+
+// 50 ms: pick up the MTU the app reports and send full or timed-out batches
+void telemetryTask() {
+    if (telemetryCharacteristic.written() && telemetryCharacteristic.valueLength() >= 2) {
+        const uint8_t *v = telemetryCharacteristic.value();
+        telemetry.setMtu(v[0] | (v[1] << 8));
+        waveform.setCapacity(telemetry.mtu() - 3);
+    }
+    if (!telemetry.ready(millis())) return;
+    if (!central_connected || !telemetryCharacteristic.subscribed()) {
+        telemetry.discard();
+        return;
+    }
+    uint8_t packet[TelemetryBatcher::MAX_PACKET];
+    size_t len = telemetry.flush(packet);
+    notify.push(telemetryCharacteristic, packet, len, true);
+}
+
+// 15 ms, about one connection event: a few download chunks per pass, each a
+// notification over the HCI UART to the radio
+void bulkTask() {
+    if (transferCharacteristic.written()) {
+        bulk.onCommand(transferCharacteristic.value(), transferCharacteristic.valueLength(), millis());
+    }
+    if (!bulk.active()) return;
+    if (!central_connected || !transferCharacteristic.subscribed()) {
+        bulk.stop();
+        return;
+    }
+    uint8_t packet[BulkSender::MAX_PACKET];
+    unsigned long done = bulk.transfers();
+    for (int i = 0; i < BULK_BURST && notify.available() > BULK_RESERVE; i++) {
+        size_t len = bulk.fill(packet, millis());
+        if (len == 0 || !notify.push(transferCharacteristic, packet, len, true)) break;
+        bulk.sent(millis());
+    }
+    if (bulk.transfers() != done) {
+        LOG_INFO("Download: %lu bytes in %lu ms, %lu retransmits", bulk.lastBytes(), bulk.lastMs(), bulk.retransmits());
+    }
+}
+
+// 1 s while a test runs
+void testTask() {
+    if (test_start_time == 0) {
+        // first run after the lead-in: score only compressions made during the test
+        test_start_time = millis();
+        compression_times.clear();
+        test_stats.reset(test_start_time);
+        session_log.beginSession(test_start_time);
+    }
+
+    if (!handleTestingMode()) return;
+
+    scheduler.stop(test_task);
+    test_start_time = 0;
+    session_log.endSession(millis(), SessionLog::Summary{test_result.mean_bpm, test_result.accuracy,
+                                                         test_result.consistency});
+    // results go out 2 s after the end, then another 2 s before training resumes
+    scheduler.start(central_connected ? result_task : return_task, 2000000UL);
+}
+
+// 10 ms: at most one flash program/erase step for the session log, or a calibration save
+void logTask() {
+    if (calibration_dirty) {
+        calibration_dirty = false;
+        if (!calibration.save(currentCalibration())) {
+            LOG_WARN("Calibration not saved");
         }
+        return;
+    }
+    session_log.pump();
+}
 
-        if (waitingToSwitch && millis() - testEndTime > 2000) {  // 2 second pause
-            isTrainingMode = true;
-            waitingToSwitch = false;
-            Serial.println("Auto-switched back to Training Mode.");
+void resultTask() {
+    if (central_connected) {
+        if (sendTestResult()) {
+            LOG_INFO("Sent test results to Flutter app.");
+        } else {
+            LOG_WARN("Test results not sent: notify queue full");
         }
+    }
+    scheduler.start(return_task, 2000000UL);
+}
+
+void returnTask() {
+    isTrainingMode = true;
+    LOG_INFO("Auto-switched back to Training Mode.");
+}
 
-      }
-      delay(10);
+// 1 s: go idle once nothing has happened for IDLE_AFTER_MS.
+// IDLE_WAKE_US while idle: power the HX711 up for one conversion
+void powerTask() {
+    if (idle) {
+        // a wake whose conversion hasn't come yet (no cell) keeps it up
+        if (idle_sampling) return;
+        idle_sampling = true;
+        loadCellPower(true);
+        scheduler.start(sample_task, LOAD_CELL_SETTLE_US);
+        return;
+    }
+    bool busy = !isTrainingMode || calibrating || central_connected || melody.playing() || mode_button.down() ||
+                retare.running() || !detector.isIdle() || !compression_times.empty() ||
+                scheduler.isActive(result_task) || scheduler.isActive(return_task);
+    if (busy) {
+        last_activity = millis();
+    } else if (millis() - last_activity >= IDLE_AFTER_MS) {
+        enterIdle();
+    }
 }
 
+// 5 s: bus load and any task that missed a deadline or ran over budget
+void statsTask() {
+    if (loop_time_us == 0) return;
+    LOG_INFO("I2C load: %.2f%% (%lu redraws, %lu pages)", 100.0f * feedback.stats().i2c_us / loop_time_us,
+             feedback.stats().redraws, feedback.stats().pages);
+
+    // missed/overran per task that was late
+    for (int i = 0; i < scheduler.count(); i++) {
+        const Task &t = scheduler.task(i);
+        if (t.stats.missed == 0 && t.stats.overruns == 0) continue;
+        LOG_WARN("Late: %s %lu/%lu", t.name, t.stats.missed, t.stats.overruns);
+    }
+    if (logDropped() > 0) LOG_WARN("Log: %lu records dropped in total", logDropped());
+    if (loadCellOverruns() > 0) {
+        LOG_WARN("Load cell: %lu samples dropped in total", static_cast<unsigned long>(loadCellOverruns()));
+    }
 
+    if (session_log.dropped() > 0 || session_log.failures() > 0) {
+        LOG_WARN("Session log: %lu dropped, %lu flash failures", session_log.dropped(), session_log.failures());
+    }
+
+    ButtonStats button = mode_button.stats();
+    if (button.events > 0 || button.bounces > 0) {
+        LOG_INFO("Button: %lu presses, latency avg %luus max %luus, %lu bounces", button.events,
+                 button.events > 0 ? button.total_latency_us / button.events : 0UL, button.max_latency_us,
+                 button.bounces);
+        mode_button.resetStats();
+    }
+
+    NotifyStats ble = notify.stats();
+    if (ble.sent > 0 || ble.dropped > 0) {
+        LOG_INFO("BLE queue: %lu sent, depth %d max %d, %lu coalesced, %lu dropped, %lu waited, latency avg %luus max %luus",
+                 ble.sent, static_cast<int>(notify.depth()), static_cast<int>(ble.max_depth), ble.coalesced,
+                 ble.dropped, ble.waits, ble.sent > 0 ? ble.total_latency_us / ble.sent : 0UL, ble.max_latency_us);
+        notify.resetStats();
+    }
+
+    PowerReport p = power.report(micros());
+    if (p.window_us > 0) {
+        LOG_INFO("Power: %s, est %lu uA, MCU awake %lu%%, HX711 on %lu%%", idle ? "idle" : "full rate",
+                 static_cast<unsigned long>(p.current_ua),
+                 static_cast<unsigned long>(100ULL * p.awake_us / p.window_us),
+                 static_cast<unsigned long>(100ULL * p.load_cell_us / p.window_us));
+    }
+    if (p.wakes > 0) {
+        LOG_INFO("Wake: %lu, latency avg %luus max %luus", p.wakes, p.total_wake_us / p.wakes, p.max_wake_us);
+    }
+
+    MelodyStats notes = melody.stats();
+    if (notes.onsets > 0) {
+        LOG_INFO("Melody: %lu notes, onset error avg %luus max %luus", notes.onsets,
+                 notes.total_error_us / notes.onsets, notes.max_error_us);
+        melody.resetStats();
+    }
+    // each report covers the last five seconds
+    scheduler.resetStats();
+}
+
+void setupTasks() {
+    // periods and budgets in microseconds; the budget is what a run may take before it counts as an overrun
+    sample_task = scheduler.addPeriodic("sample", sampleTask, 5000, 2000);
+    button_task = scheduler.addPeriodic("button", buttonTask, 10000, 2000);
+    scheduler.addPeriodic("ble", bleTask, 10000, 5000);
+    scheduler.addPeriodic("publish", publishTask, 20000, 5000);
+    scheduler.addPeriodic("telemetry", telemetryTask, 50000, 5000);
+    scheduler.addPeriodic("feedback", feedbackTask, 100000, 30000);
+    // a block erase takes ~10 ms on the RA4M1; the DRDY ring covers 200 ms
+    scheduler.addPeriodic("log", logTask, 10000, 15000);
+    scheduler.addPeriodic("bulk", bulkTask, 15000, 8000);
+    scheduler.addPeriodic("stats", statsTask, 5000000, 100000, 5000000);
+    zero_burst_task = scheduler.addPeriodic("zero", zeroBurstTask, 600000, 5000);
+    scheduler.stop(zero_burst_task);
+    test_task = scheduler.addPeriodic("test", testTask, 1000000, 30000);
+    scheduler.stop(test_task);
+    result_task = scheduler.addOneShot("result", resultTask, 5000);
+    return_task = scheduler.addOneShot("return", returnTask, 5000);
+    power_task = scheduler.addPeriodic("power", powerTask, 1000000, 5000);
+}
+
+void loop() {
+    unsigned long loop_start = micros();
+    if (last_loop_start != 0) {
+        unsigned long period = loop_start - last_loop_start;
+        loop_time_us += period;
+        if (period > max_loop_period_us) max_loop_period_us = period;
+    }
+    last_loop_start = loop_start;
+
+    if (idle && mode_button.pending()) {
+        exitIdle(WAKE_BUTTON, mode_button.lastEdgeMicros());
+        scheduler.start(button_task);
+    }
+    scheduler.run(loop_start);
+    // diagnostics go out in the slack, only as much as the TX buffer takes
+    if (scheduler.timeUntilNext(micros()) > 0) {
+        logDrain(Serial);
+        // the next interrupt ends the sleep; the 1 ms tick bounds it
+        if (idle) power.sleep();
+    }
+}
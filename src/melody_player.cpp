@@ -0,0 +1,117 @@
+#include "melody_player.h"
+#include "song_setup.h"
+
+constexpr float MIN_TEMPO = 40.0f;
+constexpr float MAX_TEMPO = 200.0f;
+
+bool MelodyPlayer::begin()
+{
+    uint8_t type;
+    int8_t channel = FspTimer::get_available_timer(type);
+    if (channel < 0) return false;
+    if (!timer_.begin(TIMER_MODE_PERIODIC, type, channel, 1000000.0f / TICK_US, 0.0f, onTick, this)) return false;
+    if (!timer_.setup_overflow_irq() || !timer_.open()) return false;
+    // silent until the first note
+    pwm_.begin(440.0f, 0.0f);
+    ready_ = true;
+    return true;
+}
+
+void MelodyPlayer::play(char song, bool repeat)
+{
+    if (!ready_) return;
+    timer_.stop();
+    pwm_.pulse_perc(0);
+
+    melody_ = nullptr;
+    notes_ = songNotes(song, melody_);
+    repeat_ = repeat;
+    index_ = 0;
+    sounding_ = false;
+    finishing_ = false;
+    // first note on the next tick
+    next_onset_ = micros() + TICK_US;
+    playing_ = notes_ > 0;
+    if (playing_) timer_.start();
+}
+
+void MelodyPlayer::stop()
+{
+    if (!ready_) return;
+    timer_.stop();
+    playing_ = false;
+    sounding_ = false;
+    pwm_.pulse_perc(0);
+}
+
+void MelodyPlayer::setTempo(float bpm)
+{
+    if (!(bpm > 0)) return;
+    bpm = constrain(bpm, MIN_TEMPO, MAX_TEMPO);
+    // one aligned word, so the ISR never sees half an update
+    whole_note_us_ = static_cast<unsigned long>(240000000.0f / bpm);
+}
+
+MelodyStats MelodyPlayer::stats() const
+{
+    noInterrupts();
+    MelodyStats copy = stats_;
+    interrupts();
+    return copy;
+}
+
+void MelodyPlayer::resetStats()
+{
+    noInterrupts();
+    stats_ = MelodyStats{0, 0, 0};
+    interrupts();
+}
+
+void MelodyPlayer::onTick(timer_callback_args_t *args)
+{
+    MelodyPlayer *player = static_cast<MelodyPlayer *>(const_cast<void *>(args->p_context));
+    player->tick(micros());
+}
+
+void MelodyPlayer::tick(unsigned long now)
+{
+    if (!playing_) return;
+
+    // we only play the note for 90% of the duration, leaving 10% as a pause
+    if (sounding_ && static_cast<long>(now - note_off_) >= 0) {
+        pwm_.pulse_perc(0);
+        sounding_ = false;
+    }
+    if (finishing_) {
+        // song over: stop ticking once the last note has been released
+        if (!sounding_) {
+            playing_ = false;
+            timer_.stop();
+        }
+        return;
+    }
+    if (static_cast<long>(now - next_onset_) < 0) return;
+
+    unsigned long error = now - next_onset_;
+    stats_.onsets++;
+    stats_.total_error_us += error;
+    if (error > stats_.max_error_us) stats_.max_error_us = error;
+
+    // decoded straight from flash
+    PackedNote note = melody_[index_];
+    unsigned long duration = noteDuration(note, whole_note_us_);
+    uint16_t pitch = noteFrequency(note);
+
+    if (pitch != 0) {
+        pwm_.period_us(1000000 / pitch);
+        pwm_.pulse_perc(50.0f);
+        sounding_ = true;
+        note_off_ = next_onset_ + duration / 10 * 9;
+    }
+    next_onset_ += duration;
+
+    if (++index_ >= notes_) {
+        index_ = 0;
+        finishing_ = !repeat_;
+    }
+}
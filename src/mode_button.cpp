@@ -0,0 +1,95 @@
+#include "mode_button.h"
+#include "irq_pins.h"
+
+ModeButton *ModeButton::instance_ = nullptr;
+
+bool ModeButton::begin()
+{
+    pinMode(pin_, INPUT_PULLUP);
+    stable_down_ = down_ = !digitalRead(pin_);
+    // attachInterrupt() would quietly do nothing
+    if (!pinHasIrq(pin_)) return false;
+
+    uint8_t type;
+    int8_t channel = FspTimer::get_available_timer(type);
+    if (channel < 0) return false;
+    if (!timer_.begin(TIMER_MODE_ONE_SHOT, type, channel, 1000000.0f / SETTLE_US, 0.0f, onSettled, this)) return false;
+    if (!timer_.setup_overflow_irq() || !timer_.open()) return false;
+
+    instance_ = this;
+    attachInterrupt(digitalPinToInterrupt(pin_), onEdge, CHANGE);
+    return true;
+}
+
+ButtonEvent ModeButton::poll(unsigned long now_us)
+{
+    ButtonEdge edge;
+    while (edges_.pop(edge)) {
+        down_ = edge.down;
+        if (down_) {
+            down_us_ = edge.us;
+            long_sent_ = false;
+            continue;
+        }
+        if (long_sent_) continue;
+        event_us_ = edge.us;
+        // held past the long press before loop() got to look
+        if (edge.us - down_us_ >= LONG_PRESS_MS * 1000UL) return BUTTON_LONG;
+        return BUTTON_SHORT;
+    }
+    if (down_ && !long_sent_ && now_us - down_us_ >= LONG_PRESS_MS * 1000UL) {
+        long_sent_ = true;
+        event_us_ = down_us_ + LONG_PRESS_MS * 1000UL;
+        return BUTTON_LONG;
+    }
+    return BUTTON_NONE;
+}
+
+void ModeButton::handled(unsigned long now_us)
+{
+    unsigned long latency = now_us - event_us_;
+    stats_.events++;
+    stats_.total_latency_us += latency;
+    if (latency > stats_.max_latency_us) stats_.max_latency_us = latency;
+}
+
+ButtonStats ModeButton::stats() const
+{
+    ButtonStats copy = stats_;
+    copy.bounces = bounces_;
+    return copy;
+}
+
+void ModeButton::resetStats()
+{
+    stats_ = ButtonStats{0, 0, 0, 0};
+    bounces_ = 0;
+}
+
+void ModeButton::onEdge()
+{
+    ModeButton *button = instance_;
+    if (button->armed_) return;
+    button->armed_ = true;
+    button->first_edge_us_ = micros();
+    button->timer_.reset();
+    button->timer_.start();
+}
+
+void ModeButton::onSettled(timer_callback_args_t *args)
+{
+    static_cast<ModeButton *>(const_cast<void *>(args->p_context))->settled();
+}
+
+void ModeButton::settled()
+{
+    bool down = !digitalRead(pin_);
+    if (down != stable_down_) {
+        stable_down_ = down;
+        last_edge_us_ = first_edge_us_;
+        edges_.push(ButtonEdge{down, first_edge_us_});
+    } else {
+        bounces_ = bounces_ + 1;
+    }
+    armed_ = false;
+}
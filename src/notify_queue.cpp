@@ -0,0 +1,102 @@
+#include "notify_queue.h"
+#include <Arduino.h>
+#include <string.h>
+
+bool NotifyQueue::push(BLECharacteristic &characteristic, const uint8_t *value, size_t len, bool stream)
+{
+    if (len > MAX_VALUE) len = MAX_VALUE;
+    Slot *slot = nullptr;
+    if (!stream) {
+        for (Slot &s : slots_) {
+            if (s.used && !s.stream && s.characteristic == &characteristic) {
+                // keeps its place in line, with the newer value
+                slot = &s;
+                stats_.coalesced++;
+                break;
+            }
+        }
+    }
+    if (!slot) {
+        for (Slot &s : slots_) {
+            if (!s.used) {
+                slot = &s;
+                break;
+            }
+        }
+        if (!slot && !stream) {
+            // a value outranks a stream item: the oldest one makes room
+            for (Slot &s : slots_) {
+                if (s.stream && (!slot || static_cast<int32_t>(s.seq - slot->seq) < 0)) slot = &s;
+            }
+            if (slot) {
+                slot->used = false;
+                depth_--;
+                stats_.dropped++;
+            }
+        }
+        if (!slot) {
+            stats_.dropped++;
+            return false;
+        }
+        slot->used = true;
+        slot->characteristic = &characteristic;
+        slot->stream = stream;
+        slot->seq = seq_++;
+        if (++depth_ > stats_.max_depth) stats_.max_depth = depth_;
+    }
+    memcpy(slot->value, value, len);
+    slot->len = len;
+    slot->queued_us = micros();
+    return true;
+}
+
+bool NotifyQueue::push(BLECharacteristic &characteristic, int32_t value)
+{
+    uint8_t bytes[4] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+                        static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+    return push(characteristic, bytes, sizeof(bytes));
+}
+
+int NotifyQueue::send(int max)
+{
+    int sent = 0;
+    while (sent < max && depth_ > 0) {
+        if (spacing_us_ > 0 && static_cast<long>(micros() - next_write_us_) < 0) break;
+        Slot *next = nullptr;
+        for (Slot &s : slots_) {
+            // wrap-safe: the oldest is furthest behind seq_
+            if (s.used && (!next || static_cast<int32_t>(s.seq - next->seq) < 0)) next = &s;
+        }
+        unsigned long start = micros();
+        next->characteristic->writeValue(next->value, next->len);
+        unsigned long done = micros();
+        next->used = false;
+        depth_--;
+        sent++;
+
+        unsigned long latency = done - next->queued_us;
+        stats_.sent++;
+        stats_.total_latency_us += latency;
+        if (latency > stats_.max_latency_us) stats_.max_latency_us = latency;
+
+        unsigned long took = done - start;
+        if (took > CONGESTED_US) {
+            stats_.waits++;
+            // with some margin, or the next write lands right on the next event
+            if (took + took / 4 > spacing_us_) spacing_us_ = took + took / 4;
+        } else {
+            spacing_us_ -= spacing_us_ / 8;
+            if (spacing_us_ < CONGESTED_US) spacing_us_ = 0;
+        }
+        if (spacing_us_ > 0) {
+            next_write_us_ = done + spacing_us_;
+            break;
+        }
+    }
+    return sent;
+}
+
+void NotifyQueue::resetStats()
+{
+    stats_ = NotifyStats{0, 0, 0, 0, 0, 0, depth_};
+}
@@ -0,0 +1,76 @@
+#include "power_monitor.h"
+#include <Arduino.h>
+
+// advertising interval unit
+constexpr uint32_t INTERVAL_UNIT_US = 625;
+
+void PowerMonitor::begin(unsigned long now_us)
+{
+    window_start_ = last_us_ = now_us;
+}
+
+void PowerMonitor::sleep()
+{
+    unsigned long start = micros();
+    __WFI();
+    asleep_us_ += micros() - start;
+}
+
+void PowerMonitor::setLoadCell(bool on, unsigned long now_us)
+{
+    account(now_us);
+    load_cell_on_ = on;
+}
+
+void PowerMonitor::setAdvertising(uint16_t interval, unsigned long now_us)
+{
+    account(now_us);
+    interval_ = interval;
+}
+
+void PowerMonitor::addWake(unsigned long latency_us)
+{
+    wakes_++;
+    total_wake_us_ += latency_us;
+    if (latency_us > max_wake_us_) max_wake_us_ = latency_us;
+}
+
+void PowerMonitor::account(unsigned long now_us)
+{
+    unsigned long dt = now_us - last_us_;
+    last_us_ = now_us;
+    if (load_cell_on_) load_cell_us_ += dt;
+    // dt / interval events of ADVERTISING_EVENT_UC each
+    if (interval_ > 0) {
+        advertising_ += static_cast<uint64_t>(dt) * ADVERTISING_EVENT_UC * 1000000 / (interval_ * INTERVAL_UNIT_US);
+    }
+}
+
+PowerReport PowerMonitor::report(unsigned long now_us)
+{
+    account(now_us);
+    PowerReport r = {};
+    r.window_us = now_us - window_start_;
+    r.awake_us = asleep_us_ < r.window_us ? r.window_us - asleep_us_ : 0;
+    r.load_cell_us = load_cell_us_;
+    r.wakes = wakes_;
+    r.max_wake_us = max_wake_us_;
+    r.total_wake_us = total_wake_us_;
+    if (r.window_us > 0) {
+        uint64_t w = r.window_us;
+        uint64_t charge = static_cast<uint64_t>(r.awake_us) * MCU_RUN_UA +
+                          static_cast<uint64_t>(w - r.awake_us) * MCU_SLEEP_UA +
+                          static_cast<uint64_t>(r.load_cell_us) * LOAD_CELL_UA +
+                          static_cast<uint64_t>(w - r.load_cell_us) * LOAD_CELL_DOWN_UA;
+        r.current_ua = static_cast<uint32_t>((charge + advertising_) / w);
+    }
+
+    window_start_ = now_us;
+    asleep_us_ = 0;
+    load_cell_us_ = 0;
+    advertising_ = 0;
+    wakes_ = 0;
+    max_wake_us_ = 0;
+    total_wake_us_ = 0;
+    return r;
+}
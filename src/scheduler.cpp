@@ -0,0 +1,99 @@
+#include "scheduler.h"
+#include <Arduino.h>
+
+int Scheduler::add(const char *name, TaskFn fn, unsigned long period_us, unsigned long budget_us)
+{
+    if (count_ >= MAX_TASKS) return -1;
+    Task &t = tasks_[count_];
+    t.name = name;
+    t.fn = fn;
+    t.period = period_us;
+    t.budget = budget_us;
+    t.next_due = 0;
+    t.active = false;
+    t.stats = TaskStats{0, 0, 0, 0, 0};
+    return count_++;
+}
+
+int Scheduler::addPeriodic(const char *name, TaskFn fn, unsigned long period_us, unsigned long budget_us,
+                           unsigned long offset_us)
+{
+    int id = add(name, fn, period_us, budget_us);
+    if (id >= 0) start(id, offset_us);
+    return id;
+}
+
+int Scheduler::addOneShot(const char *name, TaskFn fn, unsigned long budget_us)
+{
+    return add(name, fn, 0, budget_us);
+}
+
+void Scheduler::start(int id, unsigned long delay_us)
+{
+    if (id < 0 || id >= count_) return;
+    tasks_[id].next_due = micros() + delay_us;
+    tasks_[id].active = true;
+}
+
+void Scheduler::stop(int id)
+{
+    if (id >= 0 && id < count_) tasks_[id].active = false;
+}
+
+bool Scheduler::isActive(int id) const
+{
+    return id >= 0 && id < count_ && tasks_[id].active;
+}
+
+void Scheduler::setPeriod(int id, unsigned long period_us)
+{
+    if (id >= 0 && id < count_ && period_us > 0) tasks_[id].period = period_us;
+}
+
+void Scheduler::run(unsigned long now)
+{
+    for (int i = 0; i < count_; i++) {
+        Task &t = tasks_[i];
+        if (!t.active || static_cast<long>(now - t.next_due) < 0) continue;
+
+        unsigned long late = now - t.next_due;
+        if (late > t.stats.max_late) t.stats.max_late = late;
+
+        if (t.period == 0) {
+            t.active = false;
+        } else {
+            unsigned long skipped = late / t.period;
+            t.stats.missed += skipped;
+            t.next_due += (skipped + 1) * t.period;
+        }
+
+        unsigned long start = micros();
+        t.fn();
+        unsigned long ran = micros() - start;
+
+        t.stats.runs++;
+        if (ran > t.stats.max_run) t.stats.max_run = ran;
+        if (ran > t.budget) t.stats.overruns++;
+
+        // a task may have re-armed itself or others; re-read the clock for the rest
+        now = micros();
+    }
+}
+
+unsigned long Scheduler::timeUntilNext(unsigned long now) const
+{
+    unsigned long best = 0xFFFFFFFFUL;
+    for (int i = 0; i < count_; i++) {
+        const Task &t = tasks_[i];
+        if (!t.active) continue;
+        long until = static_cast<long>(t.next_due - now);
+        if (until <= 0) return 0;
+        if (static_cast<unsigned long>(until) < best) best = until;
+    }
+    return best;
+}
+
+void Scheduler::resetStats()
+{
+    for (int i = 0; i < count_; i++) tasks_[i].stats = TaskStats{0, 0, 0, 0, 0};
+}
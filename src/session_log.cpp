@@ -0,0 +1,295 @@
+#include "session_log.h"
+#include "waveform_codec.h"
+#include <string.h>
+
+static uint32_t clampU32(float v) { return v <= 0 ? 0 : static_cast<uint32_t>(v + 0.5f); }
+
+bool SessionLog::mount()
+{
+    if (!flash_.begin()) return false;
+    block_size_ = flash_.blockSize();
+    blocks_ = flash_.size() / block_size_;
+    if (blocks_ > 255) blocks_ = 255;
+
+    // newest block by sequence number
+    has_active_ = false;
+    for (size_t b = 0; b < blocks_; b++) {
+        uint32_t seq;
+        if (!readHeader(b, seq)) continue;
+        if (!has_active_ || static_cast<int32_t>(seq - seq_) > 0) {
+            active_ = b;
+            seq_ = seq;
+            has_active_ = true;
+        }
+    }
+
+    records_ = 0;
+    next_session_ = 0;
+    valid_blocks_ = 0;
+    if (has_active_) {
+        // the blocks before it in the ring that carry the preceding sequence numbers
+        valid_blocks_ = 1;
+        while (valid_blocks_ < blocks_) {
+            uint32_t seq;
+            size_t b = (active_ + blocks_ - valid_blocks_) % blocks_;
+            if (!readHeader(b, seq) || seq != seq_ - valid_blocks_) break;
+            valid_blocks_++;
+        }
+        for (uint8_t age = 0; age < valid_blocks_; age++) {
+            size_t end = scanBlock(physicalBlock(age), true);
+            if (age == valid_blocks_ - 1) pos_ = end;
+        }
+        // a torn record leaves programmed bytes we can't append over
+        sealed_ = pos_ < block_size_ && !flash_.isBlank(active_ * block_size_ + pos_, block_size_ - pos_);
+    }
+    mounted_ = true;
+    return true;
+}
+
+bool SessionLog::readHeader(size_t block, uint32_t &seq)
+{
+    uint8_t h[HEADER_SIZE];
+    if (!flash_.read(block * block_size_, h, sizeof(h))) return false;
+    if ((h[0] | (h[1] << 8)) != MAGIC || h[2] != VERSION) return false;
+    if (crc8(h + 4, 4, crc8(h, 3)) != h[3]) return false;
+    seq = h[4] | (h[5] << 8) | (static_cast<uint32_t>(h[6]) << 16) | (static_cast<uint32_t>(h[7]) << 24);
+    return true;
+}
+
+bool SessionLog::readRecordAt(uint32_t address, size_t limit, Record &record)
+{
+    uint8_t head[2];
+    if (address + 4 > limit || !flash_.read(address, head, 2)) return false;
+    if (head[0] < SESSION_START || head[0] > SESSION_END || head[1] > MAX_PAYLOAD) return false;
+    if (address + head[1] + 4 > limit) return false;
+
+    uint8_t tail[2];
+    if (!flash_.read(address + 2, record.payload, head[1]) || !flash_.read(address + 2 + head[1], tail, 2)) return false;
+    if (tail[1] != COMMIT || crc8(record.payload, head[1], crc8(head, 2)) != tail[0]) return false;
+    record.type = head[0];
+    record.len = head[1];
+    return true;
+}
+
+size_t SessionLog::scanBlock(size_t block, bool count_sessions)
+{
+    uint32_t base = block * block_size_;
+    size_t offset = HEADER_SIZE;
+    Record record;
+    while (readRecordAt(base + offset, base + block_size_, record)) {
+        if (count_sessions) {
+            records_++;
+            uint32_t session;
+            if (record.type == SESSION_START && varintDecode(record.payload, record.len, session) > 0 &&
+                session >= next_session_) {
+                next_session_ = session + 1;
+            }
+        }
+        offset += record.len + 4;
+    }
+    return offset;
+}
+
+uint8_t SessionLog::physicalBlock(uint8_t age) const
+{
+    return (active_ + blocks_ - (valid_blocks_ - 1) + age) % blocks_;
+}
+
+bool SessionLog::next(Cursor &cursor, Record &record)
+{
+    while (cursor.age < valid_blocks_) {
+        uint32_t base = physicalBlock(cursor.age) * block_size_;
+        if (readRecordAt(base + cursor.offset, base + block_size_, record)) {
+            cursor.offset += record.len + 4;
+            return true;
+        }
+        cursor.age++;
+        cursor.offset = HEADER_SIZE;
+    }
+    return false;
+}
+
+bool SessionLog::enqueue(const Record &record)
+{
+    if (queued_ == QUEUE) {
+        dropped_++;
+        return false;
+    }
+    queue_[(head_ + queued_) % QUEUE] = record;
+    queued_++;
+    return true;
+}
+
+void SessionLog::startRecord(uint8_t type)
+{
+    building_.type = type;
+    building_.len = 0;
+}
+
+void SessionLog::putVarint(Record &record, uint32_t value)
+{
+    record.len += varintEncode(value, record.payload + record.len);
+}
+
+void SessionLog::flushCompressions()
+{
+    if (building_.len > 0) enqueue(building_);
+    startRecord(COMPRESSIONS);
+}
+
+void SessionLog::beginSession(unsigned long now)
+{
+    if (in_session_) endSession(now, Summary{0, 0, 0}, END_ABORTED);
+
+    session_ = next_session_++;
+    session_start_ = now;
+    last_press_ = now;
+    last_peak_ = 0;
+    session_compressions_ = 0;
+    in_session_ = true;
+
+    startRecord(SESSION_START);
+    putVarint(building_, session_);
+    putVarint(building_, now);
+    enqueue(building_);
+    startRecord(COMPRESSIONS);
+}
+
+void SessionLog::addCompression(const CompressionQuality &quality)
+{
+    if (!in_session_) return;
+
+    // five varints, at most 5 + 5 + 2 + 2 + 2 bytes
+    Record one;
+    one.len = 0;
+    int32_t peak = static_cast<int32_t>(clampU32(quality.peak_grams / 10.0f));
+    putVarint(one, quality.press_time - last_press_);
+    putVarint(one, zigzagEncode(peak - last_peak_));
+    putVarint(one, clampU32(quality.residual_grams / 100.0f));
+    putVarint(one, quality.duty_pct);
+    putVarint(one, quality.flags);
+
+    if (building_.len + one.len > MAX_PAYLOAD) flushCompressions();
+    memcpy(building_.payload + building_.len, one.payload, one.len);
+    building_.len += one.len;
+
+    last_press_ = quality.press_time;
+    last_peak_ = peak;
+    session_compressions_++;
+}
+
+void SessionLog::endSession(unsigned long now, const Summary &summary, uint8_t flags)
+{
+    if (!in_session_) return;
+    flushCompressions();
+
+    startRecord(SESSION_END);
+    putVarint(building_, session_);
+    putVarint(building_, now - session_start_);
+    putVarint(building_, session_compressions_);
+    putVarint(building_, clampU32(summary.avg_bpm * 10.0f));
+    putVarint(building_, clampU32(summary.accuracy * 100.0f));
+    putVarint(building_, clampU32(summary.consistency * 100.0f));
+    putVarint(building_, flags);
+    enqueue(building_);
+    startRecord(COMPRESSIONS);
+    in_session_ = false;
+}
+
+void SessionLog::pump()
+{
+    if (!mounted_ || consecutive_failures_ >= MAX_FAILURES || flash_.busy()) return;
+
+    uint32_t base = active_ * block_size_;
+    switch (step_) {
+    case STEP_IDLE: {
+        if (queued_ == 0) return;
+        const Record &record = queue_[head_];
+        if (!has_active_ || sealed_ || pos_ + record.len + 4 > block_size_) {
+            step_ = STEP_ERASE;
+            return;
+        }
+        out_[0] = record.type;
+        out_[1] = record.len;
+        memcpy(out_ + 2, record.payload, record.len);
+        out_[2 + record.len] = crc8(out_, 2 + record.len);
+        out_len_ = record.len + 3;
+        out_done_ = 0;
+        step_ = STEP_BODY;
+        return;
+    }
+
+    case STEP_ERASE: {
+        // the next block in the ring; once every block is used this drops the oldest
+        size_t target = has_active_ ? (active_ + 1) % blocks_ : 0;
+        if (!flash_.eraseBlock(target * block_size_)) {
+            failures_++;
+            consecutive_failures_++;
+            return;
+        }
+        if (has_active_ && valid_blocks_ == blocks_) valid_blocks_--;
+        target_ = target;
+        step_ = STEP_HEADER;
+        return;
+    }
+
+    case STEP_HEADER: {
+        uint8_t h[HEADER_SIZE];
+        uint32_t seq = seq_ + 1;
+        h[0] = MAGIC & 0xFF;
+        h[1] = MAGIC >> 8;
+        h[2] = VERSION;
+        h[4] = seq & 0xFF;
+        h[5] = (seq >> 8) & 0xFF;
+        h[6] = (seq >> 16) & 0xFF;
+        h[7] = (seq >> 24) & 0xFF;
+        h[3] = crc8(h + 4, 4, crc8(h, 3));
+        step_ = STEP_IDLE;
+        if (!flash_.program(target_ * block_size_, h, sizeof(h))) {
+            // the active block is unchanged, so the next pump erases the same target again
+            failures_++;
+            consecutive_failures_++;
+            return;
+        }
+        active_ = target_;
+        has_active_ = true;
+        seq_ = seq;
+        pos_ = HEADER_SIZE;
+        sealed_ = false;
+        valid_blocks_ = valid_blocks_ < blocks_ ? valid_blocks_ + 1 : blocks_;
+        return;
+    }
+
+    case STEP_BODY: {
+        size_t chunk = out_len_ - out_done_;
+        if (chunk > PUMP_CHUNK) chunk = PUMP_CHUNK;
+        if (!flash_.program(base + pos_ + out_done_, out_ + out_done_, chunk)) {
+            // whatever got programmed can't be reused; retry the record in a fresh block
+            failures_++;
+            consecutive_failures_++;
+            sealed_ = true;
+            step_ = STEP_IDLE;
+            return;
+        }
+        out_done_ += chunk;
+        if (out_done_ == out_len_) step_ = STEP_COMMIT;
+        return;
+    }
+
+    case STEP_COMMIT: {
+        step_ = STEP_IDLE;
+        if (!flash_.program(base + pos_ + out_len_, &COMMIT, 1)) {
+            failures_++;
+            consecutive_failures_++;
+            sealed_ = true;
+            return;
+        }
+        pos_ += out_len_ + 1;
+        head_ = (head_ + 1) % QUEUE;
+        queued_--;
+        records_++;
+        consecutive_failures_ = 0;
+        return;
+    }
+    }
+}
@@ -1,175 +1,141 @@
 #include "song_setup.h"
 
 
-// notes of the moledy followed by the duration.
-// a 4 means a quarter note, 8 an eighteenth , 16 sixteenth, so on
-// !!negative numbers are used to represent dotted notes,
-// so -4 means a dotted quarter note, that is, a quarter plus an eighteenth!!
-int tetris_melody[] = {
+// notes of the melody as NOTE/DIVIDER: 4 means a quarter note, 8 an eighth, 16 a sixteenth, so on.
+// A trailing '.' makes a dotted note, so "4." is a quarter plus an eighth.
+// Each song is compiled to two bytes per note at build time and stays in flash.
+constexpr auto tetris_melody = SONG(
 
   //Based on the arrangement at https://www.flutetunes.com/tunes.php?id=192
-  
-  NOTE_E5, 4,  NOTE_B4,8,  NOTE_C5,8,  NOTE_D5,4,  NOTE_C5,8,  NOTE_B4,8,
-  NOTE_A4, 4,  NOTE_A4,8,  NOTE_C5,8,  NOTE_E5,4,  NOTE_D5,8,  NOTE_C5,8,
-  NOTE_B4, -4,  NOTE_C5,8,  NOTE_D5,4,  NOTE_E5,4,
-  NOTE_C5, 4,  NOTE_A4,4,  NOTE_A4,4, REST,4,
 
-  REST,8, NOTE_D5, 4,  NOTE_F5,8,  NOTE_A5,4,  NOTE_G5,8,  NOTE_F5,8,
-  NOTE_E5, -4,  NOTE_C5,8,  NOTE_E5,4,  NOTE_D5,8,  NOTE_C5,8,
-  NOTE_B4, 4,  NOTE_B4,8,  NOTE_C5,8,  NOTE_D5,4,  NOTE_E5,4,
-  NOTE_C5, 4,  NOTE_A4,4,  NOTE_A4,4, REST, 4,
+  "E5/4 B4/8 C5/8 D5/4 C5/8 B4/8 "
+  "A4/4 A4/8 C5/8 E5/4 D5/8 C5/8 "
+  "B4/4. C5/8 D5/4 E5/4 "
+  "C5/4 A4/4 A4/4 R/4 "
 
-  NOTE_E5,2, NOTE_C5,2,
-  NOTE_D5,2, NOTE_B4,2,
-  NOTE_C5,2, NOTE_A4,2,
-  NOTE_B4,1,
+  "R/8 D5/4 F5/8 A5/4 G5/8 F5/8 "
+  "E5/4. C5/8 E5/4 D5/8 C5/8 "
+  "B4/4 B4/8 C5/8 D5/4 E5/4 "
+  "C5/4 A4/4 A4/4 R/4 "
 
-  NOTE_E5,2, NOTE_C5,2,
-  NOTE_D5,2, NOTE_B4,2,
-  NOTE_C5,4, NOTE_E5,4, NOTE_A5,2,
-  NOTE_GS5,1,
+  "E5/2 C5/2 "
+  "D5/2 B4/2 "
+  "C5/2 A4/2 "
+  "B4/1 "
 
-  NOTE_E5, 4,  NOTE_B4,8,  NOTE_C5,8,  NOTE_D5,4,  NOTE_C5,8,  NOTE_B4,8,
-  NOTE_A4, 4,  NOTE_A4,8,  NOTE_C5,8,  NOTE_E5,4,  NOTE_D5,8,  NOTE_C5,8,
-  NOTE_B4, -4,  NOTE_C5,8,  NOTE_D5,4,  NOTE_E5,4,
-  NOTE_C5, 4,  NOTE_A4,4,  NOTE_A4,4, REST,4,
+  "E5/2 C5/2 "
+  "D5/2 B4/2 "
+  "C5/4 E5/4 A5/2 "
+  "GS5/1 "
 
-  REST,8, NOTE_D5, 4,  NOTE_F5,8,  NOTE_A5,4,  NOTE_G5,8,  NOTE_F5,8,
-  REST,8, NOTE_E5, 4,  NOTE_C5,8,  NOTE_E5,4,  NOTE_D5,8,  NOTE_C5,8,
-  REST,8, NOTE_B4, 4,  NOTE_C5,8,  NOTE_D5,4,  NOTE_E5,4,
-  REST,8, NOTE_C5, 4,  NOTE_A4,8,  NOTE_A4,4, REST, 4,
+  "E5/4 B4/8 C5/8 D5/4 C5/8 B4/8 "
+  "A4/4 A4/8 C5/8 E5/4 D5/8 C5/8 "
+  "B4/4. C5/8 D5/4 E5/4 "
+  "C5/4 A4/4 A4/4 R/4 "
 
-};
+  "R/8 D5/4 F5/8 A5/4 G5/8 F5/8 "
+  "R/8 E5/4 C5/8 E5/4 D5/8 C5/8 "
+  "R/8 B4/4 C5/8 D5/4 E5/4 "
+  "R/8 C5/4 A4/8 A4/4 R/4 "
 
-int mario_melody[] = {
+);
+
+constexpr auto mario_melody = SONG(
 
   // Super Mario Bros theme
   // Score available at https://musescore.com/user/2123/scores/2145
   // Theme by Koji Kondo
-  
-  
-  NOTE_E5,8, NOTE_E5,8, REST,8, NOTE_E5,8, REST,8, NOTE_C5,8, NOTE_E5,8, //1
-  NOTE_G5,4, REST,4, NOTE_G4,8, REST,4, 
-  NOTE_C5,-4, NOTE_G4,8, REST,4, NOTE_E4,-4, // 3
-  NOTE_A4,4, NOTE_B4,4, NOTE_AS4,8, NOTE_A4,4,
-  NOTE_G4,-8, NOTE_E5,-8, NOTE_G5,-8, NOTE_A5,4, NOTE_F5,8, NOTE_G5,8,
-  REST,8, NOTE_E5,4,NOTE_C5,8, NOTE_D5,8, NOTE_B4,-4,
-  NOTE_C5,-4, NOTE_G4,8, REST,4, NOTE_E4,-4, // repeats from 3
-  NOTE_A4,4, NOTE_B4,4, NOTE_AS4,8, NOTE_A4,4,
-  NOTE_G4,-8, NOTE_E5,-8, NOTE_G5,-8, NOTE_A5,4, NOTE_F5,8, NOTE_G5,8,
-  REST,8, NOTE_E5,4,NOTE_C5,8, NOTE_D5,8, NOTE_B4,-4,
-
-  
-  REST,4, NOTE_G5,8, NOTE_FS5,8, NOTE_F5,8, NOTE_DS5,4, NOTE_E5,8,//7
-  REST,8, NOTE_GS4,8, NOTE_A4,8, NOTE_C4,8, REST,8, NOTE_A4,8, NOTE_C5,8, NOTE_D5,8,
-  REST,4, NOTE_DS5,4, REST,8, NOTE_D5,-4,
-  NOTE_C5,2, REST,2,
-
-  REST,4, NOTE_G5,8, NOTE_FS5,8, NOTE_F5,8, NOTE_DS5,4, NOTE_E5,8,//repeats from 7
-  REST,8, NOTE_GS4,8, NOTE_A4,8, NOTE_C4,8, REST,8, NOTE_A4,8, NOTE_C5,8, NOTE_D5,8,
-  REST,4, NOTE_DS5,4, REST,8, NOTE_D5,-4,
-  NOTE_C5,2, REST,2,
-
-  NOTE_C5,8, NOTE_C5,4, NOTE_C5,8, REST,8, NOTE_C5,8, NOTE_D5,4,//11
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2,
-
-  NOTE_C5,8, NOTE_C5,4, NOTE_C5,8, REST,8, NOTE_C5,8, NOTE_D5,8, NOTE_E5,8,//13
-  REST,1, 
-  NOTE_C5,8, NOTE_C5,4, NOTE_C5,8, REST,8, NOTE_C5,8, NOTE_D5,4,
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2,
-  NOTE_E5,8, NOTE_E5,8, REST,8, NOTE_E5,8, REST,8, NOTE_C5,8, NOTE_E5,4,
-  NOTE_G5,4, REST,4, NOTE_G4,4, REST,4, 
-  NOTE_C5,-4, NOTE_G4,8, REST,4, NOTE_E4,-4, // 19
-  
-  NOTE_A4,4, NOTE_B4,4, NOTE_AS4,8, NOTE_A4,4,
-  NOTE_G4,-8, NOTE_E5,-8, NOTE_G5,-8, NOTE_A5,4, NOTE_F5,8, NOTE_G5,8,
-  REST,8, NOTE_E5,4, NOTE_C5,8, NOTE_D5,8, NOTE_B4,-4,
-
-  NOTE_C5,-4, NOTE_G4,8, REST,4, NOTE_E4,-4, // repeats from 19
-  NOTE_A4,4, NOTE_B4,4, NOTE_AS4,8, NOTE_A4,4,
-  NOTE_G4,-8, NOTE_E5,-8, NOTE_G5,-8, NOTE_A5,4, NOTE_F5,8, NOTE_G5,8,
-  REST,8, NOTE_E5,4, NOTE_C5,8, NOTE_D5,8, NOTE_B4,-4,
-
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,//23
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_D5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_G5,-8, NOTE_F5,-8,
-  
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2, //26
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_B4,8, NOTE_F5,4, NOTE_F5,8, NOTE_F5,-8, NOTE_E5,-8, NOTE_D5,-8,
-  NOTE_C5,8, NOTE_E4,4, NOTE_E4,8, NOTE_C4,2,
-
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,//repeats from 23
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_D5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_G5,-8, NOTE_F5,-8,
-  
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2, //26
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_B4,8, NOTE_F5,4, NOTE_F5,8, NOTE_F5,-8, NOTE_E5,-8, NOTE_D5,-8,
-  NOTE_C5,8, NOTE_E4,4, NOTE_E4,8, NOTE_C4,2,
-  NOTE_C5,8, NOTE_C5,4, NOTE_C5,8, REST,8, NOTE_C5,8, NOTE_D5,8, NOTE_E5,8,
-  REST,1,
-
-  NOTE_C5,8, NOTE_C5,4, NOTE_C5,8, REST,8, NOTE_C5,8, NOTE_D5,4, //33
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2,
-  NOTE_E5,8, NOTE_E5,8, REST,8, NOTE_E5,8, REST,8, NOTE_C5,8, NOTE_E5,4,
-  NOTE_G5,4, REST,4, NOTE_G4,4, REST,4, 
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_D5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_A5,-8, NOTE_G5,-8, NOTE_F5,-8,
-  
-  NOTE_E5,8, NOTE_C5,4, NOTE_A4,8, NOTE_G4,2, //40
-  NOTE_E5,8, NOTE_C5,4, NOTE_G4,8, REST,4, NOTE_GS4,4,
-  NOTE_A4,8, NOTE_F5,4, NOTE_F5,8, NOTE_A4,2,
-  NOTE_B4,8, NOTE_F5,4, NOTE_F5,8, NOTE_F5,-8, NOTE_E5,-8, NOTE_D5,-8,
-  NOTE_C5,8, NOTE_E4,4, NOTE_E4,8, NOTE_C4,2,
-  
+
+
+  "E5/8 E5/8 R/8 E5/8 R/8 C5/8 E5/8 " //1
+  "G5/4 R/4 G4/8 R/4 "
+  "C5/4. G4/8 R/4 E4/4. " // 3
+  "A4/4 B4/4 AS4/8 A4/4 "
+  "G4/8. E5/8. G5/8. A5/4 F5/8 G5/8 "
+  "R/8 E5/4 C5/8 D5/8 B4/4. "
+  "C5/4. G4/8 R/4 E4/4. " // repeats from 3
+  "A4/4 B4/4 AS4/8 A4/4 "
+  "G4/8. E5/8. G5/8. A5/4 F5/8 G5/8 "
+  "R/8 E5/4 C5/8 D5/8 B4/4. "
+
+
+  "R/4 G5/8 FS5/8 F5/8 DS5/4 E5/8 " //7
+  "R/8 GS4/8 A4/8 C4/8 R/8 A4/8 C5/8 D5/8 "
+  "R/4 DS5/4 R/8 D5/4. "
+  "C5/2 R/2 "
+
+  "R/4 G5/8 FS5/8 F5/8 DS5/4 E5/8 " //repeats from 7
+  "R/8 GS4/8 A4/8 C4/8 R/8 A4/8 C5/8 D5/8 "
+  "R/4 DS5/4 R/8 D5/4. "
+  "C5/2 R/2 "
+
+  "C5/8 C5/4 C5/8 R/8 C5/8 D5/4 " //11
+  "E5/8 C5/4 A4/8 G4/2 "
+
+  "C5/8 C5/4 C5/8 R/8 C5/8 D5/8 E5/8 " //13
+  "R/1 "
+  "C5/8 C5/4 C5/8 R/8 C5/8 D5/4 "
+  "E5/8 C5/4 A4/8 G4/2 "
+  "E5/8 E5/8 R/8 E5/8 R/8 C5/8 E5/4 "
+  "G5/4 R/4 G4/4 R/4 "
+  "C5/4. G4/8 R/4 E4/4. " // 19
+
+  "A4/4 B4/4 AS4/8 A4/4 "
+  "G4/8. E5/8. G5/8. A5/4 F5/8 G5/8 "
+  "R/8 E5/4 C5/8 D5/8 B4/4. "
+
+  "C5/4. G4/8 R/4 E4/4. " // repeats from 19
+  "A4/4 B4/4 AS4/8 A4/4 "
+  "G4/8. E5/8. G5/8. A5/4 F5/8 G5/8 "
+  "R/8 E5/4 C5/8 D5/8 B4/4. "
+
+  "E5/8 C5/4 G4/8 R/4 GS4/4 " //23
+  "A4/8 F5/4 F5/8 A4/2 "
+  "D5/8. A5/8. A5/8. A5/8. G5/8. F5/8. "
+
+  "E5/8 C5/4 A4/8 G4/2 " //26
+  "E5/8 C5/4 G4/8 R/4 GS4/4 "
+  "A4/8 F5/4 F5/8 A4/2 "
+  "B4/8 F5/4 F5/8 F5/8. E5/8. D5/8. "
+  "C5/8 E4/4 E4/8 C4/2 "
+
+  "E5/8 C5/4 G4/8 R/4 GS4/4 " //repeats from 23
+  "A4/8 F5/4 F5/8 A4/2 "
+  "D5/8. A5/8. A5/8. A5/8. G5/8. F5/8. "
+
+  "E5/8 C5/4 A4/8 G4/2 " //26
+  "E5/8 C5/4 G4/8 R/4 GS4/4 "
+  "A4/8 F5/4 F5/8 A4/2 "
+  "B4/8 F5/4 F5/8 F5/8. E5/8. D5/8. "
+  "C5/8 E4/4 E4/8 C4/2 "
+  "C5/8 C5/4 C5/8 R/8 C5/8 D5/8 E5/8 "
+  "R/1 "
+
+  "C5/8 C5/4 C5/8 R/8 C5/8 D5/4 " //33
+  "E5/8 C5/4 A4/8 G4/2 "
+  "E5/8 E5/8 R/8 E5/8 R/8 C5/8 E5/4 "
+  "G5/4 R/4 G4/4 R/4 "
+  "E5/8 C5/4 G4/8 R/4 GS4/4 "
+  "A4/8 F5/4 F5/8 A4/2 "
+  "D5/8. A5/8. A5/8. A5/8. G5/8. F5/8. "
+
+  "E5/8 C5/4 A4/8 G4/2 " //40
+  "E5/8 C5/4 G4/8 R/4 GS4/4 "
+  "A4/8 F5/4 F5/8 A4/2 "
+  "B4/8 F5/4 F5/8 F5/8. E5/8. D5/8. "
+  "C5/8 E4/4 E4/8 C4/2 "
+
   //game over sound
-  NOTE_C5,-4, NOTE_G4,-4, NOTE_E4,4, //45
-  NOTE_A4,-8, NOTE_B4,-8, NOTE_A4,-8, NOTE_GS4,-8, NOTE_AS4,-8, NOTE_GS4,-8,
-  NOTE_G4,8, NOTE_D4,8, NOTE_E4,-2,  
+  "C5/4. G4/4. E4/4 " //45
+  "A4/8. B4/8. A4/8. GS4/8. AS4/8. GS4/8. "
+  "G4/8 D4/8 E4/2. "
 
-};
+);
 
-void speaker(const int SPEAKER_PIN, const int BPM, char song) {
-  // sizeof gives the number of bytes, each int value is composed of two bytes (16 bits)
-  // there are two values per note (pitch and duration), so for each note there are four bytes
-  int * melody;
-  int notes;
+int songNotes(char song, const PackedNote *&melody) {
   switch(song) {
-    case 1: melody = tetris_melody; notes=sizeof(tetris_melody)/sizeof(tetris_melody[0])/2; break;
-    case 2: melody = mario_melody; notes=sizeof(mario_melody)/sizeof(mario_melody[0])/2; break;
-    default: melody = mario_melody; notes=sizeof(mario_melody)/sizeof(mario_melody[0])/2; break;
-  }
-  // this calculates the duration of a whole note in ms (60s/tempo)*4 beats
-  int wholenote = (60000 * 4) / BPM;
-
-  int divider = 0, noteDuration = 0;
-
-  // iterate over the notes of the melody. 
-  // Remember, the array is twice the number of notes (notes + durations)
-  for (int thisNote = 0; thisNote < notes * 2; thisNote = thisNote + 2) {
-
-    // calculates the duration of each note
-    divider = melody[thisNote + 1];
-    if (divider > 0) {
-      // regular note, just proceed
-      noteDuration = (wholenote) / divider;
-    } else if (divider < 0) {
-      // dotted notes are represented with negative durations!!
-      noteDuration = (wholenote) / abs(divider);
-      noteDuration *= 1.5; // increases the duration in half for dotted notes
-    }
-
-    // we only play the note for 90% of the duration, leaving 10% as a pause
-    tone(SPEAKER_PIN, melody[thisNote], noteDuration*0.9);
-
-    // Wait for the specief duration before playing the next note.
-    delay(noteDuration);
-    
-    // stop the waveform generation before the next note.
-    noTone(SPEAKER_PIN);
+    case TETRIS_SONG: melody = tetris_melody.notes; return tetris_melody.size();
+    case MARIO_SONG: melody = mario_melody.notes; return mario_melody.size();
+    default: melody = mario_melody.notes; return mario_melody.size();
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,91 @@
+#include "telemetry.h"
+#include <string.h>
+
+static void putU16(uint8_t *p, uint32_t v)
+{
+    if (v > 0xFFFF) v = 0xFFFF;   // saturate rather than wrap
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static uint8_t toU8(float v)
+{
+    if (v <= 0) return 0;
+    return v >= 255.0f ? 255 : static_cast<uint8_t>(v + 0.5f);
+}
+
+static void putU32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+void TelemetryBatcher::setMtu(uint16_t mtu)
+{
+    if (mtu < MIN_MTU) mtu = MIN_MTU;
+    if (mtu > MAX_MTU) mtu = MAX_MTU;
+    mtu_ = mtu;
+    capacity_ = (mtu - 3 - HEADER_SIZE) / RECORD_SIZE;
+}
+
+void TelemetryBatcher::add(const CompressionQuality &quality, unsigned long now)
+{
+    // the caller should have flushed; if it couldn't, the oldest batch goes
+    if (count_ >= sizeof(records_) / RECORD_SIZE) discard();
+
+    if (count_ == 0) {
+        base_ms_ = quality.press_time;
+        last_press_ = quality.press_time;
+        first_added_ = now;
+    }
+
+    uint8_t *r = records_ + count_ * RECORD_SIZE;
+    putU16(r, quality.press_time - last_press_);
+    putU16(r + 2, quality.peak_grams > 0 ? static_cast<uint32_t>(quality.peak_grams / 10.0f + 0.5f) : 0);
+    r[4] = toU8(quality.time_to_peak_ms / 4.0f);
+    r[5] = toU8(quality.press_ms / 4.0f);
+    r[6] = toU8(quality.release_ms / 4.0f);
+    putU16(r + 7, quality.interval_ms ? (600000UL + quality.interval_ms / 2) / quality.interval_ms : 0);
+    r[9] = toU8(quality.residual_grams / 100.0f);
+    r[10] = quality.duty_pct;
+    r[11] = quality.flags;
+    last_press_ = quality.press_time;
+    count_++;
+}
+
+bool TelemetryBatcher::ready(unsigned long now) const
+{
+    return count_ > 0 && (count_ >= capacity_ || now - first_added_ >= TIMEOUT_MS);
+}
+
+size_t TelemetryBatcher::flush(uint8_t *out)
+{
+    // never more than the current MTU allows; the rest stays for the next packet
+    size_t n = count_ < capacity_ ? count_ : capacity_;
+    putU16(out, seq_);
+    out[2] = VERSION;
+    out[3] = static_cast<uint8_t>(n);
+    putU32(out + 4, base_ms_);
+    memcpy(out + HEADER_SIZE, records_, n * RECORD_SIZE);
+    seq_++;
+
+    // re-base what is left: its first dt becomes 0 and base_ms its press time
+    if (n < count_) {
+        unsigned long press = base_ms_;
+        for (size_t i = 0; i <= n; i++) press += records_[i * RECORD_SIZE] | (records_[i * RECORD_SIZE + 1] << 8);
+        memmove(records_, records_ + n * RECORD_SIZE, (count_ - n) * RECORD_SIZE);
+        records_[0] = 0;
+        records_[1] = 0;
+        base_ms_ = press;
+    }
+    count_ -= n;
+    return HEADER_SIZE + n * RECORD_SIZE;
+}
+
+void TelemetryBatcher::discard()
+{
+    dropped_ += count_;
+    count_ = 0;
+}
@@ -0,0 +1,119 @@
+#include "test_accumulator.h"
+#include "bpm_helper.h"
+#include <string.h>
+
+static void putU16(uint8_t *p, float v)
+{
+    uint32_t u = v <= 0 ? 0 : v >= 65535.0f ? 65535 : static_cast<uint32_t>(v + 0.5f);
+    p[0] = u & 0xFF;
+    p[1] = (u >> 8) & 0xFF;
+}
+
+static uint8_t toPct(float fraction)
+{
+    if (fraction <= 0) return 0;
+    return fraction >= 1.0f ? 100 : static_cast<uint8_t>(fraction * 100.0f + 0.5f);
+}
+
+size_t encodeTestResult(const TestSummary &summary, uint8_t *out)
+{
+    out[0] = TEST_RESULT_VERSION;
+    putU16(out + 1, summary.compressions);
+    putU16(out + 3, summary.duration_ms / 1000.0f);
+    putU16(out + 5, summary.mean_bpm * 10.0f);
+    putU16(out + 7, summary.sd_bpm * 10.0f);
+    putU16(out + 9, summary.p10_bpm * 10.0f);
+    putU16(out + 11, summary.p50_bpm * 10.0f);
+    putU16(out + 13, summary.p90_bpm * 10.0f);
+    out[15] = toPct(summary.in_band);
+    out[16] = toPct(summary.accuracy);
+    out[17] = toPct(summary.consistency);
+    out[18] = summary.pauses > 255 ? 255 : summary.pauses;
+    out[19] = summary.flags;
+    return TEST_RESULT_SIZE;
+}
+
+void TestAccumulator::reset(unsigned long start_ms)
+{
+    start_ms_ = start_ms;
+    last_press_ = 0;
+    compressions_ = 0;
+    intervals_ = 0;
+    mean_ = 0.0f;
+    m2_ = 0.0f;
+    span_ms_ = 0;
+    in_band_ms_ = 0;
+    pauses_ = 0;
+    flags_ = 0;
+    memset(bins_, 0, sizeof(bins_));
+}
+
+void TestAccumulator::addPress(unsigned long press_time)
+{
+    unsigned long interval = press_time - last_press_;
+    bool first = compressions_++ == 0;
+    last_press_ = press_time;
+    if (first || interval == 0) return;
+
+    span_ms_ += interval;
+    if (interval > PAUSE_MS) {
+        if (pauses_ < 0xFFFF) pauses_++;
+        return;
+    }
+
+    float bpm = 60000.0f / interval;
+    if (bpm >= MIN_BPM && bpm <= MAX_BPM) in_band_ms_ += interval;
+
+    intervals_++;
+    float delta = bpm - mean_;
+    mean_ += delta / intervals_;
+    m2_ += delta * (bpm - mean_);
+
+    size_t bin = 0;
+    if (interval >= HIST_MIN_MS) bin = (interval - HIST_MIN_MS) / BIN_MS;
+    if (interval < HIST_MIN_MS || bin >= BINS) {
+        flags_ |= TestSummary::CLIPPED;
+        if (bin >= BINS) bin = BINS - 1;
+    }
+    if (bins_[bin] < 0xFFFF) bins_[bin]++;
+}
+
+float TestAccumulator::intervalPercentile(float q) const
+{
+    unsigned long total = 0;
+    for (size_t i = 0; i < BINS; i++) total += bins_[i];
+    if (total == 0) return 0.0f;
+
+    // linear inside the bin that holds the q-th interval
+    float target = q * total;
+    unsigned long below = 0;
+    for (size_t i = 0; i < BINS; i++) {
+        if (bins_[i] > 0 && below + bins_[i] >= target) {
+            float within = (target - below) / bins_[i];
+            return HIST_MIN_MS + (i + within) * BIN_MS;
+        }
+        below += bins_[i];
+    }
+    return HIST_MIN_MS + BINS * BIN_MS;
+}
+
+TestSummary TestAccumulator::summary(unsigned long now) const
+{
+    TestSummary s = {};
+    s.compressions = compressions_;
+    s.duration_ms = now - start_ms_;
+    s.pauses = pauses_;
+    s.flags = flags_;
+    if (span_ms_ > 0) s.in_band = static_cast<float>(in_band_ms_) / span_ms_;
+    if (intervals_ == 0) return s;
+
+    s.mean_bpm = mean_;
+    s.sd_bpm = m2_ > 0.0f ? sqrtf(m2_ / intervals_) : 0.0f;
+    // a fast rate is a short interval: the 10th BPM percentile is the 90th interval one
+    s.p10_bpm = 60000.0f / intervalPercentile(0.9f);
+    s.p50_bpm = 60000.0f / intervalPercentile(0.5f);
+    s.p90_bpm = 60000.0f / intervalPercentile(0.1f);
+    s.accuracy = max(0.0f, 1.0f - fabsf(s.mean_bpm - TARGET_BPM) / TARGET_BPM);
+    s.consistency = max(0.0f, 1.0f - s.sd_bpm / MAX_STD_DEV);
+    return s;
+}
@@ -0,0 +1,108 @@
+#include "waveform_codec.h"
+#include <string.h>
+
+size_t varintEncode(uint32_t v, uint8_t *out)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+size_t varintDecode(const uint8_t *in, size_t len, uint32_t &v)
+{
+    v = 0;
+    for (size_t i = 0; i < len && i < WAVEFORM_MAX_VARINT; i++) {
+        v |= static_cast<uint32_t>(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) return i + 1;
+    }
+    return 0;
+}
+
+void WaveformEncoder::setCapacity(size_t capacity)
+{
+    if (capacity > MAX_FRAME) capacity = MAX_FRAME;
+    // room for at least one worst-case sample
+    if (capacity < WAVEFORM_HEADER_SIZE + WAVEFORM_MAX_VARINT) capacity = WAVEFORM_HEADER_SIZE + WAVEFORM_MAX_VARINT;
+    capacity_ = capacity;
+}
+
+bool WaveformEncoder::add(int32_t grams, unsigned long timestamp)
+{
+    if (count_ == 255) return false;
+    uint8_t coded[WAVEFORM_MAX_VARINT];
+    size_t n = varintEncode(zigzagEncode(count_ == 0 ? grams : grams - last_), coded);
+    if (WAVEFORM_HEADER_SIZE + used_ + n > capacity_) return false;
+
+    memcpy(payload_ + used_, coded, n);
+    used_ += n;
+    if (count_ == 0) t0_ = timestamp;
+    t_last_ = timestamp;
+    last_ = grams;
+    count_++;
+    return true;
+}
+
+size_t WaveformEncoder::flush(uint8_t *out)
+{
+    unsigned long period_x10 = count_ > 1 ? (t_last_ - t0_) * 10 / (count_ - 1) : 0;
+    if (period_x10 > 0xFFFF) period_x10 = 0xFFFF;
+
+    out[0] = seq_ & 0xFF;
+    out[1] = seq_ >> 8;
+    out[2] = WAVEFORM_VERSION;
+    out[3] = static_cast<uint8_t>(count_);
+    out[4] = t0_ & 0xFF;
+    out[5] = (t0_ >> 8) & 0xFF;
+    out[6] = (t0_ >> 16) & 0xFF;
+    out[7] = (t0_ >> 24) & 0xFF;
+    out[8] = period_x10 & 0xFF;
+    out[9] = period_x10 >> 8;
+    memcpy(out + WAVEFORM_HEADER_SIZE, payload_, used_);
+
+    size_t len = WAVEFORM_HEADER_SIZE + used_;
+    seq_++;
+    used_ = 0;
+    count_ = 0;
+    return len;
+}
+
+int WaveformDecoder::decode(const uint8_t *frame, size_t len, int32_t *out, size_t max_samples, WaveformFrame &info)
+{
+    if (len < WAVEFORM_HEADER_SIZE || frame[2] != WAVEFORM_VERSION) return -1;
+    info.seq = frame[0] | (frame[1] << 8);
+    info.count = frame[3];
+    info.t0 = frame[4] | (frame[5] << 8) | (frame[6] << 16) | (static_cast<unsigned long>(frame[7]) << 24);
+    info.period_ms = (frame[8] | (frame[9] << 8)) / 10.0f;
+    if (info.count > max_samples) return -1;
+
+    size_t at = WAVEFORM_HEADER_SIZE;
+    int32_t value = 0;
+    for (size_t i = 0; i < info.count; i++) {
+        uint32_t coded;
+        size_t n = varintDecode(frame + at, len - at, coded);
+        if (n == 0) return -1;
+        at += n;
+        value = i == 0 ? zigzagDecode(coded) : value + zigzagDecode(coded);
+        out[i] = value;
+    }
+    if (at != len) return -1;
+
+    // a gap in the sequence means frames were lost on the way
+    if (started_) lost_ += static_cast<uint16_t>(info.seq - expected_);
+    started_ = true;
+    expected_ = info.seq + 1;
+    frames_++;
+    return info.count;
+}
+
+void WaveformDecoder::reset()
+{
+    started_ = false;
+    expected_ = 0;
+    frames_ = 0;
+    lost_ = 0;
+}
@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <random>
+#include <vector>
+#include "bpm_helper.h"
+
+// The vector implementations computeBpmStats() replaced, as they were
+namespace reference {
+
+float calculateBPMStandardDeviation(const std::vector<unsigned long>& times, int last_n = 5) {
+    int size = times.size();
+    if (size < 2) return 0.0;
+
+    std::vector<float> bpms;
+    for (int i = std::max(1, size - last_n); i < size; i++) {
+        float interval = times[i] - times[i - 1];
+        if (interval > 0) {
+            bpms.push_back(60000.0 / interval);
+        }
+    }
+
+    float mean = 0.0;
+    for (float bpm : bpms) mean += bpm;
+    mean /= bpms.size();
+
+    float variance = 0.0;
+    for (float bpm : bpms) variance += (bpm - mean) * (bpm - mean);
+    variance /= bpms.size();
+
+    return sqrt(variance);
+}
+
+float calculateWeightedAverageBPM(const std::vector<unsigned long>& times, int last_n = 5) {
+    int size = times.size();
+    if (size < 2) return 0.0;
+
+    std::vector<float> bpms;
+    for (int i = std::max(1, size - last_n); i < size; i++) {
+        float interval = times[i] - times[i - 1];
+        if (interval > 0) {
+            bpms.push_back(60000.0 / interval);
+        }
+    }
+
+    float total_weight = 0.0;
+    float weighted_sum = 0.0;
+    for (size_t i = 0; i < bpms.size(); i++) {
+        float weight = static_cast<float>(i + 1) / bpms.size();
+        weighted_sum += bpms[i] * weight;
+        total_weight += weight;
+    }
+
+    return weighted_sum / total_weight;
+}
+
+bool isConsistentCompression(const std::vector<unsigned long>& times) {
+    if (times.size() < 2) return false;
+    float std_dev = calculateBPMStandardDeviation(times);
+    float consistency = 1.0 - (std_dev / MAX_STD_DEV);
+    return (consistency >= MIN_CONSISTENCY);
+}
+
+}
+
+// observed worst case over the random spans is 3.3e-7 relative / 1.3e-4 BPM
+constexpr float MEAN_TOLERANCE = 1e-5f;   // relative
+constexpr float STD_DEV_TOLERANCE = 1e-3f;   // BPM
+
+void setUp() {}
+void tearDown() {}
+
+static void checkAgainstReference(const std::vector<unsigned long>& times, int last_n)
+{
+    BpmStats stats = computeBpmStats(times, last_n);
+    float mean = reference::calculateWeightedAverageBPM(times, last_n);
+    float std_dev = reference::calculateBPMStandardDeviation(times, last_n);
+    TEST_ASSERT_FLOAT_WITHIN(MEAN_TOLERANCE * mean, mean, stats.weighted_mean);
+    TEST_ASSERT_FLOAT_WITHIN(STD_DEV_TOLERANCE, std_dev, stats.std_dev);
+
+    // the verdict, unless the two land on either side of the threshold by rounding
+    float consistency = 1.0f - std_dev / MAX_STD_DEV;
+    if (fabs(consistency - MIN_CONSISTENCY) > STD_DEV_TOLERANCE / MAX_STD_DEV) {
+        TEST_ASSERT_EQUAL(consistency >= MIN_CONSISTENCY, stats.consistent);
+    }
+    if (last_n == BPM_WINDOW) {
+        TEST_ASSERT_EQUAL(reference::isConsistentCompression(times), isConsistentCompression(times));
+    }
+}
+
+void test_random_spans_match_reference()
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> length(2, 20);
+    std::uniform_int_distribution<int> window(1, 12);
+    std::uniform_int_distribution<unsigned long> interval(300, 900);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    for (int n = 0; n < 20000; n++) {
+        std::vector<unsigned long> times;
+        unsigned long t = 1000 + rng() % 100000;
+        int size = length(rng);
+        for (int i = 0; i < size; i++) {
+            times.push_back(t);
+            // one interval in ten is a repeated timestamp
+            if (percent(rng) >= 10) t += interval(rng);
+        }
+        int last_n = window(rng);
+        // the reference divides 0 by 0 when every interval in the window is zero
+        if (computeBpmStats(times, last_n).count == 0) continue;
+        checkAgainstReference(times, last_n);
+    }
+}
+
+void test_fewer_than_two_times()
+{
+    std::vector<unsigned long> times;
+    for (int size = 0; size < 2; size++) {
+        BpmStats stats = computeBpmStats(times);
+        TEST_ASSERT_EQUAL(0, stats.count);
+        TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.weighted_mean);
+        TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.std_dev);
+        TEST_ASSERT_FALSE(stats.consistent);
+        TEST_ASSERT_EQUAL_FLOAT(reference::calculateWeightedAverageBPM(times), stats.weighted_mean);
+        TEST_ASSERT_EQUAL_FLOAT(reference::calculateBPMStandardDeviation(times), stats.std_dev);
+        TEST_ASSERT_FALSE(isConsistentCompression(times));
+        times.push_back(1000);
+    }
+}
+
+void test_zero_intervals_are_skipped()
+{
+    std::vector<unsigned long> times = {1000, 1000, 1600, 1600, 2200, 2800};
+    BpmStats stats = computeBpmStats(times, 5);
+    TEST_ASSERT_EQUAL(3, stats.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 100.0f, stats.weighted_mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, stats.std_dev);
+    TEST_ASSERT_EQUAL(600, stats.min_interval);
+    TEST_ASSERT_EQUAL(600, stats.max_interval);
+    checkAgainstReference(times, 5);
+}
+
+void test_only_zero_intervals()
+{
+    // the reference returns NaN here; the kernel reports no intervals
+    std::vector<unsigned long> times = {1000, 1000, 1000};
+    BpmStats stats = computeBpmStats(times);
+    TEST_ASSERT_EQUAL(0, stats.count);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.weighted_mean);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.std_dev);
+    TEST_ASSERT_FALSE(stats.consistent);
+}
+
+void test_last_n_larger_than_size()
+{
+    std::vector<unsigned long> times = {1000, 1550, 2150, 2700};
+    BpmStats all = computeBpmStats(times, 3);
+    BpmStats wide = computeBpmStats(times, 50);
+    TEST_ASSERT_EQUAL(3, wide.count);
+    TEST_ASSERT_EQUAL_FLOAT(all.weighted_mean, wide.weighted_mean);
+    TEST_ASSERT_EQUAL_FLOAT(all.std_dev, wide.std_dev);
+    TEST_ASSERT_EQUAL(550, wide.min_interval);
+    TEST_ASSERT_EQUAL(600, wide.max_interval);
+    checkAgainstReference(times, 50);
+}
+
+void test_history_matches_reference()
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<unsigned long> interval(300, 900);
+    CompressionTimes history;
+    std::vector<unsigned long> times;
+    unsigned long t = 5000;
+    for (int n = 0; n < 500; n++) {
+        history.push_back(t);
+        times.push_back(t);
+        if (times.size() > SAMPLE_SIZE) times.erase(times.begin());
+        t += interval(rng);
+        if (times.size() < 2) continue;
+
+        for (int last_n : {BPM_WINDOW, SAMPLE_SIZE}) {
+            BpmStats stats = computeBpmStats(history, last_n);
+            float mean = reference::calculateWeightedAverageBPM(times, last_n);
+            TEST_ASSERT_FLOAT_WITHIN(MEAN_TOLERANCE * mean, mean, stats.weighted_mean);
+            TEST_ASSERT_FLOAT_WITHIN(STD_DEV_TOLERANCE, reference::calculateBPMStandardDeviation(times, last_n),
+                                     stats.std_dev);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_random_spans_match_reference);
+    RUN_TEST(test_fewer_than_two_times);
+    RUN_TEST(test_zero_intervals_are_skipped);
+    RUN_TEST(test_only_zero_intervals);
+    RUN_TEST(test_last_n_larger_than_size);
+    RUN_TEST(test_history_matches_reference);
+    return UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <math.h>
+#include <random>
+#include "calibration_fit.h"
+
+void setUp() {}
+void tearDown() {}
+
+// The cell the points come from: grams = gain * d + curve * d^2, d = raw - offset
+struct Cell {
+    int32_t offset;
+    double gain;
+    double curve;
+
+    double rawFor(double grams) const
+    {
+        if (curve == 0.0) return offset + grams / gain;
+        return offset + (-gain + sqrt(gain * gain + 4.0 * curve * grams)) / (2.0 * curve);
+    }
+};
+
+constexpr float GAIN = 0.0095f;   // grams per count, the driver's default
+
+// One weight on the cell until capture() decides, with noise_counts of gaussian noise
+static CalibrationFit::Capture capturePoint(CalibrationFit &fit, const Cell &cell, float grams, double noise_counts,
+                                            std::mt19937 &rng)
+{
+    std::normal_distribution<double> noise(0.0, noise_counts);
+    TEST_ASSERT_TRUE(fit.capture(grams, GAIN));
+    CalibrationFit::Capture result = CalibrationFit::CAPTURING;
+    for (int i = 0; i < CalibrationFit::SAMPLES * CalibrationFit::MAX_TRIES; i++) {
+        result = fit.add(static_cast<int32_t>(lround(cell.rawFor(grams) + noise(rng))));
+        if (result != CalibrationFit::CAPTURING) break;
+    }
+    return result;
+}
+
+// The residual fit() should report for its own result, from the noise-free
+// reading of each weight on the cell and the weight it was entered as
+static float residual(const Cell &cell, const float *on_cell, const float *entered, int n,
+                      const LoadCellCalibration &c)
+{
+    double sq = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = lround(cell.rawFor(on_cell[i])) - c.offset;
+        double e = c.gain * d + c.curve * d * d - entered[i];
+        sq += e * e;
+    }
+    return static_cast<float>(sqrt(sq / n));
+}
+
+// No point at 0 g, so the zero crossing has to come from the fit
+const float WEIGHTS[] = {2000.0f, 5000.0f, 10000.0f, 15000.0f, 20000.0f};
+constexpr int N = sizeof(WEIGHTS) / sizeof(WEIGHTS[0]);
+
+void test_linear_cell()
+{
+    Cell cell = {84000, GAIN, 0.0};
+    std::mt19937 rng(1);
+    CalibrationFit fit;
+    for (float g : WEIGHTS) TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(fit, cell, g, 20.0, rng));
+    TEST_ASSERT_EQUAL(N, fit.points());
+
+    LoadCellCalibration c;
+    float rms;
+    TEST_ASSERT_TRUE(fit.fit(c, rms));
+    TEST_ASSERT_INT_WITHIN(5, cell.offset, c.offset);
+    TEST_ASSERT_FLOAT_WITHIN(GAIN * 1e-3f, GAIN, c.gain);
+    // 1e-12 is under a gram at the top of the range
+    TEST_ASSERT_FLOAT_WITHIN(1e-12f, 0.0f, c.curve);
+    // the averaged noise is all that is left: 20 counts / sqrt(80) is 0.02 g
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, rms);
+}
+
+void test_quadratic_cell()
+{
+    // 4% low at 20 kg, like an overloaded beam
+    Cell cell = {-120000, GAIN, -2e-10};
+    std::mt19937 rng(2);
+    CalibrationFit fit;
+    for (float g : WEIGHTS) TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(fit, cell, g, 20.0, rng));
+
+    LoadCellCalibration c;
+    float rms;
+    TEST_ASSERT_TRUE(fit.fit(c, rms));
+    TEST_ASSERT_INT_WITHIN(5, cell.offset, c.offset);
+    TEST_ASSERT_FLOAT_WITHIN(GAIN * 1e-3f, GAIN, c.gain);
+    TEST_ASSERT_FLOAT_WITHIN(2e-12f, -2e-10f, c.curve);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, rms);
+
+    // two weights only: a straight line through both
+    CalibrationFit line;
+    const float two[] = {5000.0f, 20000.0f, 20000.0f};
+    for (float g : two) TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(line, cell, g, 20.0, rng));
+    TEST_ASSERT_TRUE(line.fit(c, rms));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, c.curve);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, rms);
+    for (float g : two) TEST_ASSERT_FLOAT_WITHIN(0.5f, g, c.gain * (cell.rawFor(g) - c.offset));
+}
+
+void test_mislabelled_weight_shows_in_residual()
+{
+    Cell cell = {84000, GAIN, 0.0};
+    std::mt19937 rng(3);
+    CalibrationFit fit;
+    for (int i = 0; i < N; i++) {
+        // 10 kg on the cell, entered as 10.5 kg
+        float g = WEIGHTS[i];
+        TEST_ASSERT_TRUE(fit.capture(i == 2 ? g + 500.0f : g, GAIN));
+        CalibrationFit::Capture result = CalibrationFit::CAPTURING;
+        while (result == CalibrationFit::CAPTURING) result = fit.add(static_cast<int32_t>(lround(cell.rawFor(g))));
+        TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, result);
+    }
+    LoadCellCalibration c;
+    float rms;
+    TEST_ASSERT_TRUE(fit.fit(c, rms));
+    TEST_ASSERT_GREATER_THAN_FLOAT(50.0f, rms);
+    const float labelled[] = {2000.0f, 5000.0f, 10500.0f, 15000.0f, 20000.0f};
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, residual(cell, WEIGHTS, labelled, N, c), rms);
+}
+
+void test_folding_curve_is_rejected()
+{
+    // the slope goes to zero at 1.5x the calibrated range: inside the 2x margin
+    double span = Cell{0, GAIN, 0.0}.rawFor(20000.0f);
+    Cell folding = {0, GAIN, -GAIN / (3.0 * span)};
+    // and at 3x, outside it
+    Cell bending = {0, GAIN, -GAIN / (6.0 * span)};
+    const float weights[] = {0.0f, 4000.0f, 8000.0f, 12000.0f};
+    std::mt19937 rng(4);
+
+    CalibrationFit fit;
+    for (float g : weights) TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(fit, folding, g, 5.0, rng));
+    LoadCellCalibration c = {1, 2.0f, 3.0f};
+    float rms = -1.0f;
+    TEST_ASSERT_FALSE(fit.fit(c, rms));
+    // nothing half-written
+    TEST_ASSERT_EQUAL_INT32(1, c.offset);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, rms);
+
+    fit.reset();
+    for (float g : weights) TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(fit, bending, g, 5.0, rng));
+    TEST_ASSERT_TRUE(fit.fit(c, rms));
+    TEST_ASSERT_FLOAT_WITHIN(fabs(bending.curve) * 0.02, bending.curve, c.curve);
+}
+
+void test_swinging_weight_is_retaken()
+{
+    Cell cell = {84000, GAIN, 0.0};
+    std::mt19937 rng(5);
+    CalibrationFit fit;
+    // 3x STILL_GRAMS of swing never settles
+    double swing = 3.0 * CalibrationFit::STILL_GRAMS / GAIN;
+    TEST_ASSERT_EQUAL(CalibrationFit::UNSTEADY, capturePoint(fit, cell, 5000.0f, swing, rng));
+    TEST_ASSERT_EQUAL(0, fit.points());
+
+    // one swinging window, then still: the next window is taken
+    TEST_ASSERT_TRUE(fit.capture(5000.0f, GAIN));
+    std::normal_distribution<double> noise(0.0, swing);
+    for (int i = 0; i < CalibrationFit::SAMPLES; i++) {
+        int32_t raw = static_cast<int32_t>(cell.rawFor(5000.0) + noise(rng));
+        TEST_ASSERT_EQUAL(CalibrationFit::CAPTURING, fit.add(raw));
+    }
+    CalibrationFit::Capture result = CalibrationFit::CAPTURING;
+    for (int i = 0; i < CalibrationFit::SAMPLES && result == CalibrationFit::CAPTURING; i++) {
+        result = fit.add(static_cast<int32_t>(cell.rawFor(5000.0)));
+    }
+    TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, result);
+    TEST_ASSERT_EQUAL(1, fit.points());
+}
+
+void test_one_weight_is_not_enough()
+{
+    Cell cell = {84000, GAIN, 0.0};
+    std::mt19937 rng(6);
+    CalibrationFit fit;
+    LoadCellCalibration c;
+    float rms;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(CalibrationFit::CAPTURED, capturePoint(fit, cell, 10000.0f, 20.0, rng));
+        TEST_ASSERT_FALSE(fit.fit(c, rms));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_linear_cell);
+    RUN_TEST(test_quadratic_cell);
+    RUN_TEST(test_mislabelled_weight_shows_in_residual);
+    RUN_TEST(test_folding_curve_is_rejected);
+    RUN_TEST(test_swinging_weight_is_retaken);
+    RUN_TEST(test_one_weight_is_not_enough);
+    return UNITY_END();
+}
@@ -0,0 +1,115 @@
+#include <unity.h>
+#include "calibration_store.h"
+
+void setUp() {}
+void tearDown() {}
+
+constexpr size_t BLOCK = 256;
+constexpr size_t SLOTS = BLOCK / CalibrationStore::SLOT_SIZE;
+// everything up to the CRC, then the commit byte on its own
+constexpr long SLOT_BODY = CalibrationStore::HEADER_SIZE + CalibrationStore::PAYLOAD_SIZE + 1;
+
+static LoadCellCalibration calibration(int n)
+{
+    return LoadCellCalibration{-120000 + 1000 * n, 0.0095f + 0.0001f * n, n % 2 ? 1e-9f * n : 0.0f};
+}
+
+// What a store mounted after a reset loads
+static void checkLoads(RamFlashStore &flash, int n)
+{
+    CalibrationStore store(flash);
+    LoadCellCalibration loaded;
+    TEST_ASSERT_TRUE(store.load(loaded));
+    LoadCellCalibration expected = calibration(n);
+    TEST_ASSERT_EQUAL_INT32(expected.offset, loaded.offset);
+    TEST_ASSERT_EQUAL_FLOAT(expected.gain, loaded.gain);
+    TEST_ASSERT_EQUAL_FLOAT(expected.curve, loaded.curve);
+}
+
+void test_empty_block_has_no_calibration()
+{
+    static uint8_t memory[BLOCK];
+    RamFlashStore flash(memory, BLOCK, BLOCK);
+    CalibrationStore store(flash);
+    LoadCellCalibration loaded;
+    TEST_ASSERT_FALSE(store.load(loaded));
+}
+
+void test_newest_save_wins()
+{
+    static uint8_t memory[BLOCK];
+    RamFlashStore flash(memory, BLOCK, BLOCK);
+    CalibrationStore store(flash);
+    for (int n = 0; n < 3; n++) {
+        TEST_ASSERT_TRUE(store.save(calibration(n)));
+        checkLoads(flash, n);
+    }
+}
+
+void test_torn_save_falls_back_to_previous_slot()
+{
+    // power fails after each possible number of bytes of the third save
+    for (long cut = 0; cut <= SLOT_BODY + 1; cut++) {
+        static uint8_t memory[BLOCK];
+        RamFlashStore flash(memory, BLOCK, BLOCK);
+        {
+            CalibrationStore store(flash);
+            TEST_ASSERT_TRUE(store.save(calibration(0)));
+            TEST_ASSERT_TRUE(store.save(calibration(1)));
+            flash.powerCutAfter(cut);
+            TEST_ASSERT_EQUAL(cut > SLOT_BODY, store.save(calibration(2)));
+            flash.powerCutAfter(-1);
+        }
+        bool committed = cut > SLOT_BODY;
+        checkLoads(flash, committed ? 2 : 1);
+
+        // the next save after the reset steps over the torn slot
+        CalibrationStore store(flash);
+        TEST_ASSERT_TRUE(store.save(calibration(3)));
+        checkLoads(flash, 3);
+    }
+}
+
+void test_corrupt_slot_falls_back_to_previous_slot()
+{
+    static uint8_t memory[BLOCK];
+    RamFlashStore flash(memory, BLOCK, BLOCK);
+    CalibrationStore store(flash);
+    TEST_ASSERT_TRUE(store.save(calibration(0)));
+    TEST_ASSERT_TRUE(store.save(calibration(1)));
+    // a gain byte of the newest slot, so only the CRC catches it
+    memory[CalibrationStore::SLOT_SIZE + CalibrationStore::HEADER_SIZE + 5] ^= 0x10;
+    checkLoads(flash, 0);
+}
+
+void test_full_block_is_erased()
+{
+    static uint8_t memory[BLOCK];
+    RamFlashStore flash(memory, BLOCK, BLOCK);
+    CalibrationStore store(flash);
+    for (int n = 0; n < static_cast<int>(SLOTS); n++) TEST_ASSERT_TRUE(store.save(calibration(n)));
+    checkLoads(flash, SLOTS - 1);
+
+    // the erase for the next save fails: the full block keeps the newest one
+    flash.powerCutAfter(0);
+    TEST_ASSERT_FALSE(store.save(calibration(SLOTS)));
+    flash.powerCutAfter(-1);
+    checkLoads(flash, SLOTS - 1);
+
+    for (int n = SLOTS; n < static_cast<int>(3 * SLOTS); n++) {
+        CalibrationStore after_reset(flash);
+        TEST_ASSERT_TRUE(after_reset.save(calibration(n)));
+        checkLoads(flash, n);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_block_has_no_calibration);
+    RUN_TEST(test_newest_save_wins);
+    RUN_TEST(test_torn_save_falls_back_to_previous_slot);
+    RUN_TEST(test_corrupt_slot_falls_back_to_previous_slot);
+    RUN_TEST(test_full_block_is_erased);
+    return UNITY_END();
+}
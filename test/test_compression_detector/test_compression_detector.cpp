@@ -0,0 +1,297 @@
+#include <unity.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "compression_detector.h"
+#include "dsp_kernels.h"
+
+void setUp() {}
+void tearDown() {}
+
+struct Sample {
+    unsigned long ms;
+    float grams;
+};
+
+// One compression: exactly one detection must have its press time in [start, end)
+struct Cycle {
+    unsigned long start;
+    unsigned long end;
+};
+
+struct Session {
+    std::vector<Sample> samples;
+    std::vector<Cycle> cycles;
+};
+
+struct Score {
+    int detected;
+    int missed;   // cycles without a detection
+    int doubles;  // detections beyond the first in a cycle
+    int extra;    // detections outside every cycle
+};
+
+static Score score(const Session &session, const std::vector<unsigned long> &presses)
+{
+    Score s = {static_cast<int>(presses.size()), 0, 0, 0};
+    std::vector<int> hits(session.cycles.size(), 0);
+    for (unsigned long press : presses) {
+        bool inside = false;
+        for (size_t i = 0; i < session.cycles.size(); i++) {
+            if (press >= session.cycles[i].start && press < session.cycles[i].end) {
+                hits[i]++;
+                inside = true;
+            }
+        }
+        if (!inside) s.extra++;
+    }
+    for (int h : hits) {
+        if (h == 0) s.missed++;
+        if (h > 1) s.doubles += h - 1;
+    }
+    return s;
+}
+
+static void checkScore(const Session &session, const std::vector<unsigned long> &presses, const char *name)
+{
+    Score s = score(session, presses);
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %d cycles, %d detected, %d missed, %d double, %d extra", name,
+             static_cast<int>(session.cycles.size()), s.detected, s.missed, s.doubles, s.extra);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, s.missed, message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, s.doubles, message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, s.extra, message);
+}
+
+// Each sample straight into a detector with its own IIR low-pass
+static std::vector<unsigned long> detectRaw(const Session &session)
+{
+    CompressionDetector detector;
+    std::vector<unsigned long> presses;
+    for (const Sample &s : session.samples) {
+        if (detector.update(s.grams, s.ms)) presses.push_back(detector.lastEvent().press_time);
+    }
+    return presses;
+}
+
+// As sampleTask() feeds it: q15 blocks through the FIR, then an unfiltered detector
+static std::vector<unsigned long> detectFiltered(const Session &session)
+{
+    LoadCellBlockFilter filter;
+    filter.reset();
+    CompressionDetector detector(0);
+    std::vector<unsigned long> presses;
+    int16_t block[LoadCellBlockFilter::BLOCK];
+    int16_t filtered[LoadCellBlockFilter::BLOCK];
+    for (size_t at = 0; at < session.samples.size(); at += LoadCellBlockFilter::BLOCK) {
+        size_t n = session.samples.size() - at;
+        if (n > LoadCellBlockFilter::BLOCK) n = LoadCellBlockFilter::BLOCK;
+        for (size_t i = 0; i < n; i++) block[i] = gramsToQ15(session.samples[at + i].grams);
+        filter.process(block, filtered, nullptr, n);
+        for (size_t i = 0; i < n; i++) {
+            if (detector.update(filtered[i] * FORCE_Q15_GRAMS, session.samples[at + i].ms)) {
+                presses.push_back(detector.lastEvent().press_time);
+            }
+        }
+    }
+    return presses;
+}
+
+// 100 synthetic compressions at 80 SPS (12 ms apart) and 95-125 BPM from
+// first_press: peaks between 12 and 35 kg, every fifth one leans 3 kg instead
+// of recoiling, the top wobbles by 600 g, +/-40 g of noise and the cell
+// drifts by drift_g_per_min
+static Session synthetic(float drift_g_per_min, unsigned long first_press = 2000)
+{
+    constexpr int CYCLES = 100;
+    Session session;
+    unsigned long t = first_press;
+    for (int i = 0; i < CYCLES; i++) {
+        unsigned long next = t + 60000 / (95 + (i * 37) % 31);
+        session.cycles.push_back(Cycle{t, next});
+        t = next;
+    }
+
+    uint32_t seed = 7;
+    size_t c = 0;
+    for (unsigned long ms = 0; ms < t + 1000; ms += 12) {
+        float force = drift_g_per_min * ms / 60000.0f;
+        seed = seed * 1103515245UL + 12345;
+        force += static_cast<float>((seed >> 16) % 81) - 40.0f;
+        while (c < session.cycles.size() && ms >= session.cycles[c].end) c++;
+        if (c < session.cycles.size() && ms >= session.cycles[c].start) {
+            const Cycle &cycle = session.cycles[c];
+            float phase = static_cast<float>(ms - cycle.start) / (cycle.end - cycle.start);
+            float peak = 12000.0f + (c * 7919 % 23) * 1000.0f;
+            float lean = c % 5 == 0 ? 3000.0f : 0.0f;
+            if (phase >= 0.5f) {
+                force += lean;
+            } else {
+                float press = peak * sinf(M_PI * phase / 0.5f);
+                if (phase > 0.2f && phase < 0.3f) press += 600.0f * sinf(2 * M_PI * phase * 40);
+                if (phase > 0.25f && press < lean) press = lean;
+                force += press;
+            }
+        }
+        session.samples.push_back(Sample{ms, force});
+    }
+    return session;
+}
+
+// ms,grams rows with "# cycle START END" windows, next to this file
+static Session loadTrace(const char *name)
+{
+    std::string path = __FILE__;
+    path = path.substr(0, path.find_last_of("/\\") + 1) + name;
+    Session session;
+    FILE *f = fopen(path.c_str(), "r");
+    TEST_ASSERT_NOT_NULL(f);
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long a, b;
+        long grams;
+        if (sscanf(line, "# cycle %lu %lu", &a, &b) == 2) session.cycles.push_back(Cycle{a, b});
+        else if (line[0] != '#' && sscanf(line, "%lu,%ld", &a, &grams) == 2) session.samples.push_back(Sample{a, static_cast<float>(grams)});
+    }
+    fclose(f);
+    return session;
+}
+
+void test_synthetic_steady()
+{
+    Session session = synthetic(0.0f);
+    checkScore(session, detectRaw(session), "steady");
+    checkScore(session, detectFiltered(session), "steady, FIR");
+}
+
+void test_synthetic_drift_up()
+{
+    Session session = synthetic(6000.0f);
+    checkScore(session, detectRaw(session), "drift up");
+    checkScore(session, detectFiltered(session), "drift up, FIR");
+}
+
+void test_synthetic_drift_down()
+{
+    Session session = synthetic(-6000.0f);
+    checkScore(session, detectRaw(session), "drift down");
+    checkScore(session, detectFiltered(session), "drift down, FIR");
+}
+
+void test_synthetic_fast_drift()
+{
+    // far more than a load cell creeps; only a tracked baseline keeps up
+    Session up = synthetic(20000.0f);
+    checkScore(up, detectRaw(up), "fast drift up");
+    checkScore(up, detectFiltered(up), "fast drift up, FIR");
+    Session down = synthetic(-20000.0f);
+    checkScore(down, detectRaw(down), "fast drift down");
+    checkScore(down, detectFiltered(down), "fast drift down, FIR");
+}
+
+void test_recorded_session()
+{
+    Session session = loadTrace("session_sim_capture.csv");
+    TEST_ASSERT_GREATER_THAN(5000, session.samples.size());
+    TEST_ASSERT_EQUAL(105, session.cycles.size());
+    checkScore(session, detectRaw(session), "recorded");
+    checkScore(session, detectFiltered(session), "recorded, FIR");
+}
+
+void test_still_cell_never_fires()
+{
+    // noise and slow drift alone, nothing pressed
+    Session session;
+    uint32_t seed = 11;
+    for (unsigned long ms = 0; ms < 120000; ms += 12) {
+        seed = seed * 1103515245UL + 12345;
+        float noise = static_cast<float>((seed >> 16) % 201) - 100.0f;
+        session.samples.push_back(Sample{ms, 3000.0f * ms / 120000.0f + noise});
+    }
+    checkScore(session, detectRaw(session), "still");
+    checkScore(session, detectFiltered(session), "still, FIR");
+}
+
+void test_plateau_becomes_baseline()
+{
+    // a 6 kg weight set on the cell at 0.5 s, compressions on top of it from 5 s
+    Session session = synthetic(0.0f, 5000);
+    for (Sample &s : session.samples) {
+        if (s.ms >= 500) s.grams += 6000.0f;
+    }
+    checkScore(session, detectRaw(session), "weight on the cell");
+    checkScore(session, detectFiltered(session), "weight on the cell, FIR");
+
+    CompressionDetector detector;
+    for (const Sample &s : session.samples) {
+        if (s.ms >= 5000) break;
+        detector.update(s.grams, s.ms);
+        if (s.ms > 500 + CompressionDetector::PLATEAU_MS + 200) TEST_ASSERT_TRUE(detector.isIdle());
+    }
+    TEST_ASSERT_INT_WITHIN(200, 6000, detector.baseline());
+}
+
+void test_offset_from_boot_is_zero()
+{
+    // a cell that was tared under a different load: the first sample is the
+    // zero, or through the FIR (which ramps up from an empty history) the
+    // plateau it settles on PLATEAU_MS later
+    Session session = synthetic(0.0f, 3000);
+    for (Sample &s : session.samples) s.grams += 9000.0f;
+    checkScore(session, detectRaw(session), "boot offset");
+    checkScore(session, detectFiltered(session), "boot offset, FIR");
+}
+
+void test_lean_plateau_returns_to_idle()
+{
+    // one press, then the trainee keeps leaning with 4 kg and never recoils
+    CompressionDetector detector;
+    int detected = 0;
+    for (unsigned long ms = 0; ms < 8000; ms += 12) {
+        float grams = 0.0f;
+        if (ms >= 1000 && ms < 1300) grams = 30000.0f * sinf(M_PI * (ms - 1000) / 300.0f);
+        if (ms >= 1150 && grams < 4000.0f) grams = 4000.0f;
+        if (detector.update(grams, ms)) detected++;
+        if (ms > 1400 && ms < 1300 + CompressionDetector::PLATEAU_MS) TEST_ASSERT_FALSE(detector.isIdle());
+        if (ms > 1300 + CompressionDetector::PLATEAU_MS + 200) TEST_ASSERT_TRUE(detector.isIdle());
+    }
+    TEST_ASSERT_EQUAL(1, detected);
+    TEST_ASSERT_INT_WITHIN(200, 4000, detector.baseline());
+}
+
+void test_full_scale_swings_saturate()
+{
+    // the largest step either way must not wrap the Q8 difference
+    FixedLowPass lowpass;
+    BaselineTracker baseline(1);
+    int32_t last = 0;
+    for (int i = 0; i < 8; i++) {
+        int32_t grams = i % 2 ? INT32_MAX : INT32_MIN;
+        int32_t y = lowpass.update(grams);
+        baseline.update(grams, true);
+        TEST_ASSERT_LESS_OR_EQUAL(FORCE_LIMIT_GRAMS, y > 0 ? y : -y);
+        TEST_ASSERT_LESS_OR_EQUAL(FORCE_LIMIT_GRAMS, baseline.value() > 0 ? baseline.value() : -baseline.value());
+        // each step heads towards the new input
+        if (i > 0) TEST_ASSERT_TRUE(i % 2 ? y > last : y < last);
+        last = y;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_synthetic_steady);
+    RUN_TEST(test_synthetic_drift_up);
+    RUN_TEST(test_synthetic_drift_down);
+    RUN_TEST(test_synthetic_fast_drift);
+    RUN_TEST(test_recorded_session);
+    RUN_TEST(test_still_cell_never_fires);
+    RUN_TEST(test_plateau_becomes_baseline);
+    RUN_TEST(test_offset_from_boot_is_zero);
+    RUN_TEST(test_lean_plateau_returns_to_idle);
+    RUN_TEST(test_full_scale_swings_saturate);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+#include <unity.h>
+#include <vector>
+#include "debug_log.h"
+#include "waveform_codec.h"
+
+// The TX side of a port: takes what availableForWrite() reports as room, or
+// accept bytes per write() when that is set
+class CapturePort : public Print {
+public:
+    int room = 1 << 16;
+    size_t accept = 0;
+    std::vector<uint8_t> bytes;
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *data, size_t len) override
+    {
+        if (accept > 0 && len > accept) len = accept;
+        bytes.insert(bytes.end(), data, data + len);
+        return len;
+    }
+    int availableForWrite() override { return room; }
+};
+
+struct Decoded {
+    uint16_t id;
+    unsigned long ms;   // from the first record's time
+    uint32_t arg;       // first argument, raw varint
+};
+
+static std::vector<Decoded> decode(const std::vector<uint8_t> &bytes)
+{
+    std::vector<Decoded> records;
+    unsigned long ms = 0;
+    size_t at = 0;
+    while (at < bytes.size()) {
+        TEST_ASSERT_EQUAL_UINT8(LOG_MARKER, bytes[at]);
+        TEST_ASSERT_LESS_OR_EQUAL(bytes.size(), at + 2 + bytes[at + 1]);
+        size_t end = at + 2 + bytes[at + 1];
+        Decoded record;
+        record.id = bytes[at + 2] | (bytes[at + 3] << 8);
+        uint32_t dt;
+        size_t n = varintDecode(&bytes[at + 4], end - at - 4, dt);
+        TEST_ASSERT_GREATER_THAN(0, n);
+        ms = records.empty() ? 0 : ms + dt;
+        record.ms = ms;
+        record.arg = 0;
+        varintDecode(&bytes[at + 4 + n], end - at - 4 - n, record.arg);
+        records.push_back(record);
+        at = end;
+    }
+    return records;
+}
+
+static void drainAll(CapturePort &port)
+{
+    for (int i = 0; i < 10000 && logPending() > 0; i++) logDrain(port);
+    TEST_ASSERT_EQUAL(0, logPending());
+}
+
+void setUp()
+{
+    CapturePort discard;
+    drainAll(discard);
+}
+
+void tearDown() {}
+
+constexpr uint16_t TICK_ID = logId(LOG_LEVEL_WARN, "test: tick %lu");
+constexpr uint16_t GAP_ID = logId(LOG_LEVEL_WARN, "log: %lu records dropped");
+
+void test_records_arrive_in_order()
+{
+    CapturePort port;
+    for (unsigned long i = 0; i < 20; i++) {
+        LOG_WARN("test: tick %lu", i);
+        delay(7);
+    }
+    drainAll(port);
+    std::vector<Decoded> records = decode(port.bytes);
+    TEST_ASSERT_EQUAL(20, records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT16(TICK_ID, records[i].id);
+        TEST_ASSERT_EQUAL_UINT32(i, records[i].arg);
+        TEST_ASSERT_EQUAL(7 * i, records[i].ms);
+    }
+}
+
+void test_dropped_records_keep_time()
+{
+    // far more than the ring holds, 10 ms apart, then room again
+    CapturePort port;
+    unsigned long dropped = logDropped();
+    for (unsigned long i = 0; i < 200; i++) {
+        LOG_WARN("test: tick %lu", i);
+        delay(10);
+    }
+    TEST_ASSERT_GREATER_THAN(dropped, logDropped());
+    drainAll(port);
+    LOG_WARN("test: tick %lu", 200UL);
+    drainAll(port);
+
+    std::vector<Decoded> records = decode(port.bytes);
+    TEST_ASSERT_EQUAL_UINT16(GAP_ID, records[records.size() - 2].id);
+    TEST_ASSERT_EQUAL_UINT32(logDropped() - dropped, records[records.size() - 2].arg);
+    // every record that got through carries the time it was logged at
+    for (const Decoded &r : records) {
+        if (r.id == TICK_ID) TEST_ASSERT_EQUAL(10 * r.arg, r.ms);
+    }
+    TEST_ASSERT_EQUAL(2000, records.back().ms);
+}
+
+void test_drains_without_reported_room()
+{
+    // the R4's UART: availableForWrite() is always 0
+    CapturePort port;
+    port.room = 0;
+    for (unsigned long i = 0; i < 10; i++) LOG_WARN("test: tick %lu", i);
+    size_t pending = logPending();
+    int passes = 0;
+    while (logPending() > 0 && passes < 1000) {
+        size_t before = port.bytes.size();
+        logDrain(port);
+        TEST_ASSERT_LESS_OR_EQUAL(LOG_BLIND_DRAIN, port.bytes.size() - before);
+        passes++;
+    }
+    TEST_ASSERT_EQUAL(0, logPending());
+    TEST_ASSERT_EQUAL((pending + LOG_BLIND_DRAIN - 1) / LOG_BLIND_DRAIN, passes);
+    std::vector<Decoded> records = decode(port.bytes);
+    TEST_ASSERT_EQUAL(10, records.size());
+    for (size_t i = 0; i < records.size(); i++) TEST_ASSERT_EQUAL_UINT32(i, records[i].arg);
+}
+
+void test_short_writes_keep_the_rest()
+{
+    CapturePort port;
+    port.accept = 3;
+    for (unsigned long i = 0; i < 10; i++) LOG_WARN("test: tick %lu", i);
+    drainAll(port);
+    std::vector<Decoded> records = decode(port.bytes);
+    TEST_ASSERT_EQUAL(10, records.size());
+    for (size_t i = 0; i < records.size(); i++) TEST_ASSERT_EQUAL_UINT32(i, records[i].arg);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_records_arrive_in_order);
+    RUN_TEST(test_dropped_records_keep_time);
+    RUN_TEST(test_drains_without_reported_room);
+    RUN_TEST(test_short_writes_keep_the_rest);
+    return UNITY_END();
+}
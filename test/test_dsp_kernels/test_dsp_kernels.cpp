@@ -0,0 +1,173 @@
+#include <unity.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "dsp_kernels.h"
+
+void setUp() {}
+void tearDown() {}
+
+constexpr int HISTORY = LoadCellBlockFilter::TAPS - 1;
+
+static std::vector<int16_t> randomQ15(std::mt19937 &rng, size_t n)
+{
+    std::uniform_int_distribution<int> any(-32768, 32767);
+    std::vector<int16_t> v(n);
+    for (int16_t &s : v) s = static_cast<int16_t>(any(rng));
+    return v;
+}
+
+static void checkFir(const std::vector<int16_t> &reversed, const std::vector<int16_t> &x, size_t n)
+{
+    int taps = static_cast<int>(reversed.size());
+    std::vector<int16_t> scalar(n + 1, 0x5A5A), simd(n + 1, 0x5A5A);
+    firQ15Scalar(reversed.data(), taps, x.data(), scalar.data(), n);
+    firQ15Simd(reversed.data(), taps, x.data(), simd.data(), n);
+    // one past the end shows neither writes beyond n
+    TEST_ASSERT_EQUAL_INT16_ARRAY(scalar.data(), simd.data(), n + 1);
+}
+
+static void checkSlope(const int16_t *prev, const std::vector<int16_t> &y, size_t n)
+{
+    std::vector<int16_t> scalar(n + 1, 0x5A5A), simd(n + 1, 0x5A5A);
+    slopeQ15Scalar(prev, y.data(), scalar.data(), n);
+    slopeQ15Simd(prev, y.data(), simd.data(), n);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(scalar.data(), simd.data(), n + 1);
+}
+
+// The firmware's filter over the whole trace in one scalar pass
+static void onePass(const std::vector<int16_t> &in, std::vector<int16_t> &y, std::vector<int16_t> &d)
+{
+    std::vector<int16_t> x(HISTORY, 0);
+    x.insert(x.end(), in.begin(), in.end());
+    const int16_t zero[2] = {0, 0};
+    y.assign(in.size(), 0);
+    d.assign(in.size(), 0);
+    firQ15Scalar(LoadCellBlockFilter::LOWPASS, LoadCellBlockFilter::TAPS, x.data(), y.data(), in.size());
+    slopeQ15Scalar(zero, y.data(), d.data(), in.size());
+}
+
+// 4 s of compressions at 80 SPS in q15, 30 kg peaks and noise
+static std::vector<int16_t> compressions()
+{
+    std::vector<int16_t> in;
+    uint32_t seed = 5;
+    for (int i = 0; i < 320; i++) {
+        float phase = fmodf(i * 12.5f, 571.4f) / 571.4f;
+        float grams = phase < 0.5f ? 30000.0f * sinf(M_PI * phase / 0.5f) : 0.0f;
+        seed = seed * 1103515245UL + 12345;
+        in.push_back(gramsToQ15(grams + static_cast<float>((seed >> 16) % 81) - 40.0f));
+    }
+    return in;
+}
+
+void test_fir_random_matches_scalar()
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pairs(1, 16);
+    std::uniform_int_distribution<int> length(1, 40);
+    for (int trial = 0; trial < 2000; trial++) {
+        int taps = 2 * pairs(rng);
+        size_t n = length(rng);
+        checkFir(randomQ15(rng, taps), randomQ15(rng, taps - 1 + n), n);
+    }
+}
+
+void test_fir_extremes_match_scalar()
+{
+    // every product at +/-2^30 and sums far past q15 either way
+    const int16_t ends[] = {-32768, 32767};
+    for (int16_t c : ends) {
+        for (int16_t v : ends) {
+            for (int taps = 2; taps <= 32; taps += 2) {
+                std::vector<int16_t> reversed(taps, c);
+                std::vector<int16_t> x(taps - 1 + 17, v);
+                checkFir(reversed, x, 17);
+                std::vector<int16_t> out(1);
+                firQ15Simd(reversed.data(), taps, x.data(), out.data(), 1);
+                TEST_ASSERT_EQUAL_INT16((c < 0) == (v < 0) ? 32767 : -32768, out[0]);
+            }
+        }
+    }
+    // alternating signs cancel pair by pair, so only the rounding is left
+    std::vector<int16_t> reversed = {32767, -32768, 32767, -32768};
+    std::vector<int16_t> x = {-32768, 32767, -32768, 32767, -32768, 32767, -32768};
+    checkFir(reversed, x, 4);
+}
+
+void test_slope_random_matches_scalar()
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> length(0, 41);
+    for (int trial = 0; trial < 2000; trial++) {
+        size_t n = length(rng);
+        std::vector<int16_t> prev = randomQ15(rng, 2);
+        checkSlope(prev.data(), randomQ15(rng, n), n);
+    }
+    // the widest step either way, in both lanes and in the odd tail
+    const int16_t prev[2] = {-32768, 32767};
+    std::vector<int16_t> y = {32767, -32768, -32768, 32767, 32767, -32768, -32768};
+    for (size_t n = 0; n <= y.size(); n++) checkSlope(prev, y, n);
+}
+
+void test_blocks_match_one_pass()
+{
+    // the history carried between blocks of any size gives the one-pass output
+    std::vector<int16_t> in = compressions();
+    std::mt19937 rng(3);
+    std::vector<int16_t> noise = randomQ15(rng, 160);
+    in.insert(in.end(), noise.begin(), noise.end());
+    std::vector<int16_t> y, d;
+    onePass(in, y, d);
+
+    for (size_t block = 1; block <= LoadCellBlockFilter::BLOCK; block++) {
+        LoadCellBlockFilter filter;
+        filter.reset();
+        std::vector<int16_t> x(HISTORY, 0);
+        x.insert(x.end(), in.begin(), in.end());
+        std::vector<int16_t> out(in.size()), slope(in.size()), simd_out(in.size()), simd_slope(in.size());
+        const int16_t zero[2] = {0, 0};
+        for (size_t at = 0; at < in.size(); at += block) {
+            size_t n = in.size() - at < block ? in.size() - at : block;
+            filter.process(&in[at], &out[at], &slope[at], n);
+            firQ15Simd(LoadCellBlockFilter::LOWPASS, LoadCellBlockFilter::TAPS, &x[at], &simd_out[at], n);
+            slopeQ15Simd(at == 0 ? zero : &simd_out[at - 2], &simd_out[at], &simd_slope[at], n);
+        }
+        TEST_ASSERT_EQUAL_INT16_ARRAY(y.data(), out.data(), in.size());
+        TEST_ASSERT_EQUAL_INT16_ARRAY(d.data(), slope.data(), in.size());
+        TEST_ASSERT_EQUAL_INT16_ARRAY(y.data(), simd_out.data(), in.size());
+        TEST_ASSERT_EQUAL_INT16_ARRAY(d.data(), simd_slope.data(), in.size());
+    }
+}
+
+void test_float_reference_within_rounding()
+{
+    std::vector<int16_t> in = compressions();
+    std::vector<int16_t> y, d;
+    onePass(in, y, d);
+    std::vector<int16_t> x(HISTORY, 0);
+    x.insert(x.end(), in.begin(), in.end());
+    for (size_t i = 0; i < in.size(); i++) {
+        float acc = 0;
+        for (int k = 0; k < LoadCellBlockFilter::TAPS; k++) acc += LoadCellBlockFilter::LOWPASS[k] / 32768.0f * x[i + k];
+        TEST_ASSERT_INT_WITHIN(1, lroundf(acc), y[i]);
+    }
+    // unity DC gain: a held force comes out unchanged once the history fills
+    std::vector<int16_t> held(40, 12345);
+    onePass(held, y, d);
+    for (size_t i = LoadCellBlockFilter::TAPS + 1; i < held.size(); i++) {
+        TEST_ASSERT_EQUAL_INT16(12345, y[i]);
+        TEST_ASSERT_EQUAL_INT16(0, d[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fir_random_matches_scalar);
+    RUN_TEST(test_fir_extremes_match_scalar);
+    RUN_TEST(test_slope_random_matches_scalar);
+    RUN_TEST(test_blocks_match_one_pass);
+    RUN_TEST(test_float_reference_within_rounding);
+    return UNITY_END();
+}
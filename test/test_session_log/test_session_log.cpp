@@ -0,0 +1,255 @@
+#include <unity.h>
+#include <vector>
+#include "session_log.h"
+#include "waveform_codec.h"
+
+void setUp() {}
+void tearDown() {}
+
+// four small blocks, so a few sessions fill the ring
+constexpr size_t BLOCK = 256;
+constexpr size_t BLOCKS = 4;
+constexpr size_t SIZE = BLOCK * BLOCKS;
+
+// SESSION_START for session 1 at 5000 ms: three payload bytes, so six before
+// the commit byte and seven in all
+constexpr long START_BODY = 6;
+
+// With check, a fresh mount after every step must see the same oldest block
+static void pumpAll(SessionLog &log, FlashStore *check)
+{
+    for (int i = 0; i < 1000 && !log.idle(); i++) {
+        log.pump();
+        if (check) {
+            SessionLog mounted(*check);
+            TEST_ASSERT_TRUE(mounted.mount());
+            TEST_ASSERT_EQUAL(mounted.oldestSeq(), log.oldestSeq());
+        }
+    }
+    TEST_ASSERT_TRUE(log.idle());
+}
+
+static void recordSession(SessionLog &log, unsigned long start, int compressions, FlashStore *check = nullptr)
+{
+    log.beginSession(start);
+    pumpAll(log, check);
+    for (int i = 0; i < compressions; i++) {
+        CompressionQuality quality = {};
+        quality.press_time = start + 600 * (i + 1);
+        quality.peak_grams = 25000.0f + 700.0f * (i % 9);
+        quality.residual_grams = 400.0f;
+        quality.duty_pct = 50;
+        log.addCompression(quality);
+        pumpAll(log, check);
+    }
+    log.endSession(start + 600 * (compressions + 1), SessionLog::Summary{105.0f, 0.9f, 0.8f});
+    pumpAll(log, check);
+    TEST_ASSERT_EQUAL(0, log.dropped());
+}
+
+static std::vector<SessionLog::Record> listRecords(SessionLog &log)
+{
+    std::vector<SessionLog::Record> records;
+    SessionLog::Cursor cursor = log.begin();
+    SessionLog::Record record;
+    while (log.next(cursor, record)) records.push_back(record);
+    return records;
+}
+
+static uint32_t sessionOf(const SessionLog::Record &record)
+{
+    uint32_t session = 0;
+    TEST_ASSERT_GREATER_THAN(0, varintDecode(record.payload, record.len, session));
+    return session;
+}
+
+static bool blockUsed(RamFlashStore &flash, size_t block)
+{
+    return !flash.isBlank(block * BLOCK, SessionLog::HEADER_SIZE);
+}
+
+void test_records_survive_remount()
+{
+    static uint8_t memory[SIZE];
+    RamFlashStore flash(memory, SIZE, BLOCK);
+    SessionLog log(flash);
+    TEST_ASSERT_TRUE(log.mount());
+    recordSession(log, 1000, 12);
+    recordSession(log, 20000, 5);
+    std::vector<SessionLog::Record> written = listRecords(log);
+    TEST_ASSERT_EQUAL(log.records(), written.size());
+
+    SessionLog again(flash);
+    TEST_ASSERT_TRUE(again.mount());
+    std::vector<SessionLog::Record> read = listRecords(again);
+    TEST_ASSERT_EQUAL(written.size(), read.size());
+    TEST_ASSERT_EQUAL(written.size(), again.records());
+    TEST_ASSERT_EQUAL(2, again.sessions());
+    for (size_t i = 0; i < read.size(); i++) {
+        TEST_ASSERT_EQUAL(written[i].type, read[i].type);
+        TEST_ASSERT_EQUAL(written[i].len, read[i].len);
+        TEST_ASSERT_EQUAL_MEMORY(written[i].payload, read[i].payload, read[i].len);
+    }
+    TEST_ASSERT_EQUAL(SessionLog::SESSION_START, read.front().type);
+    TEST_ASSERT_EQUAL(SessionLog::SESSION_END, read.back().type);
+}
+
+void test_torn_record_is_skipped_and_block_sealed()
+{
+    // power fails after each possible number of bytes of one record, up to
+    // and including the commit byte
+    for (long cut = 0; cut <= START_BODY + 1; cut++) {
+        static uint8_t memory[SIZE];
+        RamFlashStore flash(memory, SIZE, BLOCK);
+        unsigned long before;
+        {
+            SessionLog log(flash);
+            TEST_ASSERT_TRUE(log.mount());
+            recordSession(log, 1000, 3);
+            before = log.records();
+            flash.powerCutAfter(cut);
+            log.beginSession(5000);
+            for (int i = 0; i < 20; i++) log.pump();
+            flash.powerCutAfter(-1);
+        }
+
+        // after the reset
+        bool committed = cut > START_BODY;
+        bool torn = cut > 0 && !committed;
+        SessionLog log(flash);
+        TEST_ASSERT_TRUE(log.mount());
+        std::vector<SessionLog::Record> records = listRecords(log);
+        TEST_ASSERT_EQUAL(before + (committed ? 1 : 0), log.records());
+        TEST_ASSERT_EQUAL(log.records(), records.size());
+        TEST_ASSERT_EQUAL(committed ? SessionLog::SESSION_START : SessionLog::SESSION_END, records.back().type);
+        // a record that never committed doesn't use up its session number
+        TEST_ASSERT_EQUAL(committed ? 2 : 1, log.sessions());
+
+        // the torn bytes can't be appended over, so the next record opens a new block
+        recordSession(log, 9000, 1);
+        TEST_ASSERT_EQUAL(0, log.failures());
+        TEST_ASSERT_EQUAL(torn, blockUsed(flash, 1));
+        if (torn) TEST_ASSERT_EQUAL(SessionLog::SESSION_START, memory[BLOCK + SessionLog::HEADER_SIZE]);
+
+        SessionLog again(flash);
+        TEST_ASSERT_TRUE(again.mount());
+        records = listRecords(again);
+        TEST_ASSERT_EQUAL(before + (committed ? 1 : 0) + 3, records.size());
+        TEST_ASSERT_EQUAL(SessionLog::SESSION_START, records[records.size() - 3].type);
+        TEST_ASSERT_EQUAL(committed ? 2 : 1, sessionOf(records[records.size() - 3]));
+        TEST_ASSERT_EQUAL(SessionLog::SESSION_END, records.back().type);
+    }
+}
+
+// Sessions until the log has used three of the four blocks
+static void fillThreeBlocks(RamFlashStore &flash, SessionLog &log)
+{
+    TEST_ASSERT_TRUE(log.mount());
+    unsigned long t = 1000;
+    while (!blockUsed(flash, 2)) {
+        recordSession(log, t, 20);
+        t += 30000;
+    }
+    TEST_ASSERT_FALSE(blockUsed(flash, 3));
+}
+
+void test_corrupt_oldest_header_drops_block()
+{
+    static uint8_t memory[SIZE];
+    RamFlashStore flash(memory, SIZE, BLOCK);
+    SessionLog log(flash);
+    fillThreeBlocks(flash, log);
+    uint32_t oldest = log.oldestSeq();
+    std::vector<SessionLog::Record> before = listRecords(log);
+
+    // the sequence number still fits the chain, so only the header CRC catches it
+    memory[3] ^= 0x01;
+    SessionLog again(flash);
+    TEST_ASSERT_TRUE(again.mount());
+    TEST_ASSERT_EQUAL(oldest + 1, again.oldestSeq());
+    std::vector<SessionLog::Record> after = listRecords(again);
+    TEST_ASSERT_GREATER_THAN(0, after.size());
+    TEST_ASSERT_LESS_THAN(before.size(), after.size());
+    TEST_ASSERT_EQUAL(after.size(), again.records());
+    // what is left is the tail of what was there
+    size_t skip = before.size() - after.size();
+    for (size_t i = 0; i < after.size(); i++) {
+        TEST_ASSERT_EQUAL(before[skip + i].type, after[i].type);
+        TEST_ASSERT_EQUAL_MEMORY(before[skip + i].payload, after[i].payload, after[i].len);
+    }
+}
+
+void test_corrupt_newest_header_keeps_older_blocks()
+{
+    static uint8_t memory[SIZE];
+    RamFlashStore flash(memory, SIZE, BLOCK);
+    SessionLog log(flash);
+    fillThreeBlocks(flash, log);
+    uint32_t oldest = log.oldestSeq();
+    uint16_t sessions = log.sessions();
+
+    memory[2 * BLOCK] = 0;   // magic
+    SessionLog again(flash);
+    TEST_ASSERT_TRUE(again.mount());
+    TEST_ASSERT_EQUAL(oldest, again.oldestSeq());
+    TEST_ASSERT_LESS_OR_EQUAL(sessions, again.sessions());
+    TEST_ASSERT_GREATER_THAN(0, listRecords(again).size());
+
+    // the log carries on from the newest block it still trusts
+    uint16_t next = again.sessions();
+    recordSession(again, 500000, 20);
+    SessionLog remounted(flash);
+    TEST_ASSERT_TRUE(remounted.mount());
+    std::vector<SessionLog::Record> records = listRecords(remounted);
+    TEST_ASSERT_EQUAL(SessionLog::SESSION_END, records.back().type);
+    TEST_ASSERT_EQUAL(next, sessionOf(records.back()));
+    TEST_ASSERT_EQUAL(next + 1, remounted.sessions());
+    TEST_ASSERT_EQUAL(oldest, remounted.oldestSeq());
+}
+
+void test_full_ring_wraps_and_drops_oldest()
+{
+    static uint8_t memory[SIZE];
+    RamFlashStore flash(memory, SIZE, BLOCK);
+    SessionLog log(flash);
+    TEST_ASSERT_TRUE(log.mount());
+    uint32_t oldest = 0;
+    int advanced = 0;
+    for (uint16_t session = 0; session < 30; session++) {
+        recordSession(log, 1000 + 30000UL * session, 15, &flash);
+        TEST_ASSERT_GREATER_OR_EQUAL(oldest, log.oldestSeq());
+        if (log.oldestSeq() > oldest) advanced++;
+        oldest = log.oldestSeq();
+
+        SessionLog again(flash);
+        TEST_ASSERT_TRUE(again.mount());
+        TEST_ASSERT_EQUAL(log.oldestSeq(), again.oldestSeq());
+        TEST_ASSERT_EQUAL(session + 1, again.sessions());
+        std::vector<SessionLog::Record> records = listRecords(again);
+        TEST_ASSERT_EQUAL(again.records(), records.size());
+        // sessions come out in order, ending with the one just written
+        uint32_t last = 0;
+        for (const SessionLog::Record &r : records) {
+            if (r.type == SessionLog::COMPRESSIONS) continue;
+            TEST_ASSERT_GREATER_OR_EQUAL(last, sessionOf(r));
+            last = sessionOf(r);
+        }
+        TEST_ASSERT_EQUAL(SessionLog::SESSION_END, records.back().type);
+        TEST_ASSERT_EQUAL(session, last);
+    }
+    for (size_t b = 0; b < BLOCKS; b++) TEST_ASSERT_TRUE(blockUsed(flash, b));
+    // 30 sessions take several laps of the ring
+    TEST_ASSERT_GREATER_THAN(BLOCKS, advanced);
+    TEST_ASSERT_GREATER_THAN(BLOCKS, oldest);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_records_survive_remount);
+    RUN_TEST(test_torn_record_is_skipped_and_block_sealed);
+    RUN_TEST(test_corrupt_oldest_header_drops_block);
+    RUN_TEST(test_corrupt_newest_header_keeps_older_blocks);
+    RUN_TEST(test_full_ring_wraps_and_drops_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,261 @@
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include "test_accumulator.h"
+#include "bpm_helper.h"
+
+void setUp() {}
+void tearDown() {}
+
+constexpr unsigned long START = 1000;
+
+// The test starts at START; the first press lands 2 s later, then one press
+// after each interval. Returns the last press time.
+static unsigned long press(TestAccumulator &acc, const std::vector<unsigned long> &intervals)
+{
+    unsigned long t = START + 2000;
+    acc.addPress(t);
+    for (unsigned long interval : intervals) {
+        t += interval;
+        acc.addPress(t);
+    }
+    return t;
+}
+
+static std::vector<unsigned long> repeat(unsigned long interval, int n)
+{
+    return std::vector<unsigned long>(n, interval);
+}
+
+void test_no_presses()
+{
+    TestAccumulator acc;
+    acc.reset(START);
+    TestSummary s = acc.summary(START + 30000);
+    TEST_ASSERT_EQUAL(0, s.compressions);
+    TEST_ASSERT_EQUAL(30000, s.duration_ms);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.mean_bpm);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.p50_bpm);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.in_band);
+    TEST_ASSERT_EQUAL(0, s.pauses);
+    TEST_ASSERT_EQUAL(0, s.flags);
+
+    // a single press has no interval yet
+    acc.addPress(START + 500);
+    s = acc.summary(START + 30000);
+    TEST_ASSERT_EQUAL(1, s.compressions);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.mean_bpm);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.in_band);
+}
+
+void test_steady_rate()
+{
+    TestAccumulator acc;
+    acc.reset(START);
+    unsigned long last = press(acc, repeat(600, 49));
+    TestSummary s = acc.summary(last + 500);
+    TEST_ASSERT_EQUAL(50, s.compressions);
+    TEST_ASSERT_EQUAL(last + 500 - START, s.duration_ms);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, s.mean_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, s.sd_bpm);
+    // one 8 ms bin wide
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 100.0f, s.p10_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 100.0f, s.p50_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 100.0f, s.p90_bpm);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.in_band);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f - 3.0f / TARGET_BPM, s.accuracy);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.consistency);
+    TEST_ASSERT_EQUAL(0, s.pauses);
+    TEST_ASSERT_EQUAL(0, s.flags);
+}
+
+void test_mixed_rates()
+{
+    // per 20 intervals: 2 fast (400 ms, 150 BPM), 3 slow (800 ms, 75 BPM), 15 at 600 ms
+    std::vector<unsigned long> intervals;
+    for (int i = 0; i < 100; i++) intervals.push_back(i % 20 < 2 ? 400 : i % 20 >= 17 ? 800 : 600);
+    TestAccumulator acc;
+    acc.reset(START);
+    unsigned long last = press(acc, intervals);
+    TestSummary s = acc.summary(last);
+    TEST_ASSERT_EQUAL(101, s.compressions);
+
+    // 10 x 150, 75 x 100, 15 x 75 BPM
+    float mean = (10 * 150.0f + 75 * 100.0f + 15 * 75.0f) / 100;
+    float var = (10 * 150.0f * 150.0f + 75 * 100.0f * 100.0f + 15 * 75.0f * 75.0f) / 100 - mean * mean;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, mean, s.mean_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, sqrtf(var), s.sd_bpm);
+
+    // p10 is the slow end: 10 % of the intervals were slower. The 90th
+    // interval is a third of the way into the 800 ms bin (794-802 ms).
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (794.0f + 8.0f / 3), s.p10_bpm);
+    // the 50th is 40/75 into the 600 ms bin (594-602 ms)
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (594.0f + 8.0f * 40 / 75), s.p50_bpm);
+    // the 10th is the top of the 400 ms bin (394-402 ms)
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / 402.0f, s.p90_bpm);
+    TEST_ASSERT_TRUE(s.p10_bpm < s.p50_bpm && s.p50_bpm < s.p90_bpm);
+
+    // in band by time, not by count (that would be 0.75)
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 75 * 600.0f / (10 * 400 + 75 * 600 + 15 * 800), s.in_band);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f - fabsf(mean - TARGET_BPM) / TARGET_BPM, s.accuracy);
+    // sd over MAX_STD_DEV floors at 0
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, s.consistency);
+    TEST_ASSERT_EQUAL(0, s.flags);
+}
+
+void test_pauses_count_as_time_out_of_band()
+{
+    // 2000 ms is still a (very slow) interval, 2001 ms is a pause
+    std::vector<unsigned long> intervals = repeat(600, 10);
+    intervals.push_back(2001);
+    intervals.insert(intervals.end(), 10, 600);
+    intervals.push_back(5000);
+    intervals.insert(intervals.end(), 10, 600);
+    TestAccumulator acc;
+    acc.reset(START);
+    unsigned long last = press(acc, intervals);
+    TestSummary s = acc.summary(last);
+    TEST_ASSERT_EQUAL(33, s.compressions);
+    TEST_ASSERT_EQUAL(2, s.pauses);
+    // the pauses stay out of the rate statistics
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, s.mean_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, s.sd_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 100.0f, s.p10_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 30 * 600.0f / (30 * 600 + 2001 + 5000), s.in_band);
+    TEST_ASSERT_EQUAL(0, s.flags);
+
+    acc.reset(START);
+    intervals = repeat(600, 10);
+    intervals.push_back(2000);
+    last = press(acc, intervals);
+    s = acc.summary(last);
+    TEST_ASSERT_EQUAL(0, s.pauses);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (10 * 100.0f + 30.0f) / 11, s.mean_bpm);
+    TEST_ASSERT_EQUAL(TestSummary::CLIPPED, s.flags);
+}
+
+void test_intervals_past_the_histogram_are_clipped()
+{
+    // 1500 ms (40 BPM) is past the last bin's top at 1274 ms: the slow
+    // percentile stops at the edge instead of reaching 40 BPM
+    TestAccumulator acc;
+    acc.reset(START);
+    std::vector<unsigned long> intervals = repeat(600, 10);
+    intervals.insert(intervals.end(), 10, 1500);
+    unsigned long last = press(acc, intervals);
+    TestSummary s = acc.summary(last);
+    TEST_ASSERT_EQUAL(TestSummary::CLIPPED, s.flags);
+    float edge = TestAccumulator::HIST_MIN_MS + TestAccumulator::BINS * TestAccumulator::BIN_MS;
+    TEST_ASSERT_EQUAL_FLOAT(1274.0f, edge);
+    // the 18th of 20 is 8/10 into the last bin
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (edge - 0.2f * TestAccumulator::BIN_MS), s.p10_bpm);
+    // the mean still has the true rate
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (10 * 100.0f + 10 * 40.0f) / 20, s.mean_bpm);
+
+    // 200 ms (300 BPM) is under the first bin at 250 ms
+    acc.reset(START);
+    intervals = repeat(600, 10);
+    intervals.insert(intervals.end(), 10, 200);
+    last = press(acc, intervals);
+    s = acc.summary(last);
+    TEST_ASSERT_EQUAL(TestSummary::CLIPPED, s.flags);
+    // the 2nd of 20 is 2/10 into the first bin
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (TestAccumulator::HIST_MIN_MS + 0.2f * TestAccumulator::BIN_MS),
+                             s.p90_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (10 * 100.0f + 10 * 300.0f) / 20, s.mean_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 10 * 600.0f / (10 * 600 + 10 * 200), s.in_band);
+
+    // the flag lasts until reset
+    acc.addPress(last + 600);
+    TEST_ASSERT_EQUAL(TestSummary::CLIPPED, acc.summary(last + 600).flags);
+    acc.reset(START);
+    TEST_ASSERT_EQUAL(0, acc.summary(START).flags);
+}
+
+void test_long_test()
+{
+    // 70000 presses, alternating 590 and 610 ms: 11.7 hours, more than a u16
+    // of compressions, in two bins that each stay under the u16 bin limit
+    TestAccumulator acc;
+    acc.reset(START);
+    unsigned long t = START;
+    for (int i = 0; i < 70000; i++) {
+        t += i % 2 ? 610 : 590;
+        acc.addPress(t);
+    }
+    TestSummary s = acc.summary(t);
+    TEST_ASSERT_EQUAL(70000, s.compressions);
+    float fast = 60000.0f / 590, slow = 60000.0f / 610;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (fast + slow) / 2, s.mean_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, (fast - slow) / 2, s.sd_bpm);
+    // 586-594 ms and 610-618 ms bins; one interval short of half are in the
+    // first, so the median is the bottom of the second
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (610.0f + 0.8f * 8), s.p10_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / 610.0f, s.p50_bpm);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60000.0f / (586.0f + 0.2f * 8), s.p90_bpm);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.in_band);
+    TEST_ASSERT_EQUAL(0, s.flags);
+
+    uint8_t record[TEST_RESULT_SIZE];
+    encodeTestResult(s, record);
+    // compressions clamp at the field's limit, the duration in seconds still fits
+    TEST_ASSERT_EQUAL(65535, record[1] | (record[2] << 8));
+    TEST_ASSERT_EQUAL((t - START + 500) / 1000, record[3] | (record[4] << 8));
+}
+
+void test_encode_layout()
+{
+    TestSummary s = {};
+    s.compressions = 1234;
+    s.duration_ms = 125400;
+    s.mean_bpm = 101.26f;
+    s.sd_bpm = 18.5f;
+    s.p10_bpm = 75.31f;
+    s.p50_bpm = 100.29f;
+    s.p90_bpm = 149.25f;
+    s.in_band = 0.7377f;
+    s.accuracy = 0.983f;
+    s.consistency = -0.2f;
+    s.pauses = 300;
+    s.flags = TestSummary::CLIPPED;
+
+    uint8_t record[TEST_RESULT_SIZE + 1];
+    record[TEST_RESULT_SIZE] = 0x5A;
+    TEST_ASSERT_EQUAL(TEST_RESULT_SIZE, encodeTestResult(s, record));
+    const uint8_t expected[TEST_RESULT_SIZE] = {
+        TEST_RESULT_VERSION,
+        0xD2, 0x04,     // 1234 compressions
+        0x7D, 0x00,     // 125 s
+        0xF5, 0x03,     // 1013 = 101.3 BPM
+        0xB9, 0x00,     // 185
+        0xF1, 0x02,     // 753
+        0xEB, 0x03,     // 1003
+        0xD5, 0x05,     // 1493, rounded half up
+        74, 98,
+        0,              // negative floors at 0
+        255,            // pauses clamp
+        TestSummary::CLIPPED,
+    };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, record, TEST_RESULT_SIZE);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, record[TEST_RESULT_SIZE]);
+
+    // percentages clamp at 100, rates at the u16 limit
+    s.in_band = 1.2f;
+    s.mean_bpm = 7000.0f;
+    encodeTestResult(s, record);
+    TEST_ASSERT_EQUAL(100, record[15]);
+    TEST_ASSERT_EQUAL(65535, record[5] | (record[6] << 8));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_no_presses);
+    RUN_TEST(test_steady_rate);
+    RUN_TEST(test_mixed_rates);
+    RUN_TEST(test_pauses_count_as_time_out_of_band);
+    RUN_TEST(test_intervals_past_the_histogram_are_clipped);
+    RUN_TEST(test_long_test);
+    RUN_TEST(test_encode_layout);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "waveform_codec.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Encodes samples at spacing ms (12 = 80 SPS) into frames of frame_size,
+// decodes every frame and checks each sample and timestamp came back. skip
+// drops that frame on the way, as a lost notification would.
+static void roundTrip(const std::vector<int32_t> &samples, size_t frame_size, int skip = -1,
+                      unsigned long spacing = 12)
+{
+    WaveformEncoder encoder(frame_size);
+    WaveformDecoder decoder;
+    uint8_t frame[WaveformEncoder::MAX_FRAME];
+    int32_t decoded[256];
+    size_t next = 0, checked = 0;
+    int frames = 0;
+
+    auto drain = [&] {
+        size_t len = encoder.flush(frame);
+        TEST_ASSERT_LESS_OR_EQUAL(frame_size, len);
+        WaveformFrame info;
+        if (frames++ == skip) {
+            next += frame[3];
+            return;
+        }
+        int got = decoder.decode(frame, len, decoded, 256, info);
+        TEST_ASSERT_GREATER_THAN(0, got);
+        TEST_ASSERT_EQUAL(next * spacing, info.t0);
+        if (got > 1) TEST_ASSERT_FLOAT_WITHIN(0.05f, spacing, info.period_ms);
+        TEST_ASSERT_EQUAL_INT32_ARRAY(&samples[next], decoded, got);
+        next += got;
+        checked += got;
+    };
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (!encoder.add(samples[i], i * spacing)) {
+            drain();
+            TEST_ASSERT_TRUE(encoder.add(samples[i], i * spacing));
+        }
+    }
+    if (encoder.count() > 0) drain();
+
+    TEST_ASSERT_EQUAL(samples.size(), next);
+    // a lost first frame can't be told from a stream that started later
+    TEST_ASSERT_EQUAL(skip > 0 && skip < frames ? 1 : 0, decoder.lost());
+    if (skip < 0) TEST_ASSERT_EQUAL(samples.size(), checked);
+}
+
+// 5 s of 105 BPM compressions at 80 SPS, 30 kg peaks and +/-20 g of noise
+static std::vector<int32_t> compressions()
+{
+    std::vector<int32_t> samples;
+    uint32_t seed = 1;
+    for (int i = 0; i < 400; i++) {
+        float phase = fmodf(i * 12.5f, 571.4f) / 571.4f;
+        float grams = phase < 0.5f ? 30000.0f * sinf(M_PI * phase / 0.5f) : 0.0f;
+        seed = seed * 1103515245UL + 12345;
+        samples.push_back(lroundf(grams) + static_cast<int32_t>((seed >> 16) % 41) - 20);
+    }
+    return samples;
+}
+
+void test_zigzag_round_trip()
+{
+    const int32_t values[] = {0, 1, -1, 63, -64, 64, -65, 1 << 20, -(1 << 20), INT32_MAX, INT32_MIN};
+    for (int32_t v : values) TEST_ASSERT_EQUAL_INT32(v, zigzagDecode(zigzagEncode(v)));
+    // small magnitudes of either sign stay small
+    TEST_ASSERT_EQUAL_UINT32(1, zigzagEncode(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, zigzagEncode(1));
+}
+
+void test_varint_round_trip()
+{
+    const uint32_t values[] = {0, 1, 127, 128, 16383, 16384, 0x1FFFFF, 0x200000, 0xFFFFFFF, 0x10000000, 0xFFFFFFFF};
+    const size_t lengths[] = {1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t buf[WAVEFORM_MAX_VARINT];
+        TEST_ASSERT_EQUAL(lengths[i], varintEncode(values[i], buf));
+        uint32_t v;
+        TEST_ASSERT_EQUAL(lengths[i], varintDecode(buf, lengths[i], v));
+        TEST_ASSERT_EQUAL_UINT32(values[i], v);
+        // cut short, it must not decode
+        TEST_ASSERT_EQUAL(0, varintDecode(buf, lengths[i] - 1, v));
+    }
+    const uint8_t over_long[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    uint32_t v;
+    TEST_ASSERT_EQUAL(0, varintDecode(over_long, sizeof(over_long), v));
+}
+
+void test_compressions_round_trip()
+{
+    std::vector<int32_t> samples = compressions();
+    const size_t frames[] = {20, 64, WaveformEncoder::MAX_FRAME};
+    for (size_t f : frames) roundTrip(samples, f);
+}
+
+void test_steps_and_extremes_round_trip()
+{
+    // full-scale steps need the longest varints; a long quiet run hits the 255-sample limit
+    std::vector<int32_t> samples;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int32_t> any(-(1 << 22), (1 << 22) - 1);
+    for (int i = 0; i < 300; i++) samples.push_back(any(rng));
+    for (int i = 0; i < 600; i++) samples.push_back(-7);
+    samples.push_back((1 << 22) - 1);
+    samples.push_back(-(1 << 22));
+    const size_t frames[] = {WAVEFORM_HEADER_SIZE + WAVEFORM_MAX_VARINT, 20, WaveformEncoder::MAX_FRAME};
+    for (size_t f : frames) roundTrip(samples, f);
+}
+
+void test_slow_rate_round_trip()
+{
+    // 10 SPS (RATE low): 100 ms apart, far past what a u8 period could carry
+    std::vector<int32_t> samples = compressions();
+    const size_t frames[] = {20, 64, WaveformEncoder::MAX_FRAME};
+    for (size_t f : frames) roundTrip(samples, f, -1, 100);
+    // the longest spacing a frame can state
+    roundTrip(samples, 64, -1, 6553);
+}
+
+void test_lost_frame_is_counted()
+{
+    // the frame after a lost one decodes on its own
+    std::vector<int32_t> samples = compressions();
+    roundTrip(samples, 20, 3);
+    roundTrip(samples, 64, 0);
+}
+
+void test_malformed_frames_are_refused()
+{
+    WaveformEncoder encoder(20);
+    for (int i = 0; i < 4; i++) encoder.add(1000 * i, i * 12);
+    uint8_t frame[WaveformEncoder::MAX_FRAME];
+    size_t len = encoder.flush(frame);
+    int32_t out[256];
+    WaveformFrame info;
+
+    WaveformDecoder decoder;
+    TEST_ASSERT_EQUAL(-1, decoder.decode(frame, WAVEFORM_HEADER_SIZE - 1, out, 256, info));
+    TEST_ASSERT_EQUAL(-1, decoder.decode(frame, len - 1, out, 256, info));
+    frame[len] = 0;
+    TEST_ASSERT_EQUAL(-1, decoder.decode(frame, len + 1, out, 256, info));
+    TEST_ASSERT_EQUAL(-1, decoder.decode(frame, len, out, 3, info));
+    frame[2] = WAVEFORM_VERSION - 1;
+    TEST_ASSERT_EQUAL(-1, decoder.decode(frame, len, out, 256, info));
+    frame[2] = WAVEFORM_VERSION;
+    TEST_ASSERT_EQUAL(0, decoder.frames());
+    TEST_ASSERT_EQUAL(4, decoder.decode(frame, len, out, 256, info));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_zigzag_round_trip);
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_compressions_round_trip);
+    RUN_TEST(test_steps_and_extremes_round_trip);
+    RUN_TEST(test_slow_rate_round_trip);
+    RUN_TEST(test_lost_frame_is_counted);
+    RUN_TEST(test_malformed_frames_are_refused);
+    return UNITY_END();
+}
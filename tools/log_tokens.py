@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Dictionary builder and decoder for the tokenized logs in debug_log.h.
+
+  log_tokens.py dict [-o log_tokens.json]
+      scan src/ and include/ for LOG_* call sites and write id -> format
+  log_tokens.py decode [--dict log_tokens.json] [capture | --port PORT]
+      turn a serial capture (a file, stdin, or a live port) back into text
+
+Without --dict, decode scans the sources itself. Plain text printed with
+Serial (setup, calibration, benchmarks) passes through unchanged.
+
+As a PlatformIO extra script it writes log_tokens.json next to the firmware
+and stops the build if two formats hash to the same id.
+"""
+
+import json
+import os
+import re
+import struct
+import sys
+
+LEVELS = {"DEBUG": 0, "INFO": 1, "WARN": 2, "ERROR": 3}
+LEVEL_NAMES = {v: k for k, v in LEVELS.items()}
+MARKER = 0x00
+
+# LOG_INFO("..." "...", ...) or logId(LOG_LEVEL_WARN, "...")
+SITE = re.compile(r'\b(?:LOG_|logId\(\s*LOG_LEVEL_)(DEBUG|INFO|WARN|ERROR)\s*[(,]\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"')
+SPEC = re.compile(r'%([-+ #.0-9lhz]*)([a-zA-Z%])')
+
+
+def log_id(level, fmt):
+    h = ((2166136261 ^ level) * 16777619) & 0xFFFFFFFF
+    for b in fmt.encode():
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return (h >> 16) ^ (h & 0xFFFF)
+
+
+def unescape(s):
+    return s.encode("latin-1", "backslashreplace").decode("unicode_escape")
+
+
+def scan(root):
+    """Returns {id: (level, format, where)}; raises on a collision."""
+    tokens = {}
+    for sub in ("src", "include"):
+        for dirpath, _, files in os.walk(os.path.join(root, sub)):
+            for name in sorted(files):
+                if not name.endswith((".cpp", ".h")):
+                    continue
+                path = os.path.join(dirpath, name)
+                with open(path, encoding="utf-8", errors="replace") as f:
+                    text = f.read()
+                for m in SITE.finditer(text):
+                    level = LEVELS[m.group(1)]
+                    fmt = "".join(unescape(s) for s in LITERAL.findall(m.group(2)))
+                    where = "%s:%d" % (os.path.relpath(path, root), text.count("\n", 0, m.start()) + 1)
+                    token = log_id(level, fmt)
+                    if token in tokens and tokens[token][:2] != (level, fmt):
+                        raise SystemExit("log id 0x%04x collides: %s and %s; reword one" %
+                                         (token, tokens[token][2], where))
+                    tokens.setdefault(token, (level, fmt, where))
+    return tokens
+
+
+def write_dict(tokens, path):
+    entries = {"%04x" % k: {"level": LEVEL_NAMES[v[0]], "format": v[1], "site": v[2]}
+               for k, v in sorted(tokens.items())}
+    with open(path, "w") as f:
+        json.dump(entries, f, indent=1)
+
+
+def load_dict(path):
+    with open(path) as f:
+        entries = json.load(f)
+    return {int(k, 16): (LEVELS[v["level"]], v["format"], v.get("site", "")) for k, v in entries.items()}
+
+
+def varint(data, at):
+    value, shift = 0, 0
+    while at < len(data):
+        b = data[at]
+        at += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, at
+    raise ValueError("varint runs past the record")
+
+
+def render(fmt, payload):
+    """Formats the record's arguments the way printf would have."""
+    args, at = [], 0
+    out_fmt = ""
+    last = 0
+    for m in SPEC.finditer(fmt):
+        flags, conv = m.group(1), m.group(2)
+        # Python's % has no length modifiers
+        out_fmt += fmt[last:m.start()] + "%" + re.sub(r"[lhz]", "", flags) + conv
+        last = m.end()
+        if conv == "%":
+            continue
+        if conv in "di":
+            v, at = varint(payload, at)
+            args.append((v >> 1) ^ -(v & 1))
+        elif conv in "uxX":
+            v, at = varint(payload, at)
+            args.append(v)
+        elif conv in "feg":
+            args.append(struct.unpack_from("<f", payload, at)[0])
+            at += 4
+        elif conv == "s":
+            n = payload[at]
+            args.append(payload[at + 1:at + 1 + n].decode("utf-8", "replace"))
+            at += 1 + n
+    return (out_fmt + fmt[last:]) % tuple(args)
+
+
+class Decoder:
+    """Feed it bytes in any split; it yields lines of text."""
+
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.ms = 0
+
+    def feed(self, data):
+        self.buf += data
+        lines = []
+        while self.buf:
+            if self.buf[0] != MARKER:
+                end = self.buf.find(MARKER)
+                end = len(self.buf) if end < 0 else end
+                self.text += self.buf[:end]
+                del self.buf[:end]
+                *done, rest = self.text.split(b"\n")
+                lines += [l.decode("utf-8", "replace").rstrip("\r") for l in done]
+                self.text = bytearray(rest)
+                continue
+            if len(self.buf) < 2 or len(self.buf) < 2 + self.buf[1]:
+                break
+            record = bytes(self.buf[2:2 + self.buf[1]])
+            del self.buf[:2 + len(record)]
+            lines.append(self.record(record))
+        return lines
+
+    def record(self, record):
+        try:
+            token = record[0] | (record[1] << 8)
+            dt, at = varint(record, 2)
+            self.ms += dt
+            if token not in self.tokens:
+                return "[%10.3f] ?     unknown id 0x%04x: %s" % (self.ms / 1000.0, token, record[at:].hex())
+            level, fmt, _ = self.tokens[token]
+            return "[%10.3f] %-5s %s" % (self.ms / 1000.0, LEVEL_NAMES[level], render(fmt, record[at:]))
+        except (ValueError, IndexError, struct.error, TypeError) as e:
+            return "[%10.3f] ?     bad record %s (%s)" % (self.ms / 1000.0, record.hex(), e)
+
+
+def decode(tokens, stream):
+    decoder = Decoder(tokens)
+    while True:
+        data = stream.read(256) if hasattr(stream, "in_waiting") else stream.read1(4096)
+        if not data:
+            if hasattr(stream, "in_waiting"):
+                continue
+            break
+        for line in decoder.feed(data):
+            print(line, flush=True)
+    if decoder.text:
+        print(decoder.text.decode("utf-8", "replace"))
+
+
+def main(argv):
+    import argparse
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    d = sub.add_parser("dict")
+    d.add_argument("-o", "--output", default="log_tokens.json")
+    r = sub.add_parser("decode")
+    r.add_argument("capture", nargs="?", help="file with the raw serial bytes (default stdin)")
+    r.add_argument("--dict", help="log_tokens.json from the build that made the capture")
+    r.add_argument("--port", help="read a live serial port instead (needs pyserial)")
+    r.add_argument("--baud", type=int, default=9600)
+    args = parser.parse_args(argv)
+
+    if args.cmd == "dict":
+        tokens = scan(root)
+        write_dict(tokens, args.output)
+        print("%d log formats -> %s" % (len(tokens), args.output))
+        return
+    tokens = load_dict(args.dict) if args.dict else scan(root)
+    if args.port:
+        import serial
+        decode(tokens, serial.Serial(args.port, args.baud, timeout=0.1))
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            decode(tokens, f)
+    else:
+        decode(tokens, sys.stdin.buffer)
+
+
+try:
+    Import("env")  # noqa: F821 - PlatformIO (SCons) extra script
+except NameError:
+    if __name__ == "__main__":
+        main(sys.argv[1:])
+else:
+    _root = env.subst("$PROJECT_DIR")  # noqa: F821
+    _out = os.path.join(env.subst("$BUILD_DIR"), "log_tokens.json")  # noqa: F821
+    os.makedirs(os.path.dirname(_out), exist_ok=True)
+    write_dict(scan(_root), _out)